@@ -15,4 +15,29 @@
 
 //#define ys_assert(expr)
 
+//
+// defer parse (isr/dma input)
+//
+
+//#define YS_DEFER_PARSE_EN
+//#define YS_DEFER_QUEUE_SIZE 2
+
+//
+// learned layout fast path (0: disable)
+//
+
+//#define YS_LAYOUT_LEARN_CNT 4
+
+//
+// sensor calibration applied during decode (ys_calib.c)
+//
+
+//#define YS_CALIB_EN
+
+//
+// usdt probes (linux, needs <sys/sdt.h>)
+//
+
+//#define YS_USDT_EN
+
 #endif // !_H_YS_CONF
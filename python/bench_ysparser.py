@@ -0,0 +1,109 @@
+"""
+Compare the ysparser extension with the pure-Python decoder in ys_ref.py.
+
+    python3 setup.py build_ext --inplace
+    python3 bench_ysparser.py [--size GiB] [--threads N] [--ref-mib MiB] [--file path]
+
+A synthetic capture of --size GiB (default 2) is written to a temporary
+file (or --file, kept for later runs) and decoded through mmap, once by
+one thread and once split into --threads parts (default: the CPU count)
+decoded by parallel threads. The pure-Python decoder is run on the first
+--ref-mib MiB (default 16) only, its throughput is extrapolated.
+"""
+
+import argparse
+import mmap
+import os
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+import ys_ref
+import ysparser
+
+CHUNK_FRAMES = 50000  # frames of the repeated chunk, about 4 MiB
+CAPACITY = 1 << 18  # rows per decode call
+
+
+def write_capture(path, size):
+    chunk = ys_ref.make_capture(CHUNK_FRAMES, seed=1, noise=0.001)
+    written = 0
+    with open(path, "wb") as f:
+        while written < size:
+            f.write(chunk)
+            written += len(chunk)
+    return len(chunk)
+
+
+def decode_range(buf, begin, end):
+    """Rows decoded from buf[begin:end], the columns of every call are dropped after it."""
+    dec = ysparser.Decoder(CAPACITY, ysparser.COL_TID | ysparser.COL_SAMPLE_TIMESTAMP | ysparser.COL_ACCEL | ysparser.COL_ANGLE)
+    view = memoryview(buf)[begin:end]
+    rows = 0
+    offset = 0
+    while offset < len(view):
+        used, cols = dec.decode(view, offset)
+        rows += len(cols["tid"])
+        offset += used
+    view.release()
+    return rows
+
+
+def report(name, size, seconds, rows):
+    print("%-24s %8.2f s %10.1f MiB/s %12d frames" % (name, seconds, size / seconds / (1 << 20), rows))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--size", type=float, default=2.0, help="capture size in GiB")
+    parser.add_argument("--threads", type=int, default=os.cpu_count() or 1)
+    parser.add_argument("--ref-mib", type=float, default=16.0, help="MiB decoded by the pure-Python decoder")
+    parser.add_argument("--file", help="capture file, created if it does not exist")
+    args = parser.parse_args()
+
+    path = args.file
+    tmp = None
+    if path is None:
+        tmp = tempfile.NamedTemporaryFile(suffix=".ys", delete=False)
+        tmp.close()
+        path = tmp.name
+
+    try:
+        if tmp is not None or not os.path.exists(path):
+            t = time.perf_counter()
+            chunk_len = write_capture(path, int(args.size * (1 << 30)))
+            print("capture %s: %.2f GiB in %.1f s" % (path, os.path.getsize(path) / (1 << 30), time.perf_counter() - t))
+        else:
+            chunk_len = len(ys_ref.make_capture(CHUNK_FRAMES, seed=1, noise=0.001))
+
+        with open(path, "rb") as f, mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mm:
+            size = len(mm)
+
+            t = time.perf_counter()
+            rows = decode_range(mm, 0, size)
+            c_time = time.perf_counter() - t
+            report("ysparser, 1 thread", size, c_time, rows)
+
+            # split at chunk boundaries, no frame is cut between two decoders
+            chunks = -(-size // chunk_len)
+            bounds = [min(size, chunk_len * (chunks * k // args.threads)) for k in range(args.threads + 1)]
+            t = time.perf_counter()
+            with ThreadPoolExecutor(args.threads) as pool:
+                parts = list(pool.map(decode_range, [mm] * args.threads, bounds[:-1], bounds[1:]))
+            report("ysparser, %d threads" % args.threads, size, time.perf_counter() - t, sum(parts))
+
+            ref_size = min(size, int(args.ref_mib * (1 << 20)))
+            ref_buf = mm[:ref_size]
+            t = time.perf_counter()
+            ref_rows = len(ys_ref.decode(ref_buf)["tid"])
+            ref_time = time.perf_counter() - t
+            report("pure Python, %.0f MiB" % (ref_size / (1 << 20)), ref_size, ref_time, ref_rows)
+
+            print("speedup   %.0fx (1 thread)" % ((ref_time / ref_size) / (c_time / size)))
+    finally:
+        if tmp is not None:
+            os.unlink(path)
+
+
+if __name__ == "__main__":
+    main()
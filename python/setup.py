@@ -0,0 +1,34 @@
+"""
+Build the ysparser CPython extension (see ysparser.c).
+
+    python3 setup.py build_ext --inplace
+    python3 test_ysparser.py
+    python3 bench_ysparser.py --size 2
+"""
+
+import os
+import sys
+
+import numpy
+from setuptools import Extension, setup
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+
+if sys.platform == "win32":
+    extra_compile_args = ["/O2"]
+else:
+    extra_compile_args = ["-std=c99", "-O2"]
+
+setup(
+    name="ysparser",
+    version="1.0",
+    description="Yesense IMU frame decoder with NumPy columns",
+    ext_modules=[
+        Extension(
+            "ysparser",
+            sources=["ysparser.c", os.path.join(ROOT, "ys_parser.c"), os.path.join(ROOT, "ys_batch.c")],
+            include_dirs=[ROOT, numpy.get_include()],
+            extra_compile_args=extra_compile_args,
+        )
+    ],
+)
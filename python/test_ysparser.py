@@ -0,0 +1,145 @@
+"""
+Check the ysparser extension against the pure-Python decoder in ys_ref.py.
+
+    python3 setup.py build_ext --inplace && python3 test_ysparser.py
+"""
+
+import mmap
+import random
+import tempfile
+import threading
+import unittest
+
+import numpy as np
+
+import ys_ref
+import ysparser
+
+REF_COLUMNS = ("tid", "sample_timestamp", "imu_temp", "accel", "angle", "euler_angle", "quaternion")
+
+
+def decode_all(buf, capacity=4096, columns=ysparser.COL_ALL):
+    """Decode the whole buffer, concatenating the columns of every call."""
+    dec = ysparser.Decoder(capacity, columns)
+    parts = []
+    offset = 0
+    while offset < len(buf):
+        used, cols = dec.decode(buf, offset)
+        parts.append(cols)
+        offset += used
+    return dec, {name: np.concatenate([p[name] for p in parts]) for name in parts[0]}
+
+
+class DecoderTest(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.capture = ys_ref.make_capture(3000, seed=7, noise=0.05)
+        cls.ref = ys_ref.decode(cls.capture)
+
+    def assert_matches_ref(self, cols, ref):
+        self.assertEqual(len(cols["tid"]), len(ref["tid"]))
+        for name in REF_COLUMNS:
+            if cols[name].dtype.kind == "f":
+                # the C decoder scales in float, the reference in double
+                np.testing.assert_allclose(cols[name], np.array(ref[name]), rtol=1e-6, atol=1e-7, err_msg=name)
+            else:
+                np.testing.assert_array_equal(cols[name], np.array(ref[name], dtype=cols[name].dtype), err_msg=name)
+
+    def test_matches_reference(self):
+        dec, cols = decode_all(self.capture)
+        self.assertGreater(len(cols["tid"]), 2800)
+        self.assert_matches_ref(cols, self.ref)
+        self.assertGreater(dec.err_frames, 0)
+        self.assertEqual(dec.dropped, 0)
+
+    def test_header_noise_after_broken_frame(self):
+        # noise full of 'YS' candidates between a broken frame and a good one,
+        # every frame the reference finds must be recovered
+        rng = random.Random(32)
+        out = bytearray()
+        for seq in range(2000):
+            frame = bytearray(ys_ref.make_frame(seq, rng))
+            if rng.random() < 0.2:
+                frame[rng.randrange(2, len(frame))] ^= 0x5A
+                out += frame
+                out += bytes(rng.choice((0x59, 0x53, rng.randrange(256))) for _ in range(rng.randint(1, 120)))
+            else:
+                out += frame
+        # closes the candidates still open at the end
+        out += bytes(ys_ref.MSG_MAX_LEN + 8)
+        capture = bytes(out)
+
+        ref = ys_ref.decode(capture)
+        self.assertGreater(len(ref["tid"]), 1500)
+
+        # a rescan near the capacity recovers its frames into the slack rows
+        for capacity in (1, 7, 4096):
+            dec, cols = decode_all(capture, capacity)
+            self.assert_matches_ref(cols, ref)
+            self.assertEqual(dec.dropped, 0)
+
+    def test_small_capacity_resumes(self):
+        # frames cut off by the end of a call are completed by the next one
+        dec, cols = decode_all(self.capture, capacity=7)
+        self.assert_matches_ref(cols, self.ref)
+
+    def test_split_buffer(self):
+        dec = ysparser.Decoder(8192)
+        cut = len(self.capture) // 2 + 3
+        _, first = dec.decode(self.capture[:cut])
+        _, second = dec.decode(self.capture[cut:])
+        tid = np.concatenate([first["tid"], second["tid"]])
+        np.testing.assert_array_equal(tid, np.array(self.ref["tid"], dtype=np.uint16))
+
+    def test_buffer_types(self):
+        expect = len(self.ref["tid"])
+        with tempfile.TemporaryFile() as f:
+            f.write(self.capture)
+            f.flush()
+            with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mm:
+                for buf in (
+                    self.capture,
+                    bytearray(self.capture),
+                    memoryview(self.capture),
+                    np.frombuffer(self.capture, dtype=np.uint8),
+                    mm,
+                ):
+                    _, cols = ysparser.Decoder(8192).decode(buf)
+                    self.assertEqual(len(cols["tid"]), expect, type(buf).__name__)
+
+    def test_offset(self):
+        _, cols = ysparser.Decoder(8192).decode(self.capture, 5)
+        self.assertEqual(len(cols["tid"]), len(self.ref["tid"]) - 1)
+        with self.assertRaises(ValueError):
+            ysparser.Decoder(8).decode(self.capture, len(self.capture) + 1)
+
+    def test_columns_share_one_block(self):
+        _, cols = ysparser.Decoder(64, ysparser.COL_ACCEL | ysparser.COL_TID).decode(self.capture)
+        self.assertEqual(sorted(cols), ["accel", "tid"])
+        self.assertEqual(cols["accel"].shape, (64, 3))
+        self.assertIs(cols["accel"].base, cols["tid"].base)
+
+    def test_missing_fields(self):
+        _, cols = ysparser.Decoder(64).decode(self.capture)
+        self.assertTrue(np.isnan(cols["mag"]).all())
+        self.assertTrue(np.isnan(cols["location"]).all())
+        self.assertFalse(cols["data_ready_timestamp"].any())
+
+    def test_threads(self):
+        # every thread decodes with its own Decoder while the others hold the GIL
+        results = [None] * 4
+
+        def work(k):
+            results[k] = decode_all(self.capture, capacity=512)[1]
+
+        threads = [threading.Thread(target=work, args=(k,)) for k in range(len(results))]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        for cols in results:
+            self.assert_matches_ref(cols, self.ref)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,138 @@
+"""
+Pure-Python YS frame encoder and decoder.
+
+The decoder is the reference the ysparser extension is tested and measured
+against: the straightforward way to parse a capture in Python, one frame
+at a time with struct. It decodes the fields of make_capture frames
+(timestamps, temperature, accel, angle, euler angle, quaternion).
+"""
+
+import random
+import struct
+
+HEADER = b"YS"
+OVERHEAD = 7  # header, tid, len, checksum
+MSG_MAX_LEN = 200
+MIN_MSG_LEN = 4
+
+ID_IMU_TEMP = 0x01
+ID_ACCEL = 0x10
+ID_ANGLE = 0x20
+ID_EULER = 0x40
+ID_QUATERNION = 0x41
+ID_SAMPLE_TIMESTAMP = 0x51
+ID_DATA_READY_TIMESTAMP = 0x52
+
+FACTOR = 0.000001
+TEMP_FACTOR = 0.01
+
+_VEC3 = struct.Struct("<3i")
+_VEC4 = struct.Struct("<4i")
+_U32 = struct.Struct("<I")
+_I16 = struct.Struct("<h")
+
+# id -> (column, struct, factor)
+_FIELDS = {
+    ID_IMU_TEMP: ("imu_temp", _I16, TEMP_FACTOR),
+    ID_ACCEL: ("accel", _VEC3, FACTOR),
+    ID_ANGLE: ("angle", _VEC3, FACTOR),
+    ID_EULER: ("euler_angle", _VEC3, FACTOR),
+    ID_QUATERNION: ("quaternion", _VEC4, FACTOR),
+    ID_SAMPLE_TIMESTAMP: ("sample_timestamp", _U32, None),
+    ID_DATA_READY_TIMESTAMP: ("data_ready_timestamp", _U32, None),
+}
+
+
+def checksum(data):
+    crc0 = crc1 = 0
+    for b in data:
+        crc0 = (crc0 + b) & 0xFF
+        crc1 = (crc1 + crc0) & 0xFF
+    return bytes((crc0, crc1))
+
+
+def encode_frame(tid, msg):
+    body = struct.pack("<HB", tid, len(msg)) + msg
+    return HEADER + body + checksum(body)
+
+
+def encode_field(data_id, payload):
+    return struct.pack("<BB", data_id, len(payload)) + payload
+
+
+def make_frame(seq, rng):
+    """A frame of the usual attitude output, the values derive from seq."""
+    msg = b"".join(
+        (
+            encode_field(ID_SAMPLE_TIMESTAMP, _U32.pack(seq * 1000 & 0xFFFFFFFF)),
+            encode_field(ID_IMU_TEMP, _I16.pack(2500 + seq % 100)),
+            encode_field(ID_ACCEL, _VEC3.pack(*(rng.randint(-20000000, 20000000) for _ in range(3)))),
+            encode_field(ID_ANGLE, _VEC3.pack(*(rng.randint(-2000000, 2000000) for _ in range(3)))),
+            encode_field(ID_EULER, _VEC3.pack(*(rng.randint(-180000000, 180000000) for _ in range(3)))),
+            encode_field(ID_QUATERNION, _VEC4.pack(*(rng.randint(-1000000, 1000000) for _ in range(4)))),
+        )
+    )
+    return encode_frame(seq & 0xFFFF, msg)
+
+
+def make_capture(frame_cnt, seed=1, noise=0.0):
+    """
+    frame_cnt frames, with probability 'noise' a frame is preceded by
+    garbage or has a corrupted checksum.
+    """
+    rng = random.Random(seed)
+    out = bytearray()
+    for seq in range(frame_cnt):
+        frame = bytearray(make_frame(seq, rng))
+        if noise and rng.random() < noise:
+            if rng.random() < 0.5:
+                out += bytes(rng.randrange(256) for _ in range(rng.randint(1, 40)))
+            else:
+                frame[-1] ^= 0x5A
+        out += frame
+    return bytes(out)
+
+
+def decode(buf):
+    """
+    Decode every frame of buf into lists of column values, a broken frame
+    is rescanned from its next byte.
+    """
+    cols = {"tid": []}
+    for name, _, _ in _FIELDS.values():
+        cols[name] = []
+
+    pos = 0
+    end = len(buf)
+    while True:
+        pos = buf.find(HEADER, pos)
+        if pos < 0 or pos + 5 > end:
+            break
+        tid, msg_len = struct.unpack_from("<HB", buf, pos + 2)
+        frame_end = pos + 5 + msg_len + 2
+        if not MIN_MSG_LEN <= msg_len < MSG_MAX_LEN or frame_end > end:
+            pos += 1
+            continue
+        if checksum(buf[pos + 2 : frame_end - 2]) != buf[frame_end - 2 : frame_end]:
+            pos += 1
+            continue
+
+        row = dict.fromkeys(cols)
+        row["tid"] = tid
+        off = pos + 5
+        while off + 2 <= frame_end - 2:
+            data_id, data_len = buf[off], buf[off + 1]
+            field = _FIELDS.get(data_id)
+            if field is not None:
+                name, fmt, factor = field
+                values = fmt.unpack_from(buf, off + 2)
+                if factor is not None:
+                    values = [v * factor for v in values]
+                row[name] = values if len(values) > 1 else values[0]
+            off += 2 + data_len
+
+        for name, value in row.items():
+            cols[name].append(value)
+        pos = frame_end
+
+    return cols
@@ -0,0 +1,341 @@
+/**
+ * CPython extension over ys_batch: decode a YS capture into NumPy columns.
+ *
+ * Build: python3 setup.py build_ext --inplace
+ *
+ * Usage:
+ *
+ *   import ysparser
+ *   dec = ysparser.Decoder(capacity=65536, columns=ysparser.COL_ALL)
+ *   used, cols = dec.decode(buf)           # buf: bytes, mmap, numpy array, ...
+ *   cols["accel"]                          # float32, shape (rows, 3)
+ *
+ * The columns of one decode call are views of one block allocated for that
+ * call, no Python object is created per frame. The GIL is released while
+ * decoding, different Decoder objects may decode in parallel threads.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <structmember.h>
+
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ys_batch.h>
+
+//-------------------------- type define  -----------------------------------
+
+typedef struct
+{
+    const char *name;       /* key in the columns dict */
+    const char *const_name; /* module constant of the column */
+    uint32_t column;        /* ys_batch_column_t */
+    int type_num;           /* numpy element type */
+    uint8_t elem_size;
+    uint8_t comp_cnt;
+    uint16_t offset;        /* offset of the column pointer (array) in ys_batch_t */
+} py_column_t;
+
+static const py_column_t py_columns[] = {
+    {"tid", "COL_TID", YS_BATCH_COL_TID, NPY_UINT16, sizeof(uint16_t), 1, offsetof(ys_batch_t, tid)},
+    {"sample_timestamp", "COL_SAMPLE_TIMESTAMP", YS_BATCH_COL_SAMPLE_TIMESTAMP, NPY_UINT32, sizeof(uint32_t), 1, offsetof(ys_batch_t, sample_timestamp)},
+    {"data_ready_timestamp", "COL_DATA_READY_TIMESTAMP", YS_BATCH_COL_DATA_READY_TIMESTAMP, NPY_UINT32, sizeof(uint32_t), 1, offsetof(ys_batch_t, data_ready_timestamp)},
+    {"imu_temp", "COL_IMU_TEMP", YS_BATCH_COL_IMU_TEMP, NPY_FLOAT32, sizeof(float), 1, offsetof(ys_batch_t, imu_temp)},
+    {"accel", "COL_ACCEL", YS_BATCH_COL_ACCEL, NPY_FLOAT32, sizeof(float), 3, offsetof(ys_batch_t, accel)},
+    {"angle", "COL_ANGLE", YS_BATCH_COL_ANGLE, NPY_FLOAT32, sizeof(float), 3, offsetof(ys_batch_t, angle)},
+    {"mag", "COL_MAG", YS_BATCH_COL_MAG, NPY_FLOAT32, sizeof(float), 3, offsetof(ys_batch_t, mag)},
+    {"raw_mag", "COL_RAW_MAG", YS_BATCH_COL_RAW_MAG, NPY_FLOAT32, sizeof(float), 3, offsetof(ys_batch_t, raw_mag)},
+    {"euler_angle", "COL_EULER", YS_BATCH_COL_EULER, NPY_FLOAT32, sizeof(float), 3, offsetof(ys_batch_t, euler_angle)},
+    {"quaternion", "COL_QUATERNION", YS_BATCH_COL_QUATERNION, NPY_FLOAT32, sizeof(float), 4, offsetof(ys_batch_t, quaternion)},
+    {"quaternion_inc", "COL_QUATERNION_INC", YS_BATCH_COL_QUATERNION_INC, NPY_FLOAT32, sizeof(float), 4, offsetof(ys_batch_t, quaternion_inc)},
+    {"location", "COL_LOCATION", YS_BATCH_COL_LOCATION, NPY_FLOAT64, sizeof(double), 3, offsetof(ys_batch_t, location)},
+    {"velocity", "COL_VELOCITY", YS_BATCH_COL_VELOCITY, NPY_FLOAT32, sizeof(float), 3, offsetof(ys_batch_t, velocity)},
+    {"speed_inc", "COL_SPEED_INC", YS_BATCH_COL_SPEED_INC, NPY_FLOAT32, sizeof(float), 3, offsetof(ys_batch_t, speed_inc)},
+    {"second_imu_temp", "COL_SECOND_IMU_TEMP", YS_BATCH_COL_SECOND_IMU_TEMP, NPY_FLOAT32, sizeof(float), 1, offsetof(ys_batch_t, second_imu_temp)},
+    {"second_accel", "COL_SECOND_ACCEL", YS_BATCH_COL_SECOND_ACCEL, NPY_FLOAT32, sizeof(float), 3, offsetof(ys_batch_t, second_accel)},
+    {"second_angle", "COL_SECOND_ANGLE", YS_BATCH_COL_SECOND_ANGLE, NPY_FLOAT32, sizeof(float), 3, offsetof(ys_batch_t, second_angle)},
+};
+
+#define PY_COLUMN_NUM (sizeof(py_columns) / sizeof(py_columns[0]))
+
+typedef struct
+{
+    PyObject_HEAD
+    ys_batch_t batch;
+    size_t block_size;
+    int busy; /* a decode call has released the GIL */
+} decoder_object_t;
+
+//-------------------------- internal func ----------------------------------
+
+static int decoder_init(decoder_object_t *self, PyObject *args, PyObject *kwds);
+
+static PyObject *decoder_decode(decoder_object_t *self, PyObject *args, PyObject *kwds);
+
+static PyObject *decoder_get_dropped(decoder_object_t *self, void *closure);
+
+static PyObject *decoder_get_err_frames(decoder_object_t *self, void *closure);
+
+static PyObject *alloc_block(size_t size, uint8_t **aligned);
+
+static PyObject *make_columns(ys_batch_t *batch, PyObject *block);
+
+//---------------------------------------------------------------------------
+
+static PyMethodDef decoder_methods[] = {
+    {"decode", (PyCFunction)(void (*)(void))decoder_decode, METH_VARARGS | METH_KEYWORDS,
+     "decode(buf, offset=0) -> (used, columns)\n\n"
+     "Decode buf[offset:] until its end or until capacity rows are decoded,\n"
+     "a few more when one broken frame hides several good ones.\n"
+     "used is the number of bytes consumed, less than len(buf) - offset when\n"
+     "the capacity is reached: call again from offset + used. columns maps\n"
+     "the column names to arrays of the decoded rows, all of them views of\n"
+     "one block. A frame cut off at the end of buf is completed by the next\n"
+     "call. Fields missing in a frame are NaN (float) or 0 (integer)."},
+    {NULL, NULL, 0, NULL},
+};
+
+static PyMemberDef decoder_members[] = {
+    {"capacity", T_UINT, offsetof(decoder_object_t, batch.capacity), READONLY, "rows per decode call"},
+    {"columns", T_UINT, offsetof(decoder_object_t, batch.columns), READONLY, "selected columns, COL_xxx"},
+    {NULL, 0, 0, 0, NULL},
+};
+
+static PyGetSetDef decoder_getset[] = {
+    {"dropped", (getter)decoder_get_dropped, NULL, "frames dropped beyond the slack rows of the capacity, always 0", NULL},
+    {"err_frames", (getter)decoder_get_err_frames, NULL, "frames with a checksum or length error", NULL},
+    {NULL, NULL, NULL, NULL, NULL},
+};
+
+static PyTypeObject decoder_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name      = "ysparser.Decoder",
+    .tp_doc       = "Decoder(capacity=65536, columns=COL_ALL)\n\n"
+                    "Columnar YS frame decoder. Each object keeps its own parser state,\n"
+                    "a decode call of one object may run in parallel with the others.",
+    .tp_basicsize = sizeof(decoder_object_t),
+    .tp_flags     = Py_TPFLAGS_DEFAULT,
+    .tp_new       = PyType_GenericNew,
+    .tp_init      = (initproc)decoder_init,
+    .tp_methods   = decoder_methods,
+    .tp_members   = decoder_members,
+    .tp_getset    = decoder_getset,
+};
+
+static struct PyModuleDef ysparser_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "ysparser",
+    .m_doc  = "Yesense IMU frame decoder, see Decoder.",
+    .m_size = -1,
+};
+
+PyMODINIT_FUNC PyInit_ysparser(void)
+{
+    import_array();
+
+    if (PyType_Ready(&decoder_type) < 0)
+        return NULL;
+
+    PyObject *module = PyModule_Create(&ysparser_module);
+
+    if (module == NULL)
+        return NULL;
+
+    Py_INCREF(&decoder_type);
+
+    if (PyModule_AddObject(module, "Decoder", (PyObject *)&decoder_type) < 0)
+    {
+        Py_DECREF(&decoder_type);
+        Py_DECREF(module);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < PY_COLUMN_NUM; i++)
+    {
+        if (PyModule_AddIntConstant(module, py_columns[i].const_name, (long)py_columns[i].column) < 0)
+        {
+            Py_DECREF(module);
+            return NULL;
+        }
+    }
+
+    if (PyModule_AddIntConstant(module, "COL_ALL", YS_BATCH_COL_ALL) < 0)
+    {
+        Py_DECREF(module);
+        return NULL;
+    }
+
+    return module;
+}
+
+//-------------------------- internal func ----------------------------------
+
+static int decoder_init(decoder_object_t *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"capacity", "columns", NULL};
+    unsigned long capacity = 65536;
+    unsigned long columns  = YS_BATCH_COL_ALL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|kk", kwlist, &capacity, &columns))
+        return -1;
+
+    if (capacity == 0 || capacity > UINT32_MAX / sizeof(double) - YS_BATCH_SLACK)
+    {
+        PyErr_SetString(PyExc_ValueError, "capacity out of range");
+        return -1;
+    }
+
+    if (self->busy)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "Decoder is decoding in another thread");
+        return -1;
+    }
+
+    /* the columns are bound to a new block by every decode call */
+    ys_batch_init(&self->batch, NULL, (uint32_t)capacity, (uint32_t)columns);
+    self->block_size = ys_batch_block_size((uint32_t)capacity, self->batch.columns);
+
+    return 0;
+}
+
+static PyObject *decoder_decode(decoder_object_t *self, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"buf", "offset", NULL};
+    Py_buffer view;
+    Py_ssize_t offset = 0;
+    uint8_t *block_data;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "y*|n", kwlist, &view, &offset))
+        return NULL;
+
+    if (self->batch.capacity == 0)
+    {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_RuntimeError, "Decoder is not initialized");
+        return NULL;
+    }
+
+    if (offset < 0 || offset > view.len)
+    {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, "offset out of range");
+        return NULL;
+    }
+
+    /* ys_batch_t holds the parser state, it must not be shared by two running decodes */
+    if (self->busy)
+    {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_RuntimeError, "Decoder is decoding in another thread");
+        return NULL;
+    }
+
+    PyObject *block = alloc_block(self->block_size, &block_data);
+
+    if (block == NULL)
+    {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    size_t used;
+
+    self->busy = 1;
+    ys_batch_bind(&self->batch, block_data);
+
+    Py_BEGIN_ALLOW_THREADS
+    used = ys_batch_decode(&self->batch, (const uint8_t *)view.buf + offset, (size_t)(view.len - offset));
+    Py_END_ALLOW_THREADS
+
+    self->busy = 0;
+    PyBuffer_Release(&view);
+
+    PyObject *columns = make_columns(&self->batch, block);
+
+    Py_DECREF(block);
+
+    if (columns == NULL)
+        return NULL;
+
+    return Py_BuildValue("(nN)", (Py_ssize_t)used, columns);
+}
+
+static PyObject *decoder_get_dropped(decoder_object_t *self, void *closure)
+{
+    (void)closure;
+    return PyLong_FromUnsignedLong(self->batch.drop_cnt);
+}
+
+static PyObject *decoder_get_err_frames(decoder_object_t *self, void *closure)
+{
+    (void)closure;
+    return PyLong_FromUnsignedLong(self->batch.parser.trace_inf.err_frame_cnt);
+}
+
+/* uint8 array with YS_BATCH_ALIGN bytes of slack, '*aligned' is its first aligned byte */
+static PyObject *alloc_block(size_t size, uint8_t **aligned)
+{
+    npy_intp dim = (npy_intp)(size + YS_BATCH_ALIGN);
+    PyObject *block = PyArray_SimpleNew(1, &dim, NPY_UINT8);
+
+    if (block == NULL)
+        return NULL;
+
+    uintptr_t addr = (uintptr_t)PyArray_DATA((PyArrayObject *)block);
+
+    *aligned = (uint8_t *)((addr + YS_BATCH_ALIGN - 1) / YS_BATCH_ALIGN * YS_BATCH_ALIGN);
+
+    return block;
+}
+
+/* views of the decoded rows: shape (rows,) or (rows, comp_cnt), the components are columns of the block */
+static PyObject *make_columns(ys_batch_t *batch, PyObject *block)
+{
+    PyObject *columns = PyDict_New();
+
+    if (columns == NULL)
+        return NULL;
+
+    for (size_t i = 0; i < PY_COLUMN_NUM; i++)
+    {
+        const py_column_t *col = &py_columns[i];
+
+        if ((batch->columns & col->column) == 0)
+            continue;
+
+        void **col_ptr        = (void **)((uint8_t *)batch + col->offset);
+        PyArray_Descr *descr  = PyArray_DescrFromType(col->type_num);
+        npy_intp dims[2]      = {(npy_intp)batch->row_cnt, col->comp_cnt};
+        npy_intp strides[2]   = {col->elem_size, 0};
+
+        if (col->comp_cnt > 1)
+            strides[1] = (npy_intp)((uint8_t *)col_ptr[1] - (uint8_t *)col_ptr[0]);
+
+        /* steals the reference to descr */
+        PyObject *array = PyArray_NewFromDescr(&PyArray_Type, descr, col->comp_cnt > 1 ? 2 : 1, dims, strides,
+                                               col_ptr[0], NPY_ARRAY_ALIGNED | NPY_ARRAY_WRITEABLE, NULL);
+
+        if (array == NULL)
+        {
+            Py_DECREF(columns);
+            return NULL;
+        }
+
+        Py_INCREF(block);
+
+        if (PyArray_SetBaseObject((PyArrayObject *)array, block) < 0 ||
+            PyDict_SetItemString(columns, col->name, array) < 0)
+        {
+            Py_DECREF(array);
+            Py_DECREF(columns);
+            return NULL;
+        }
+
+        Py_DECREF(array);
+    }
+
+    return columns;
+}
@@ -0,0 +1,372 @@
+/**
+ * Allan deviation and noise parameters of static recordings.
+ *
+ * Every capture (one sensor each) is analysed in a single streaming pass, the
+ * files are read in chunks and never held in memory. A reader thread per
+ * capture parses it once and hands blocks of samples to the worker threads.
+ * With -j the tau sequence is split into ranges of about equal work, one
+ * worker per range, and their curves are joined. The six axes are one
+ * vectorized row of every update, splitting them would not save any work.
+ *
+ * Build: cc -O3 -march=native -pthread -I.. ys_allan.c ../ys_allan.c ../ys_parser.c -o ys_allan -lm
+ *
+ * Usage: ys_allan [-r rate] [-t tau_max] [-p points_per_decade] [-j threads] [-c] <capture>...
+ *   -r rate   sample rate in Hz (default 400)
+ *   -t sec    longest cluster time (default 10000)
+ *   -p num    taus per decade (default 10)
+ *   -j num    threads per capture, each computes a range of taus (default 1)
+ *   -c        print the deviation curve of every capture
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <ys_allan.h>
+
+#define READ_CHUNK (1 << 20)
+#define FEED_ROWS  4096 /* samples of a block handed to the workers */
+#define FEED_CNT   8    /* blocks in flight */
+
+typedef struct capture capture_t;
+
+/* one range of taus of one capture */
+typedef struct
+{
+    capture_t *capture;
+    ys_allan_t *allan;
+    uint64_t consumed; /* blocks done, under capture->lock */
+    pthread_t thread;
+} job_t;
+
+/* a reader thread parses the capture once into sample blocks, every job computes its taus from the same blocks */
+struct capture
+{
+    const char *path;
+    job_t *jobs;
+    int parts;
+    int failed;
+    ys_parser_t parser;
+
+    float (*rows)[YS_ALLAN_CH]; /* FEED_CNT * FEED_ROWS, NaN rows for frames without angle or accel */
+    uint32_t row_cnt[FEED_CNT];
+    uint32_t fill;     /* rows of the block being filled, reader only */
+    uint64_t produced; /* blocks published */
+    int done;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+};
+
+static const char *ch_name[YS_ALLAN_CH] = {"gyro_x", "gyro_y", "gyro_z", "acc_x", "acc_y", "acc_z"};
+
+/*
+ * split the tau sequence into at most 'parts' ranges, bounds[0 .. parts].
+ * a tau of level l is updated every 2^l samples, that is its cost per sample
+ */
+static int split_taus(const ys_allan_config_t *config, int parts, uint16_t *bounds)
+{
+    ys_allan_t *all = ys_allan_create(config);
+    double total    = 0.0;
+    double acc      = 0.0;
+    int cnt         = 1;
+
+    if (all == NULL)
+        return 0;
+
+    for (uint16_t i = 0; i < all->tau_cnt; i++)
+        total += 1.0 / (double)(1ull << all->taus[i].level);
+
+    bounds[0] = 0;
+
+    for (uint16_t i = 0; i < all->tau_cnt && cnt < parts; i++)
+    {
+        acc += 1.0 / (double)(1ull << all->taus[i].level);
+
+        if (acc >= total * cnt / parts)
+            bounds[cnt++] = (uint16_t)(i + 1);
+    }
+
+    if (bounds[cnt - 1] == all->tau_cnt)
+        cnt--; /* the last range would be empty */
+
+    bounds[cnt] = all->tau_cnt;
+
+    ys_allan_free(all);
+
+    return cnt;
+}
+
+/* hand the filled block to the jobs, then wait until the next one is free */
+static void publish(capture_t *cap)
+{
+    pthread_mutex_lock(&cap->lock);
+
+    cap->row_cnt[cap->produced % FEED_CNT] = cap->fill;
+    cap->produced++;
+    pthread_cond_broadcast(&cap->cond);
+
+    for (int k = 0; k < cap->parts; k++)
+    {
+        while (cap->produced - cap->jobs[k].consumed >= FEED_CNT)
+            pthread_cond_wait(&cap->cond, &cap->lock);
+    }
+
+    pthread_mutex_unlock(&cap->lock);
+
+    cap->fill = 0;
+}
+
+static void on_frame(ys_result_callback_params_t *params)
+{
+    capture_t *cap = (capture_t *)params->user_data;
+    float *row     = cap->rows[(cap->produced % FEED_CNT) * FEED_ROWS + cap->fill];
+    uint8_t found  = 0;
+
+    for (uint8_t i = 0; i < params->field_cnt; i++)
+    {
+        if (params->field_li[i] == YS_ID_ANGLE)
+            found |= 1;
+        else if (params->field_li[i] == YS_ID_ACCEL)
+            found |= 2;
+    }
+
+    /* ys_allan_add counts a NaN row as skipped, like ys_allan_parse does */
+    for (uint8_t k = 0; k < 3; k++)
+    {
+        row[YS_ALLAN_ANGLE_X + k] = found == 3 ? params->result->angle[k] : NAN;
+        row[YS_ALLAN_ACCEL_X + k] = found == 3 ? params->result->accel[k] : NAN;
+    }
+
+    if (++cap->fill == FEED_ROWS)
+        publish(cap);
+}
+
+static void *reader_main(void *arg)
+{
+    capture_t *cap = (capture_t *)arg;
+    FILE *in       = fopen(cap->path, "rb");
+    uint8_t *buf   = malloc(READ_CHUNK);
+    size_t n;
+
+    if (in == NULL || buf == NULL)
+    {
+        cap->failed = 1;
+    }
+    else
+    {
+        while ((n = fread(buf, 1, READ_CHUNK, in)) > 0)
+            ys_parse_buf_ex(&cap->parser, buf, n, 0, NULL);
+
+        if (cap->fill > 0)
+            publish(cap);
+    }
+
+    pthread_mutex_lock(&cap->lock);
+    cap->done = 1;
+    pthread_cond_broadcast(&cap->cond);
+    pthread_mutex_unlock(&cap->lock);
+
+    if (in != NULL)
+        fclose(in);
+    free(buf);
+    return NULL;
+}
+
+static void *job_main(void *arg)
+{
+    job_t *job     = (job_t *)arg;
+    capture_t *cap = job->capture;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&cap->lock);
+
+        while (job->consumed == cap->produced && !cap->done)
+            pthread_cond_wait(&cap->cond, &cap->lock);
+
+        if (job->consumed == cap->produced)
+        {
+            pthread_mutex_unlock(&cap->lock);
+            break;
+        }
+
+        uint32_t slot = (uint32_t)(job->consumed % FEED_CNT);
+        uint32_t cnt  = cap->row_cnt[slot];
+
+        pthread_mutex_unlock(&cap->lock);
+
+        /* the reader does not touch a block until every job has consumed it */
+        for (uint32_t i = 0; i < cnt; i++)
+            ys_allan_add(job->allan, cap->rows[slot * FEED_ROWS + i]);
+
+        pthread_mutex_lock(&cap->lock);
+        job->consumed++;
+        pthread_cond_broadcast(&cap->cond);
+        pthread_mutex_unlock(&cap->lock);
+    }
+
+    return NULL;
+}
+
+/* join the curves of the jobs, their tau ranges are in ascending order */
+static void print_capture(const capture_t *cap, int curve)
+{
+    ys_allan_point_t points[YS_ALLAN_MAX_TAUS];
+    ys_allan_noise_t noise[YS_ALLAN_CH];
+    const ys_allan_t *first = cap->jobs[0].allan;
+    uint16_t cnt            = 0;
+
+    for (int k = 0; k < cap->parts; k++)
+        cnt += ys_allan_result(cap->jobs[k].allan, &points[cnt], (uint16_t)(YS_ALLAN_MAX_TAUS - cnt));
+
+    printf("%s: %llu samples, %llu skipped\n", cap->path,
+           (unsigned long long)first->sample_cnt, (unsigned long long)first->skip_cnt);
+
+    if (curve)
+    {
+        printf("%12s %10s", "TAU", "CLUSTERS");
+        for (int ch = 0; ch < YS_ALLAN_CH; ch++)
+            printf(" %12s", ch_name[ch]);
+        printf("\n");
+
+        for (uint16_t i = 0; i < cnt; i++)
+        {
+            printf("%12.4f %10llu", points[i].tau, (unsigned long long)points[i].cnt);
+            for (int ch = 0; ch < YS_ALLAN_CH; ch++)
+                printf(" %12.4e", points[i].adev[ch]);
+            printf("\n");
+        }
+    }
+
+    ys_allan_noise_points(points, cnt, noise);
+
+    /* gyro in deg/s, accel in m/s^2 */
+    for (int ch = 0; ch < YS_ALLAN_CH; ch++)
+    {
+        if (ch < YS_ALLAN_ACCEL_X)
+            printf("  %-7s ARW %10.4e deg/sqrt(h)  BI %10.4e deg/h    @ %.1f s\n", ch_name[ch],
+                   noise[ch].random_walk * 60.0, noise[ch].bias_instability * 3600.0, noise[ch].bias_tau);
+        else
+            printf("  %-7s VRW %10.4e m/s/sqrt(h)  BI %10.4e m/s^2  @ %.1f s\n", ch_name[ch],
+                   noise[ch].random_walk * 60.0, noise[ch].bias_instability, noise[ch].bias_tau);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ys_allan_config_t config = {.rate = 400.0, .tau_max = 10000.0, .points_per_decade = 10};
+    int curve                = 0;
+    int threads              = 1;
+    int argi                 = 1;
+
+    for (; argi < argc && argv[argi][0] == '-'; argi++)
+    {
+        if (strcmp(argv[argi], "-c") == 0)
+            curve = 1;
+        else if (strcmp(argv[argi], "-r") == 0 && argi + 1 < argc)
+            config.rate = atof(argv[++argi]);
+        else if (strcmp(argv[argi], "-t") == 0 && argi + 1 < argc)
+            config.tau_max = atof(argv[++argi]);
+        else if (strcmp(argv[argi], "-p") == 0 && argi + 1 < argc)
+            config.points_per_decade = (uint16_t)atoi(argv[++argi]);
+        else if (strcmp(argv[argi], "-j") == 0 && argi + 1 < argc)
+            threads = atoi(argv[++argi]);
+        else
+            argi = argc; /* force usage */
+    }
+
+    if (argi >= argc || threads < 1 || threads > YS_ALLAN_MAX_TAUS)
+    {
+        fprintf(stderr, "usage: %s [-r rate] [-t tau_max] [-p points_per_decade] [-j threads] [-c] <capture>...\n", argv[0]);
+        return 2;
+    }
+
+    uint16_t bounds[YS_ALLAN_MAX_TAUS + 1];
+    int parts = split_taus(&config, threads, bounds);
+
+    if (parts == 0)
+    {
+        fprintf(stderr, "invalid tau range\n");
+        return 2;
+    }
+
+    int capture_cnt = argc - argi;
+    capture_t *caps = calloc((size_t)capture_cnt, sizeof(capture_t));
+    job_t *jobs     = calloc((size_t)capture_cnt * parts, sizeof(job_t));
+    float(*rows)[YS_ALLAN_CH] = malloc((size_t)capture_cnt * FEED_CNT * FEED_ROWS * sizeof(*rows));
+
+    if (caps == NULL || jobs == NULL || rows == NULL)
+        return 1;
+
+    for (int i = 0; i < capture_cnt; i++)
+    {
+        capture_t *cap = &caps[i];
+
+        cap->path  = argv[argi + i];
+        cap->jobs  = &jobs[i * parts];
+        cap->parts = parts;
+        cap->rows  = &rows[(size_t)i * FEED_CNT * FEED_ROWS];
+
+        ys_parser_create_static(&cap->parser, on_frame);
+        ys_parser_set_user_data(&cap->parser, cap);
+        pthread_mutex_init(&cap->lock, NULL);
+        pthread_cond_init(&cap->cond, NULL);
+
+        for (int k = 0; k < parts; k++)
+        {
+            ys_allan_config_t part = config;
+
+            part.tau_begin = bounds[k];
+            part.tau_end   = bounds[k + 1];
+
+            cap->jobs[k].capture = cap;
+            cap->jobs[k].allan   = ys_allan_create(&part);
+
+            if (cap->jobs[k].allan == NULL)
+                return 1;
+        }
+
+        pthread_create(&cap->thread, NULL, reader_main, cap);
+
+        for (int k = 0; k < parts; k++)
+            pthread_create(&cap->jobs[k].thread, NULL, job_main, &cap->jobs[k]);
+    }
+
+    int failed = 0;
+
+    for (int i = 0; i < capture_cnt; i++)
+    {
+        capture_t *cap = &caps[i];
+
+        pthread_join(cap->thread, NULL);
+
+        for (int k = 0; k < parts; k++)
+            pthread_join(cap->jobs[k].thread, NULL);
+
+        if (cap->failed)
+        {
+            fprintf(stderr, "%s: failed\n", cap->path);
+            failed = 1;
+        }
+        else
+        {
+            print_capture(cap, curve);
+        }
+
+        for (int k = 0; k < parts; k++)
+            ys_allan_free(cap->jobs[k].allan);
+
+        pthread_mutex_destroy(&cap->lock);
+        pthread_cond_destroy(&cap->cond);
+    }
+
+    free(rows);
+    free(jobs);
+    free(caps);
+
+    return failed;
+}
@@ -0,0 +1,377 @@
+/**
+ * Linux simulation of deferred parsing: an "isr" thread feeds DMA half-buffer
+ * chunks through ys_parser_input_chunk while a consumer thread drains the
+ * queue with ys_parser_poll, as a low priority task would on the target.
+ *
+ * Every frame carries a 32 bit sequence number and its complement, and an
+ * accel vector derived from it. The consumer checks each delivered frame
+ * against its sequence number and checks that the sequence only increases,
+ * so a frame read before the producer finished writing it is reported.
+ * Build with -fsanitize=thread to also let tsan check the queue ordering.
+ *
+ * With -a every frame is preceded by a broken frame whose message is "YS"
+ * repeated: every other byte starts a candidate header with a valid length,
+ * the worst case for the rescan of broken frames.
+ *
+ * The duration of every ys_parser_input_chunk call is recorded, and the
+ * worst case is reported together with the p99.9 and the bytes per call.
+ * The measured time includes scheduler noise of a non real-time thread, pin
+ * the process with taskset / chrt to get numbers closer to the hardware bound.
+ *
+ * Build: cc -O2 -pthread -DYS_DEFER_PARSE_EN -DYS_DEFER_QUEUE_SIZE=8 -I.. ys_defer_sim.c ../ys_parser.c ../ys_cmd.c -o ys_defer_sim
+ *
+ * Usage: ys_defer_sim [options]
+ *   -n num      frames to send (default 20000)
+ *   -c bytes    dma half-buffer size (default 32)
+ *   -w bytes    work budget per ys_parser_input_chunk call, 0: whole chunk (default 0)
+ *   -p prob     probability of a corrupted frame or garbage before a frame (default 0.01)
+ *   -b baud     pace the producer like a uart of this baud rate, 0: as fast as possible (default 4000000)
+ *   -a          precede every frame with an adversarial broken frame
+ *
+ * Exit status is 0 when every frame is accounted for and all delivered frames are intact.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <ys_parser.h>
+#include <ys_cmd.h>
+
+#ifndef YS_HAS_DEFER_PARSE
+#error "build with -DYS_DEFER_PARSE_EN"
+#endif
+
+#define ACCEL_LEN 12
+#define MSG_LEN   (2 + ACCEL_LEN + 2 + 4 + 2 + 4)
+
+typedef struct
+{
+    uint32_t frame_num;
+    uint32_t chunk;
+    uint32_t budget;
+    double noise_prob;
+    uint32_t baud;
+    int adversarial;
+} sim_config_t;
+
+typedef struct
+{
+    uint8_t *data;
+    size_t len;
+    uint32_t sent;    /* frames in the stream */
+    uint32_t broken;  /* frames corrupted on purpose */
+} sim_stream_t;
+
+static sim_config_t g_cfg = {
+    .frame_num  = 20000,
+    .chunk      = 32,
+    .noise_prob = 0.01,
+    .baud       = 4000000,
+};
+
+static ys_parser_t g_parser;
+static sim_stream_t g_stream;
+static int g_producer_done;
+
+/* consumer results */
+static uint32_t g_recv_cnt;
+static uint32_t g_bad_cnt;
+static uint32_t g_spurious_cnt;
+static uint32_t g_order_cnt;
+static int64_t g_last_seq = -1;
+
+/* producer results */
+static uint32_t *g_call_ns;
+static uint32_t g_call_cnt;
+static uint32_t g_call_max_bytes;
+
+//---------------------------------------------------------------------------
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t t_ns)
+{
+    struct timespec ts = {
+        .tv_sec  = (time_t)(t_ns / 1000000000ULL),
+        .tv_nsec = (long)(t_ns % 1000000000ULL),
+    };
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static int32_t accel_raw(uint32_t seq, int k)
+{
+    return (int32_t)(seq % 100000u) * 10 + k;
+}
+
+static uint16_t build_frame(uint8_t *buf, uint32_t seq)
+{
+    uint8_t msg[MSG_LEN];
+    uint8_t *p = msg;
+
+    *p++ = YS_ID_ACCEL;
+    *p++ = ACCEL_LEN;
+    for (int k = 0; k < 3; k++, p += 4)
+        put_u32(p, (uint32_t)accel_raw(seq, k));
+
+    *p++ = YS_ID_SAMPLE_TIMESTAMP;
+    *p++ = 4;
+    put_u32(p, seq);
+    p += 4;
+
+    *p++ = YS_ID_DATA_READY_TIMESTAMP;
+    *p++ = 4;
+    put_u32(p, ~seq);
+
+    return ys_frame_encode(buf, YS_MSG_MAX_LEN + YS_FRAME_OVERHEAD, (uint16_t)seq, msg, MSG_LEN);
+}
+
+static size_t build_garbage(uint8_t *buf, unsigned int *seed)
+{
+    size_t n = 1 + (size_t)(rand_r(seed) % 24);
+
+    for (size_t i = 0; i < n; i++)
+        buf[i] = (uint8_t)rand_r(seed);
+
+    return n;
+}
+
+/* a broken frame full of candidate headers: 'Y' 'S' tid tid len, with len = 'Y' */
+static size_t build_adversarial(uint8_t *buf)
+{
+    uint8_t msg[YS_MSG_MAX_LEN - 1];
+
+    for (size_t i = 0; i < sizeof(msg); i++)
+        msg[i] = (i & 1) ? 'S' : 'Y';
+
+    uint16_t n = ys_frame_encode(buf, YS_MSG_MAX_LEN + YS_FRAME_OVERHEAD, 0x5359, msg, sizeof(msg));
+
+    buf[n - 1] ^= 0x5A;
+
+    return n;
+}
+
+static int build_stream(sim_stream_t *st)
+{
+    unsigned int seed = 12345;
+    size_t cap        = (size_t)g_cfg.frame_num * (MSG_LEN + YS_FRAME_OVERHEAD + 128 + YS_MSG_MAX_LEN + YS_FRAME_OVERHEAD) + 1024;
+    uint8_t frame[YS_MSG_MAX_LEN + YS_FRAME_OVERHEAD];
+
+    st->data = malloc(cap);
+
+    if (st->data == NULL)
+        return -1;
+
+    for (uint32_t seq = 0; seq < g_cfg.frame_num; seq++)
+    {
+        uint16_t n = build_frame(frame, seq);
+        int noise  = g_cfg.noise_prob > 0 && (double)rand_r(&seed) / RAND_MAX < g_cfg.noise_prob;
+
+        if (g_cfg.adversarial)
+            st->len += build_adversarial(&st->data[st->len]);
+
+        if (noise && (rand_r(&seed) & 1))
+        {
+            /* flip a message byte, the checksum fails and the frame is lost */
+            frame[5 + rand_r(&seed) % MSG_LEN] ^= 0x5A;
+            st->broken++;
+        }
+        else if (noise)
+        {
+            st->len += build_garbage(&st->data[st->len], &seed);
+        }
+
+        memcpy(&st->data[st->len], frame, n);
+        st->len += n;
+        st->sent++;
+    }
+
+    return 0;
+}
+
+static void on_frame(ys_result_callback_params_t *params)
+{
+    const ys_sensor_data_t *d = params->result;
+    uint32_t seq              = d->sample_timestamp;
+    int ok                    = d->data_ready_timestamp == ~seq && params->tid == (uint16_t)seq;
+
+    /*
+     * the 16 bit checksum lets about one in 65536 random candidates through, the
+     * adversarial stream has enough of them to produce a few garbage frames
+     */
+    if (!ok && g_cfg.adversarial)
+    {
+        g_spurious_cnt++;
+        return;
+    }
+
+    for (int k = 0; k < 3 && ok; k++)
+        ok = d->accel[k] == (float)accel_raw(seq, k) * 0.000001f;
+
+    if (!ok)
+        g_bad_cnt++;
+    if ((int64_t)seq <= g_last_seq)
+        g_order_cnt++;
+
+    g_last_seq = seq;
+    g_recv_cnt++;
+}
+
+static void *producer_main(void *arg)
+{
+    (void)arg;
+
+    size_t pos         = 0;
+    uint64_t next      = now_ns();
+    uint64_t chunk_ns  = g_cfg.baud ? (uint64_t)g_cfg.chunk * YS_UART_BITS_PER_BYTE * 1000000000ULL / g_cfg.baud : 0;
+
+    while (pos < g_stream.len)
+    {
+        uint32_t len = g_stream.len - pos < g_cfg.chunk ? (uint32_t)(g_stream.len - pos) : g_cfg.chunk;
+        uint32_t off = 0;
+
+        if (chunk_ns)
+        {
+            next += chunk_ns;
+            sleep_until(next);
+        }
+
+        /* one dma interrupt: keep calling until the half-buffer is consumed */
+        while (off < len)
+        {
+            uint64_t t0 = now_ns();
+            uint32_t n  = ys_parser_input_chunk(&g_parser, &g_stream.data[pos + off], len - off, g_cfg.budget);
+            uint64_t t1 = now_ns();
+
+            g_call_ns[g_call_cnt++] = (uint32_t)(t1 - t0);
+
+            if (n > g_call_max_bytes)
+                g_call_max_bytes = n;
+
+            off += n;
+        }
+
+        pos += len;
+    }
+
+    __atomic_store_n(&g_producer_done, 1, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+static void *consumer_main(void *arg)
+{
+    (void)arg;
+
+    for (;;)
+    {
+        int done = __atomic_load_n(&g_producer_done, __ATOMIC_ACQUIRE);
+
+        if (ys_parser_poll(&g_parser, 0) == 0)
+        {
+            if (done)
+                break; /* the producer finished before this empty poll */
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int parse_args(int argc, char *argv[])
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:c:w:p:b:a")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': g_cfg.frame_num = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'c': g_cfg.chunk = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'w': g_cfg.budget = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'p': g_cfg.noise_prob = atof(optarg); break;
+            case 'b': g_cfg.baud = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'a': g_cfg.adversarial = 1; break;
+            default: return -1;
+        }
+    }
+
+    return (g_cfg.frame_num > 0 && g_cfg.chunk > 0) ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    pthread_t producer, consumer;
+
+    if (parse_args(argc, argv) != 0)
+    {
+        fprintf(stderr, "usage: %s [-n frames] [-c chunk] [-w budget] [-p prob] [-b baud] [-a]\n", argv[0]);
+        return 2;
+    }
+
+    if (build_stream(&g_stream) != 0)
+        return 1;
+
+    /* at most one call per byte */
+    g_call_ns = malloc(g_stream.len * sizeof(uint32_t));
+
+    if (g_call_ns == NULL)
+        return 1;
+
+    ys_parser_create_static(&g_parser, on_frame);
+
+    pthread_create(&consumer, NULL, consumer_main, NULL);
+    pthread_create(&producer, NULL, producer_main, NULL);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    const ys_trace_info_t *inf = &g_parser.trace_inf;
+    uint32_t expect            = g_stream.sent - g_stream.broken;
+    uint32_t accounted         = g_recv_cnt + inf->drop_frame_cnt;
+
+    /* drop_frame_cnt is 16 bit, compare modulo 2^16 when the consumer is flooded */
+    int pass = g_bad_cnt == 0 && g_order_cnt == 0 && (uint16_t)accounted == (uint16_t)expect;
+
+    qsort(g_call_ns, g_call_cnt, sizeof(uint32_t), cmp_u32);
+
+    printf("stream   %zu bytes, %u frames, %u corrupted on purpose\n", g_stream.len, g_stream.sent, g_stream.broken);
+    printf("consumer %u delivered, %u dropped (queue full), %u bad payload, %u out of order, %u spurious\n",
+           g_recv_cnt, inf->drop_frame_cnt, g_bad_cnt, g_order_cnt, g_spurious_cnt);
+    printf("parser   %u chk errors, %u resync candidates\n", inf->err_frame_cnt, inf->resync_cnt);
+    printf("isr      %u calls, max %u bytes/call, p50 %u ns, p99.9 %u ns, max %u ns\n", g_call_cnt, g_call_max_bytes,
+           g_call_ns[g_call_cnt / 2], g_call_ns[(uint32_t)(g_call_cnt * 0.999)], g_call_ns[g_call_cnt - 1]);
+    printf("%s: %u of %u intact frames accounted for\n", pass ? "PASS" : "FAIL", accounted, expect);
+
+    free(g_call_ns);
+    free(g_stream.data);
+
+    return pass ? 0 : 1;
+}
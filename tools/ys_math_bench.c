@@ -0,0 +1,351 @@
+/**
+ * Accuracy check and benchmark of the ys_math batch kernels.
+ *
+ * Every batch kernel is compared against a per-sample reference on random
+ * unit quaternions, body vectors and positions, and the max abs error is
+ * reported; the program fails when an error exceeds its tolerance:
+ *   quat -> rotm     R * e_j against ys_quat_rotate(q, e_j)
+ *   rotate to enu    ys_quat_rotate(q, v)
+ *   linear accel     ys_quat_rotate(q, a) - g * U
+ *   geodetic -> ecef textbook WGS84 closed form in long double
+ *   geodetic -> enu  ecef difference rotated by the reference lat / lon, long double
+ *
+ * The benchmark times 1024-sample blocks (the block size the numbers in the
+ * ys_math commit were quoted for) and prints ns/sample of each batch kernel
+ * and of a naive AoS loop over ys_sensor_data_t calling ys_quat_rotate.
+ *
+ * Build: cc -O3 -mavx2 -mfma -I.. ys_math_bench.c ../ys_math.c -o ys_math_bench -lm
+ *        (drop -mavx2 -mfma for the SSE2 baseline)
+ *
+ * Usage: ys_math_bench [-n block] [-r rounds]
+ *   -n num    samples per block (default 1024)
+ *   -r num    timed passes per kernel (default 20000)
+ */
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <ys_math.h>
+
+/* float kernels: a few ulp of values bounded by |v| <= 20 */
+#define TOL_ROTM   1e-6
+#define TOL_VEC    2e-5
+/* double kernels, in metres */
+#define TOL_ECEF   1e-6
+#define TOL_ENU    1e-6
+
+#define WGS84_A  6378137.0L
+#define WGS84_E2 6.69437999014e-3L
+#define DEG_TO_RAD (3.14159265358979323846264338327950288L / 180.0L)
+
+static uint32_t g_block  = 1024;
+static uint32_t g_rounds = 20000;
+
+/* keeps the optimizer from dropping the timed loops */
+static volatile float g_sink;
+
+static float *g_q[4], *g_v[3], *g_out[3], *g_rotm[9];
+static double *g_lla[3], *g_dout[3];
+static ys_sensor_data_t *g_aos;
+
+//---------------------------------------------------------------------------
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static double urand(unsigned int *seed, double lo, double hi)
+{
+    return lo + (hi - lo) * (double)rand_r(seed) / RAND_MAX;
+}
+
+static void *xalloc(size_t size)
+{
+    /* 64 byte aligned, like a block handed over by the batch decoder */
+    void *p = aligned_alloc(64, (size + 63) & ~(size_t)63);
+
+    if (p == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    return p;
+}
+
+static void fill_inputs(void)
+{
+    unsigned int seed = 2024;
+
+    for (uint32_t i = 0; i < g_block; i++)
+    {
+        float q[4];
+
+        for (int k = 0; k < 4; k++)
+            q[k] = (float)urand(&seed, -1.0, 1.0);
+
+        ys_quat_normalize(q);
+
+        for (int k = 0; k < 4; k++)
+        {
+            g_q[k][i]              = q[k];
+            g_aos[i].quaternion[k] = q[k];
+        }
+
+        for (int k = 0; k < 3; k++)
+        {
+            g_v[k][i]         = (float)urand(&seed, -20.0, 20.0);
+            g_aos[i].accel[k] = g_v[k][i];
+        }
+
+        g_lla[LAT][i] = urand(&seed, -89.0, 89.0);
+        g_lla[LON][i] = urand(&seed, -180.0, 180.0);
+        g_lla[ALT][i] = urand(&seed, -100.0, 9000.0);
+    }
+}
+
+static void ref_ecef(const long double lla[3], long double out[3])
+{
+    long double lat = lla[LAT] * DEG_TO_RAD;
+    long double lon = lla[LON] * DEG_TO_RAD;
+    long double rn  = WGS84_A / sqrtl(1.0L - WGS84_E2 * sinl(lat) * sinl(lat));
+
+    out[X] = (rn + lla[ALT]) * cosl(lat) * cosl(lon);
+    out[Y] = (rn + lla[ALT]) * cosl(lat) * sinl(lon);
+    out[Z] = (rn * (1.0L - WGS84_E2) + lla[ALT]) * sinl(lat);
+}
+
+static double max_err(double cur, double err)
+{
+    err = fabs(err);
+    return err > cur ? err : cur;
+}
+
+static int report(const char *name, double err, double tol)
+{
+    int ok = err <= tol;
+
+    printf("  %-18s max abs err %.3e (tol %.0e)  %s\n", name, err, tol, ok ? "ok" : "FAIL");
+
+    return ok;
+}
+
+static int check_accuracy(void)
+{
+    ys_quat_soa_t q   = {{g_q[0], g_q[1], g_q[2], g_q[3]}};
+    ys_vec3_soa_t v   = {{g_v[0], g_v[1], g_v[2]}};
+    ys_vec3_soa_t out = {{g_out[0], g_out[1], g_out[2]}};
+    ys_rotm_soa_t rm;
+    ys_dvec3_soa_t lla  = {{g_lla[0], g_lla[1], g_lla[2]}};
+    ys_dvec3_soa_t dout = {{g_dout[0], g_dout[1], g_dout[2]}};
+    double err;
+    int ok = 1;
+
+    for (int k = 0; k < 9; k++)
+        rm.r[k] = g_rotm[k];
+
+    printf("accuracy (%u samples)\n", g_block);
+
+    /* column j of the rotation matrix is the rotated unit vector e_j */
+    ys_quat_to_rotm_batch(&q, &rm, g_block);
+    err = 0.0;
+    for (uint32_t i = 0; i < g_block; i++)
+    {
+        float qi[4] = {g_q[0][i], g_q[1][i], g_q[2][i], g_q[3][i]};
+
+        for (int j = 0; j < 3; j++)
+        {
+            float e[3] = {0.0f, 0.0f, 0.0f}, r[3];
+
+            e[j] = 1.0f;
+            ys_quat_rotate(qi, e, r);
+
+            for (int k = 0; k < 3; k++)
+                err = max_err(err, (double)g_rotm[k * 3 + j][i] - r[k]);
+        }
+    }
+    ok &= report("quat -> rotm", err, TOL_ROTM);
+
+    ys_rotate_to_enu_batch(&q, &v, &out, g_block);
+    err = 0.0;
+    for (uint32_t i = 0; i < g_block; i++)
+    {
+        float qi[4] = {g_q[0][i], g_q[1][i], g_q[2][i], g_q[3][i]};
+        float vi[3] = {g_v[0][i], g_v[1][i], g_v[2][i]}, r[3];
+
+        ys_quat_rotate(qi, vi, r);
+
+        for (int k = 0; k < 3; k++)
+            err = max_err(err, (double)g_out[k][i] - r[k]);
+    }
+    ok &= report("rotate to enu", err, TOL_VEC);
+
+    ys_linear_accel_batch(&q, &v, &out, YS_GRAVITY, g_block);
+    err = 0.0;
+    for (uint32_t i = 0; i < g_block; i++)
+    {
+        float qi[4] = {g_q[0][i], g_q[1][i], g_q[2][i], g_q[3][i]};
+        float vi[3] = {g_v[0][i], g_v[1][i], g_v[2][i]}, r[3];
+
+        ys_quat_rotate(qi, vi, r);
+        r[U] -= YS_GRAVITY;
+
+        for (int k = 0; k < 3; k++)
+            err = max_err(err, (double)g_out[k][i] - r[k]);
+    }
+    ok &= report("linear accel", err, TOL_VEC);
+
+    ys_geodetic_to_ecef_batch(&lla, &dout, g_block);
+    err = 0.0;
+    for (uint32_t i = 0; i < g_block; i++)
+    {
+        long double p[3] = {g_lla[LAT][i], g_lla[LON][i], g_lla[ALT][i]}, r[3];
+
+        ref_ecef(p, r);
+
+        for (int k = 0; k < 3; k++)
+            err = max_err(err, (double)((long double)g_dout[k][i] - r[k]));
+    }
+    ok &= report("geodetic -> ecef", err, TOL_ECEF);
+
+    /* local frame around a point inside the block, positions within a few degrees */
+    double ref[3] = {31.2, 121.5, 12.0};
+
+    for (uint32_t i = 0; i < g_block; i++)
+    {
+        g_lla[LAT][i] = ref[LAT] + fmod(g_lla[LAT][i], 2.0);
+        g_lla[LON][i] = ref[LON] + fmod(g_lla[LON][i], 2.0);
+    }
+
+    ys_geodetic_to_enu_batch(ref, &lla, &dout, g_block);
+    err = 0.0;
+    for (uint32_t i = 0; i < g_block; i++)
+    {
+        long double p[3] = {g_lla[LAT][i], g_lla[LON][i], g_lla[ALT][i]}, r[3];
+        long double o[3] = {ref[LAT], ref[LON], ref[ALT]}, ro[3];
+        long double lat  = o[LAT] * DEG_TO_RAD;
+        long double lon  = o[LON] * DEG_TO_RAD;
+
+        ref_ecef(p, r);
+        ref_ecef(o, ro);
+
+        long double dx = r[X] - ro[X], dy = r[Y] - ro[Y], dz = r[Z] - ro[Z];
+        long double e  = -sinl(lon) * dx + cosl(lon) * dy;
+        long double n  = -sinl(lat) * cosl(lon) * dx - sinl(lat) * sinl(lon) * dy + cosl(lat) * dz;
+        long double u  = cosl(lat) * cosl(lon) * dx + cosl(lat) * sinl(lon) * dy + sinl(lat) * dz;
+
+        err = max_err(err, (double)((long double)g_dout[E][i] - e));
+        err = max_err(err, (double)((long double)g_dout[N][i] - n));
+        err = max_err(err, (double)((long double)g_dout[U][i] - u));
+    }
+    ok &= report("geodetic -> enu", err, TOL_ENU);
+
+    return ok;
+}
+
+static void naive_aos_linear_accel(const ys_sensor_data_t *in, float (*out)[3], uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        ys_quat_rotate(in[i].quaternion, in[i].accel, out[i]);
+        out[i][U] -= YS_GRAVITY;
+    }
+}
+
+static void bench(void)
+{
+    ys_quat_soa_t q   = {{g_q[0], g_q[1], g_q[2], g_q[3]}};
+    ys_vec3_soa_t v   = {{g_v[0], g_v[1], g_v[2]}};
+    ys_vec3_soa_t out = {{g_out[0], g_out[1], g_out[2]}};
+    ys_rotm_soa_t rm;
+    ys_dvec3_soa_t lla  = {{g_lla[0], g_lla[1], g_lla[2]}};
+    ys_dvec3_soa_t dout = {{g_dout[0], g_dout[1], g_dout[2]}};
+    float(*aos_out)[3]  = xalloc(sizeof(float[3]) * g_block);
+    uint64_t t0;
+
+    for (int k = 0; k < 9; k++)
+        rm.r[k] = g_rotm[k];
+
+    printf("benchmark (%u samples per block, %u passes)\n", g_block, g_rounds);
+
+#define BENCH(name, rounds, call, sink)                                               \
+    do                                                                                \
+    {                                                                                 \
+        call; /* warm up */                                                           \
+        t0 = now_ns();                                                                \
+        for (uint32_t r = 0; r < (rounds); r++)                                       \
+        {                                                                             \
+            call;                                                                     \
+            g_sink = (float)(sink);                                                   \
+        }                                                                             \
+        printf("  %-18s %6.2f ns/sample\n", name,                                     \
+               (double)(now_ns() - t0) / ((double)g_block * (rounds)));               \
+    } while (0)
+
+    BENCH("linear accel", g_rounds, ys_linear_accel_batch(&q, &v, &out, YS_GRAVITY, g_block), g_out[U][0]);
+    BENCH("naive AoS", g_rounds, naive_aos_linear_accel(g_aos, aos_out, g_block), aos_out[0][U]);
+    BENCH("quat -> rotm", g_rounds, ys_quat_to_rotm_batch(&q, &rm, g_block), g_rotm[8][0]);
+    BENCH("rotate to enu", g_rounds, ys_rotate_to_enu_batch(&q, &v, &out, g_block), g_out[U][0]);
+
+    /* bound by sin / cos, fewer passes keep the run short */
+    BENCH("geodetic -> ecef", g_rounds / 20 + 1, ys_geodetic_to_ecef_batch(&lla, &dout, g_block), g_dout[Z][0]);
+
+#undef BENCH
+
+    free(aos_out);
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': g_block = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'r': g_rounds = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-n block] [-r rounds]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if (g_block == 0 || g_rounds == 0)
+        return 2;
+
+    for (int k = 0; k < 4; k++)
+        g_q[k] = xalloc(sizeof(float) * g_block);
+    for (int k = 0; k < 3; k++)
+    {
+        g_v[k]    = xalloc(sizeof(float) * g_block);
+        g_out[k]  = xalloc(sizeof(float) * g_block);
+        g_lla[k]  = xalloc(sizeof(double) * g_block);
+        g_dout[k] = xalloc(sizeof(double) * g_block);
+    }
+    for (int k = 0; k < 9; k++)
+        g_rotm[k] = xalloc(sizeof(float) * g_block);
+
+    g_aos = xalloc(sizeof(ys_sensor_data_t) * g_block);
+    memset(g_aos, 0, sizeof(ys_sensor_data_t) * g_block);
+
+    fill_inputs();
+
+    /* the benchmark runs after the accuracy check, which moves the enu positions */
+    int ok = check_accuracy();
+
+    bench();
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+
+    return ok ? 0 : 1;
+}
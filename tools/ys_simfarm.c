@@ -0,0 +1,866 @@
+/**
+ * Virtual Yesense device farm over pseudo-terminals.
+ *
+ * Creates N pseudo-terminals and streams valid YS frames into each at a
+ * configured rate and id set, with optional noise, bursts and stalls.
+ *
+ * Every frame carries its injection time in the DATA_READY_TIMESTAMP field:
+ * the low 32 bits of CLOCK_MONOTONIC in nanoseconds, taken right before the
+ * frame is written. A backend under test computes the end-to-end latency as
+ * (uint32_t)(now_ns - data_ready_timestamp), valid for latencies below 4 s.
+ *
+ * Without -m the pty paths are printed and any ingest backend can open them.
+ * The writer never blocks on a pty: when the reader does not keep up, or no
+ * backend is attached at all, the bytes the pty can not take are dropped and
+ * counted as overruns, like a device whose UART buffer overflows.
+ * With -m every pty is read by its own thread running ys_parse_buf_ex, which
+ * reports per-sensor latency and cpu time. The cpu time is that of the
+ * built-in reader thread only (read calls and parsing), an external backend
+ * is not measured. The latency needs data id 52 in the -i list, frames
+ * without it are counted but not timed.
+ *
+ * Each virtual device also accepts the configuration commands of ys_cmd.h
+ * written to its pty: "set output content" and "set output rate" change the
+ * frames that follow, and every command is answered with an ack frame
+ * (CLASS, STATUS), status 0 on success and 1 for an unknown class or an
+ * invalid parameter. Frames already held by a burst are written before the ack.
+ * With -c every pty is driven by a test thread that reconfigures the device
+ * through ys_cmd_encode_* / ys_cmd_find_ack and checks the acks and the
+ * frames that follow them; the exit status is 0 when all sensors pass.
+ *
+ * Build: cc -O2 -pthread -I.. ys_simfarm.c ../ys_parser.c ../ys_cmd.c -o ys_simfarm
+ *
+ * Usage: ys_simfarm [options]
+ *   -n num       number of sensors (default 4)
+ *   -r rate      output rate per sensor in Hz (default 200)
+ *   -i ids       comma separated hex data ids (default 01,10,20,41,51,52)
+ *   -t seconds   run time (default 10)
+ *   -p prob      probability of noise per frame: garbage bytes or a corrupted frame (default 0)
+ *   -b cnt:ms    every ms, hold cnt frames and write them in one go (burst)
+ *   -s len:ms    every ms, stop the output for len ms (stall), frames in the stall are lost
+ *   -m           measure with the built-in parser
+ *   -c           run the command / ack test on every sensor instead of a timed run
+ */
+
+#define _GNU_SOURCE /* RUSAGE_THREAD, ptsname_r */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <ys_parser.h>
+#include <ys_cmd.h>
+
+#define MAX_IDS        32
+#define MAX_BURST      64
+#define HIST_BUCKETS   40 /* log2 buckets of latency in ns */
+#define READ_CHUNK     4096
+#define CMD_BUF_SIZE   512
+
+/* ack status of the simulated device */
+#define ACK_OK         0
+#define ACK_INVALID    1
+
+typedef struct
+{
+    int sensor_num;
+    uint32_t rate;
+    uint8_t ids[MAX_IDS];
+    uint8_t id_cnt;
+    uint32_t duration_s;
+    double noise_prob;
+    uint32_t burst_cnt, burst_ms;
+    uint32_t stall_len_ms, stall_ms;
+    int measure;
+    int cmd_test;
+} sim_config_t;
+
+typedef struct
+{
+    int index;
+    int master_fd;
+    int slave_fd;
+    char path[64];
+    pthread_t writer, reader;
+    unsigned int seed;
+
+    /* device config, changed by commands */
+    uint8_t ids[MAX_IDS];
+    uint8_t id_cnt;
+    uint32_t rate;
+
+    /* commands received on the master side, acks waiting to be written */
+    uint8_t cmd_buf[CMD_BUF_SIZE];
+    size_t cmd_len;
+    uint8_t ack_buf[CMD_BUF_SIZE];
+    size_t ack_len;
+    uint64_t cmd_cnt;
+
+    /* writer stats */
+    uint64_t sent_frames;
+    uint64_t noise_cnt;
+    uint64_t overrun_cnt;   /* writes cut short by a full pty */
+    uint64_t overrun_bytes; /* bytes dropped by them */
+
+    /* reader stats */
+    ys_parser_t parser;
+    uint64_t recv_frames;
+    uint64_t lat_cnt; /* received frames with a DATA_READY_TIMESTAMP field */
+    uint64_t hist[HIST_BUCKETS];
+    uint64_t lat_sum_ns;
+    uint32_t lat_max_ns;
+    double cpu_s;
+
+    /* command test result */
+    const char *test_err;
+} sim_sensor_t;
+
+/* frame checks of the command test */
+typedef struct
+{
+    const uint8_t *ids; /* expected layout */
+    uint8_t id_cnt;
+    int after_ack;      /* only frames behind the last ack are checked */
+    uint32_t frames;
+    uint32_t bad_layout;
+
+    /* bytes read from the pty but not parsed yet, they may hold the start of an ack */
+    uint8_t rx[READ_CHUNK * 2];
+    size_t rx_len;
+} cmd_test_ctx_t;
+
+static sim_config_t g_cfg = {
+    .sensor_num = 4,
+    .rate       = 200,
+    .ids        = {0x01, 0x10, 0x20, 0x41, 0x51, 0x52},
+    .id_cnt     = 6,
+    .duration_s = 10,
+};
+
+static volatile int g_running = 1;
+
+//---------------------------------------------------------------------------
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* write everything, waiting for the reader, fails when the deadline (CLOCK_MONOTONIC ns) passes first */
+static int write_all(int fd, const uint8_t *buf, size_t len, uint64_t deadline)
+{
+    while (len > 0)
+    {
+        ssize_t n = write(fd, buf, len);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN && now_ns() < deadline)
+            {
+                struct pollfd pfd = {.fd = fd, .events = POLLOUT};
+                poll(&pfd, 1, 100);
+                continue;
+            }
+            return -1;
+        }
+
+        buf += n;
+        len -= (size_t)n;
+    }
+
+    return 0;
+}
+
+/* write the frames of one burst, what the pty can not take is dropped as an overrun */
+static int write_frames(sim_sensor_t *s, const uint8_t *buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = write(s->master_fd, buf, len);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+            {
+                s->overrun_cnt++;
+                s->overrun_bytes += len;
+                return 0;
+            }
+            return -1;
+        }
+
+        buf += n;
+        len -= (size_t)n;
+    }
+
+    return 0;
+}
+
+static int open_pty(sim_sensor_t *s)
+{
+    struct termios tio;
+
+    s->master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+    /* non-blocking: a pty nobody reads fills up, and the writer must still keep its timing and end */
+    if (s->master_fd < 0 || fcntl(s->master_fd, F_SETFL, O_NONBLOCK) != 0 || grantpt(s->master_fd) != 0 ||
+        unlockpt(s->master_fd) != 0 || ptsname_r(s->master_fd, s->path, sizeof(s->path)) != 0)
+        return -1;
+
+    /* keep the slave open, so that writes never fail while no backend is attached */
+    s->slave_fd = open(s->path, O_RDWR | O_NOCTTY);
+
+    if (s->slave_fd < 0 || tcgetattr(s->slave_fd, &tio) != 0)
+        return -1;
+
+    cfmakeraw(&tio);
+
+    return tcsetattr(s->slave_fd, TCSANOW, &tio);
+}
+
+/* build one output frame, the message content follows the configured id list */
+static uint16_t build_frame(sim_sensor_t *s, uint8_t *buf, uint16_t size, uint16_t tid, uint64_t sample_us)
+{
+    uint8_t msg[YS_MSG_MAX_LEN];
+    uint8_t len = 0;
+
+    for (uint8_t i = 0; i < s->id_cnt; i++)
+    {
+        uint8_t id       = s->ids[i];
+        uint8_t data_len = ys_data_id_len(id);
+
+        if (len + 2 + data_len >= YS_MSG_MAX_LEN)
+            break;
+
+        msg[len++] = id;
+        msg[len++] = data_len;
+
+        if (id == YS_ID_SAMPLE_TIMESTAMP)
+        {
+            uint32_t v = (uint32_t)sample_us;
+            memcpy(&msg[len], &v, 4);
+        }
+        else if (id == YS_ID_DATA_READY_TIMESTAMP)
+        {
+            uint32_t v = (uint32_t)now_ns(); /* injection time */
+            memcpy(&msg[len], &v, 4);
+        }
+        else
+        {
+            for (uint8_t k = 0; k < data_len; k++)
+                msg[len + k] = (uint8_t)rand_r(&s->seed);
+        }
+
+        len += data_len;
+    }
+
+    return ys_frame_encode(buf, size, tid, msg, len);
+}
+
+/* apply one command to the virtual device and queue its ack */
+static void handle_command(sim_sensor_t *s, uint16_t tid, uint8_t cmd_class, const uint8_t *param, uint8_t param_len)
+{
+    uint8_t status = ACK_INVALID;
+
+    /* param: MODE(1) | ..., flash and ram commands act the same here */
+    if (cmd_class == YS_CMD_CLASS_OUTPUT_CONTENT && param_len >= 2 && param[1] == param_len - 2 &&
+        param[1] > 0 && param[1] <= MAX_IDS)
+    {
+        const uint8_t *ids = &param[2];
+        uint16_t size      = ys_output_frame_size(ids, param[1]);
+
+        if (size != 0 && size < YS_MSG_MAX_LEN + YS_FRAME_OVERHEAD)
+        {
+            memcpy(s->ids, ids, param[1]);
+            s->id_cnt = param[1];
+            status    = ACK_OK;
+        }
+    }
+    else if (cmd_class == YS_CMD_CLASS_OUTPUT_RATE && param_len == 3)
+    {
+        uint16_t rate = (uint16_t)(param[1] | ((uint16_t)param[2] << 8));
+
+        if (rate > 0)
+        {
+            s->rate = rate;
+            status  = ACK_OK;
+        }
+    }
+
+    uint8_t msg[2] = {cmd_class, status};
+    uint16_t n     = ys_frame_encode(&s->ack_buf[s->ack_len], (uint16_t)(sizeof(s->ack_buf) - s->ack_len), tid, msg, sizeof(msg));
+
+    s->ack_len += n;
+    s->cmd_cnt++;
+}
+
+/* decode every complete command in the receive buffer, bytes that cannot start one are dropped */
+static void scan_commands(sim_sensor_t *s)
+{
+    size_t pos = 0;
+
+    while (pos + YS_FRAME_OVERHEAD <= s->cmd_len)
+    {
+        const uint8_t *frame = &s->cmd_buf[pos];
+        const uint8_t *param;
+        uint8_t cmd_class, param_len;
+        uint16_t tid;
+
+        if (ys_cmd_decode(frame, (uint16_t)(s->cmd_len - pos), &tid, &cmd_class, &param, &param_len) != 0)
+        {
+            /* a header whose frame is not complete yet waits for more bytes */
+            if (frame[0] == 'Y' && frame[1] == 'S' && pos + frame[4] + YS_FRAME_OVERHEAD > s->cmd_len)
+                break;
+
+            pos++;
+            continue;
+        }
+
+        handle_command(s, tid, cmd_class, param, param_len);
+        pos += frame[4] + YS_FRAME_OVERHEAD;
+    }
+
+    memmove(s->cmd_buf, &s->cmd_buf[pos], s->cmd_len - pos);
+    s->cmd_len -= pos;
+}
+
+/* wait for the next frame time, serving the commands written to the pty meanwhile */
+static void wait_serve(sim_sensor_t *s, uint64_t t_ns)
+{
+    for (;;)
+    {
+        uint64_t now = now_ns();
+
+        if (now >= t_ns)
+            return;
+
+        struct pollfd pfd  = {.fd = s->master_fd, .events = POLLIN};
+        struct timespec ts = {
+            .tv_sec  = (time_t)((t_ns - now) / 1000000000ULL),
+            .tv_nsec = (long)((t_ns - now) % 1000000000ULL),
+        };
+
+        if (ppoll(&pfd, 1, &ts, NULL) <= 0 || (pfd.revents & POLLIN) == 0)
+            continue;
+
+        ssize_t n = read(s->master_fd, &s->cmd_buf[s->cmd_len], sizeof(s->cmd_buf) - s->cmd_len);
+
+        if (n <= 0)
+            continue;
+
+        s->cmd_len += (size_t)n;
+        scan_commands(s);
+
+        /* a full buffer without a command start is garbage */
+        if (s->cmd_len == sizeof(s->cmd_buf))
+            s->cmd_len = 0;
+    }
+}
+
+static void *writer_main(void *arg)
+{
+    sim_sensor_t *s       = (sim_sensor_t *)arg;
+    uint64_t start        = now_ns();
+    uint64_t next         = start;
+    uint64_t end          = g_cfg.cmd_test ? UINT64_MAX : start + (uint64_t)g_cfg.duration_s * 1000000000ULL;
+    uint64_t next_burst   = start + (uint64_t)g_cfg.burst_ms * 1000000ULL;
+    uint64_t next_stall   = start + (uint64_t)g_cfg.stall_ms * 1000000ULL;
+    uint8_t buf[(YS_MSG_MAX_LEN + YS_FRAME_OVERHEAD + 16) * MAX_BURST];
+    size_t buf_len        = 0;
+    uint32_t held         = 0;
+    uint16_t tid          = 0;
+
+    while (g_running && next < end)
+    {
+        wait_serve(s, next);
+
+        uint64_t now    = now_ns();
+        uint64_t period = 1000000000ULL / s->rate;
+
+        /* acks go out right away, behind the frames built before the command */
+        if (s->ack_len > 0)
+        {
+            if (write_frames(s, buf, buf_len) != 0 || write_all(s->master_fd, s->ack_buf, s->ack_len, end) != 0)
+                break;
+
+            buf_len    = 0;
+            held       = 0;
+            s->ack_len = 0;
+        }
+
+        /* stall: the device stops sending, frames in the stall are never produced */
+        if (g_cfg.stall_ms > 0 && now >= next_stall)
+        {
+            uint64_t resume = next_stall + (uint64_t)g_cfg.stall_len_ms * 1000000ULL;
+
+            while (next < resume)
+            {
+                next += period;
+                tid++;
+            }
+
+            next_stall += (uint64_t)g_cfg.stall_ms * 1000000ULL;
+            continue;
+        }
+
+        /* noise between frames, or a corrupted frame */
+        if (g_cfg.noise_prob > 0 && (double)rand_r(&s->seed) / RAND_MAX < g_cfg.noise_prob)
+        {
+            s->noise_cnt++;
+
+            if (rand_r(&s->seed) & 1)
+            {
+                uint32_t n = 1 + (uint32_t)rand_r(&s->seed) % 16;
+
+                for (uint32_t k = 0; k < n; k++)
+                    buf[buf_len++] = (uint8_t)rand_r(&s->seed);
+            }
+            else
+            {
+                uint16_t n = build_frame(s, &buf[buf_len], (uint16_t)(sizeof(buf) - buf_len), tid++, (next - start) / 1000);
+
+                /* n is 0 when the frame does not fit into the burst buffer */
+                if (n > 0)
+                    buf[buf_len + 5 + (uint32_t)rand_r(&s->seed) % (n - 5)] ^= 0x5A;
+
+                buf_len += n;
+                goto flush;
+            }
+        }
+
+        uint16_t n = build_frame(s, &buf[buf_len], (uint16_t)(sizeof(buf) - buf_len), tid++, (next - start) / 1000);
+
+        if (n > 0)
+            s->sent_frames++;
+
+        buf_len += n;
+
+    flush:
+        held++;
+
+        /* burst: hold frames and write them together */
+        if (g_cfg.burst_ms > 0 && now >= next_burst && held < g_cfg.burst_cnt)
+        {
+            next += period;
+            continue;
+        }
+
+        if (g_cfg.burst_ms > 0 && held >= g_cfg.burst_cnt && now >= next_burst)
+            next_burst += (uint64_t)g_cfg.burst_ms * 1000000ULL;
+
+        /* held frames keep their build time, so the latency includes the hold, as with a buffering device */
+        if (write_frames(s, buf, buf_len) != 0)
+            break;
+
+        buf_len = 0;
+        held    = 0;
+        next += period;
+    }
+
+    return NULL;
+}
+
+static void on_frame(ys_result_callback_params_t *params)
+{
+    sim_sensor_t *s = (sim_sensor_t *)params->user_data;
+    uint32_t now    = (uint32_t)now_ns();
+    int timed       = 0;
+    int bucket      = 0;
+
+    s->recv_frames++;
+
+    for (uint8_t i = 0; i < params->field_cnt; i++)
+    {
+        if (params->field_li[i] == YS_ID_DATA_READY_TIMESTAMP)
+            timed = 1;
+    }
+
+    /* without the field data_ready_timestamp is 0, not an injection time */
+    if (!timed)
+        return;
+
+    uint32_t lat = now - params->result->data_ready_timestamp;
+
+    for (uint32_t v = lat; v > 1 && bucket < HIST_BUCKETS - 1; v >>= 1)
+        bucket++;
+
+    s->hist[bucket]++;
+    s->lat_sum_ns += lat;
+    s->lat_cnt++;
+
+    if (lat > s->lat_max_ns)
+        s->lat_max_ns = lat;
+}
+
+static void *reader_main(void *arg)
+{
+    sim_sensor_t *s = (sim_sensor_t *)arg;
+    uint8_t buf[READ_CHUNK];
+    struct rusage ru;
+
+    ys_parser_create_static(&s->parser, on_frame);
+    ys_parser_set_user_data(&s->parser, s);
+
+    for (;;)
+    {
+        struct pollfd pfd = {.fd = s->slave_fd, .events = POLLIN};
+        int ret           = poll(&pfd, 1, 200);
+
+        if (ret == 0)
+        {
+            if (!g_running)
+                break; /* drained */
+            continue;
+        }
+
+        ssize_t n = read(s->slave_fd, buf, sizeof(buf));
+
+        if (n > 0)
+            ys_parse_buf_ex(&s->parser, buf, (size_t)n, 0, NULL);
+        else if (n < 0 && errno != EINTR && errno != EAGAIN)
+            break;
+    }
+
+    getrusage(RUSAGE_THREAD, &ru);
+    s->cpu_s = (double)ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 +
+               (double)ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+
+    return NULL;
+}
+
+static void test_on_frame(ys_result_callback_params_t *params)
+{
+    cmd_test_ctx_t *ctx = (cmd_test_ctx_t *)params->user_data;
+
+    if (!ctx->after_ack)
+        return;
+
+    ctx->frames++;
+
+    if (params->field_cnt != ctx->id_cnt || memcmp(params->field_li, ctx->ids, ctx->id_cnt) != 0)
+        ctx->bad_layout++;
+}
+
+/*
+ * read the pty for 'ms' milliseconds (or until an ack shows up when 'ack' is given),
+ * frames are checked by the parser, an ack switches the checks to the new layout
+ */
+static int test_read(sim_sensor_t *s, ys_parser_t *parser, cmd_test_ctx_t *ctx, uint32_t ms, ys_cmd_ack_t *ack)
+{
+    uint8_t *rx  = ctx->rx;
+    uint64_t end = now_ns() + (uint64_t)ms * 1000000ULL;
+
+    while (now_ns() < end)
+    {
+        struct pollfd pfd = {.fd = s->slave_fd, .events = POLLIN};
+
+        if (poll(&pfd, 1, 10) <= 0)
+            continue;
+
+        ssize_t n = read(s->slave_fd, &rx[ctx->rx_len], sizeof(ctx->rx) - ctx->rx_len);
+
+        if (n <= 0)
+            continue;
+
+        ctx->rx_len += (size_t)n;
+
+        int32_t off = ack ? ys_cmd_find_ack(rx, (uint32_t)ctx->rx_len, ack) : -1;
+
+        /* frames before the ack still use the old layout */
+        size_t feed = off >= 0 ? (size_t)off : (ctx->rx_len > YS_FRAME_OVERHEAD + 2 ? ctx->rx_len - (YS_FRAME_OVERHEAD + 2) : 0);
+
+        if (!ack)
+            feed = ctx->rx_len;
+
+        ys_parse_buf_ex(parser, rx, feed, 0, NULL);
+        memmove(rx, &rx[feed], ctx->rx_len - feed);
+        ctx->rx_len -= feed;
+
+        if (off >= 0)
+        {
+            ctx->after_ack = 1;
+            return 0;
+        }
+    }
+
+    /* the kept tail is parsed by the next call */
+    return ack ? -1 : 0;
+}
+
+static const char *test_command(sim_sensor_t *s, ys_parser_t *parser, cmd_test_ctx_t *ctx,
+                                const uint8_t *cmd, uint16_t len, uint16_t tid, uint8_t cmd_class, uint8_t expect_status)
+{
+    ys_cmd_ack_t ack;
+
+    ctx->after_ack = 0;
+
+    if (len == 0 || write_all(s->slave_fd, cmd, len, UINT64_MAX) != 0)
+        return "command not sent";
+
+    if (test_read(s, parser, ctx, 1000, &ack) != 0)
+        return "no ack";
+
+    if (ack.tid != tid || ack.cmd_class != cmd_class)
+        return "ack does not match the command";
+
+    if (ack.status != expect_status)
+        return expect_status == ACK_OK ? "command rejected" : "invalid command accepted";
+
+    return NULL;
+}
+
+/* reconfigure the device over the pty and check what comes back */
+static void *cmd_test_main(void *arg)
+{
+    static const uint8_t new_ids[] = {YS_ID_ACCEL, YS_ID_ANGLE, YS_ID_DATA_READY_TIMESTAMP};
+    static const uint8_t bad_ids[] = {YS_ID_ACCEL, 0xEE};
+
+    sim_sensor_t *s    = (sim_sensor_t *)arg;
+    uint16_t new_rate  = (uint16_t)(g_cfg.rate * 2);
+    cmd_test_ctx_t ctx = {.ids = g_cfg.ids, .id_cnt = g_cfg.id_cnt, .after_ack = 1};
+    uint8_t cmd[YS_MSG_MAX_LEN + YS_FRAME_OVERHEAD];
+    ys_cmd_ack_t ack;
+    ys_parser_t parser;
+    const char *err;
+
+    ys_parser_create_static(&parser, test_on_frame);
+    ys_parser_set_user_data(&parser, &ctx);
+
+#define TEST(_expr)       \
+    if ((err = (_expr)))  \
+        goto done;
+
+    /* configured layout before any command */
+    test_read(s, &parser, &ctx, 200, NULL);
+    TEST(ctx.frames == 0 || ctx.bad_layout ? "unexpected initial frames" : NULL);
+
+    /* output content, frames behind the ack use the new layout */
+    ctx.ids    = new_ids;
+    ctx.id_cnt = sizeof(new_ids);
+    ctx.frames = 0;
+    TEST(test_command(s, &parser, &ctx, cmd,
+                      ys_cmd_encode_output_content(cmd, sizeof(cmd), 0x1001, YS_CMD_MODE_RAM, new_ids, sizeof(new_ids)),
+                      0x1001, YS_CMD_CLASS_OUTPUT_CONTENT, ACK_OK));
+    test_read(s, &parser, &ctx, 300, NULL);
+    TEST(ctx.frames == 0 || ctx.bad_layout ? "output content not applied" : NULL);
+
+    /* output rate, count the frames of one second */
+    TEST(test_command(s, &parser, &ctx, cmd,
+                      ys_cmd_encode_output_rate(cmd, sizeof(cmd), 0x1002, YS_CMD_MODE_FLASH, new_rate),
+                      0x1002, YS_CMD_CLASS_OUTPUT_RATE, ACK_OK));
+    ctx.frames = 0;
+    test_read(s, &parser, &ctx, 1000, NULL);
+    TEST(ctx.frames < new_rate * 8 / 10 || ctx.frames > new_rate * 12 / 10 ? "output rate not applied" : NULL);
+
+    /* unknown data id, rejected and the layout is kept */
+    ctx.frames = 0;
+    TEST(test_command(s, &parser, &ctx, cmd,
+                      ys_cmd_encode_output_content(cmd, sizeof(cmd), 0x1003, YS_CMD_MODE_RAM, bad_ids, sizeof(bad_ids)),
+                      0x1003, YS_CMD_CLASS_OUTPUT_CONTENT, ACK_INVALID));
+    test_read(s, &parser, &ctx, 200, NULL);
+    TEST(ctx.frames == 0 || ctx.bad_layout ? "layout changed by a rejected command" : NULL);
+
+    /* broken checksum, the device must not answer */
+    uint16_t len = ys_cmd_encode_output_rate(cmd, sizeof(cmd), 0x1004, YS_CMD_MODE_RAM, (uint16_t)g_cfg.rate);
+
+    cmd[len - 1] ^= 0x5A;
+    TEST(write_all(s->slave_fd, cmd, len, UINT64_MAX) != 0 ? "command not sent" : NULL);
+    TEST(test_read(s, &parser, &ctx, 300, &ack) == 0 ? "ack to a corrupted command" : NULL);
+
+#undef TEST
+
+done:
+    s->test_err = err;
+    return NULL;
+}
+
+static double hist_percentile(const sim_sensor_t *s, double p)
+{
+    uint64_t target = (uint64_t)(s->lat_cnt * p);
+    uint64_t acc    = 0;
+
+    for (int i = 0; i < HIST_BUCKETS; i++)
+    {
+        acc += s->hist[i];
+
+        if (acc > target)
+            return (double)(1ULL << i) / 1000.0; /* upper bound of the bucket, us */
+    }
+
+    return (double)s->lat_max_ns / 1000.0;
+}
+
+static int parse_args(int argc, char *argv[])
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:i:t:p:b:s:mc")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': g_cfg.sensor_num = atoi(optarg); break;
+            case 'r': g_cfg.rate = (uint32_t)atoi(optarg); break;
+            case 't': g_cfg.duration_s = (uint32_t)atoi(optarg); break;
+            case 'p': g_cfg.noise_prob = atof(optarg); break;
+            case 'm': g_cfg.measure = 1; break;
+            case 'c': g_cfg.cmd_test = 1; break;
+            case 'b':
+                if (sscanf(optarg, "%u:%u", &g_cfg.burst_cnt, &g_cfg.burst_ms) != 2 ||
+                    g_cfg.burst_cnt == 0 || g_cfg.burst_cnt > MAX_BURST)
+                    return -1;
+                break;
+            case 's':
+                if (sscanf(optarg, "%u:%u", &g_cfg.stall_len_ms, &g_cfg.stall_ms) != 2)
+                    return -1;
+                break;
+            case 'i':
+            {
+                char *tok = strtok(optarg, ",");
+                g_cfg.id_cnt = 0;
+
+                while (tok != NULL && g_cfg.id_cnt < MAX_IDS)
+                {
+                    uint8_t id = (uint8_t)strtoul(tok, NULL, 16);
+
+                    if (ys_data_id_len(id) == 0)
+                    {
+                        fprintf(stderr, "unknown data id: %s\n", tok);
+                        return -1;
+                    }
+
+                    g_cfg.ids[g_cfg.id_cnt++] = id;
+                    tok = strtok(NULL, ",");
+                }
+            }
+            break;
+            default:
+                return -1;
+        }
+    }
+
+    /* both read the pty */
+    if (g_cfg.measure && g_cfg.cmd_test)
+        return -1;
+
+    return (g_cfg.sensor_num > 0 && g_cfg.rate > 0 && g_cfg.rate <= 0x7FFF && g_cfg.id_cnt > 0) ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    if (parse_args(argc, argv) != 0)
+    {
+        fprintf(stderr, "usage: %s [-n num] [-r rate] [-i ids] [-t seconds] [-p prob] [-b cnt:ms] [-s len:ms] [-m | -c]\n", argv[0]);
+        return 2;
+    }
+
+    sim_sensor_t *sensors = calloc((size_t)g_cfg.sensor_num, sizeof(sim_sensor_t));
+
+    if (sensors == NULL)
+        return 1;
+
+    for (int i = 0; i < g_cfg.sensor_num; i++)
+    {
+        sensors[i].index  = i;
+        sensors[i].seed   = (unsigned int)(i * 7919 + 1);
+        sensors[i].rate   = g_cfg.rate;
+        sensors[i].id_cnt = g_cfg.id_cnt;
+        memcpy(sensors[i].ids, g_cfg.ids, g_cfg.id_cnt);
+
+        if (open_pty(&sensors[i]) != 0)
+        {
+            perror("pty");
+            return 1;
+        }
+
+        uint16_t frame_size = ys_output_frame_size(g_cfg.ids, g_cfg.id_cnt);
+        printf("sensor %d: %s (%u bytes/frame, %u bytes/s)\n", i, sensors[i].path, frame_size, frame_size * g_cfg.rate);
+    }
+
+    fflush(stdout);
+
+    for (int i = 0; i < g_cfg.sensor_num; i++)
+    {
+        if (g_cfg.measure)
+            pthread_create(&sensors[i].reader, NULL, reader_main, &sensors[i]);
+        if (g_cfg.cmd_test)
+            pthread_create(&sensors[i].reader, NULL, cmd_test_main, &sensors[i]);
+
+        pthread_create(&sensors[i].writer, NULL, writer_main, &sensors[i]);
+    }
+
+    if (g_cfg.cmd_test)
+    {
+        int failed = 0;
+
+        for (int i = 0; i < g_cfg.sensor_num; i++)
+        {
+            pthread_join(sensors[i].reader, NULL);
+            printf("sensor %d: %llu commands, %s%s\n", i, (unsigned long long)sensors[i].cmd_cnt,
+                   sensors[i].test_err ? "FAIL: " : "PASS", sensors[i].test_err ? sensors[i].test_err : "");
+            failed |= sensors[i].test_err != NULL;
+        }
+
+        /* the writers run until the tests are done */
+        g_running = 0;
+
+        for (int i = 0; i < g_cfg.sensor_num; i++)
+            pthread_join(sensors[i].writer, NULL);
+
+        return failed ? 1 : 0;
+    }
+
+    for (int i = 0; i < g_cfg.sensor_num; i++)
+        pthread_join(sensors[i].writer, NULL);
+
+    g_running = 0;
+
+    if (!g_cfg.measure)
+    {
+        for (int i = 0; i < g_cfg.sensor_num; i++)
+            printf("sensor %d: sent %llu frames, %llu noise, %llu overruns (%llu bytes dropped)\n", i,
+                   (unsigned long long)sensors[i].sent_frames, (unsigned long long)sensors[i].noise_cnt,
+                   (unsigned long long)sensors[i].overrun_cnt, (unsigned long long)sensors[i].overrun_bytes);
+        return 0;
+    }
+
+    /* CPU_MS and CPU_% are the built-in reader thread of the sensor, see -m */
+    printf("%-6s %8s %8s %8s %8s %6s %6s %9s %9s %9s %9s %9s %7s\n",
+           "SENSOR", "SENT", "OVERRUN", "RECV", "TIMED", "ERR", "GAPS", "AVG_US", "P50_US", "P99_US", "MAX_US", "RD_CPU_MS", "RD_CPU%");
+
+    for (int i = 0; i < g_cfg.sensor_num; i++)
+    {
+        sim_sensor_t *s = &sensors[i];
+
+        pthread_join(s->reader, NULL);
+
+        printf("%-6d %8llu %8llu %8llu %8llu %6u %6u %9.1f %9.1f %9.1f %9.1f %9.1f %7.3f\n", i,
+               (unsigned long long)s->sent_frames,
+               (unsigned long long)s->overrun_cnt,
+               (unsigned long long)s->recv_frames,
+               (unsigned long long)s->lat_cnt,
+               s->parser.trace_inf.err_frame_cnt,
+               s->parser.trace_inf.link.gap_cnt,
+               s->lat_cnt ? (double)s->lat_sum_ns / s->lat_cnt / 1000.0 : 0.0,
+               hist_percentile(s, 0.50),
+               hist_percentile(s, 0.99),
+               s->lat_max_ns / 1000.0,
+               s->cpu_s * 1000.0,
+               s->cpu_s * 100.0 / g_cfg.duration_s);
+    }
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+/**
+ * Check of the ys_strapdown checkpoint and merge path.
+ *
+ * A random maneuver (quaternion_inc / speed_inc of a slowly turning,
+ * accelerating body) is integrated once in a single pass, then split into
+ * chunks that are integrated independently from the identity attitude with
+ * gravity 0 and joined with ys_strapdown_merge. The merged attitude, velocity
+ * and position are compared against the single pass; the program fails when
+ * an error exceeds its tolerance. A save / restore round trip in the middle
+ * of the sequence must reproduce the single pass exactly.
+ *
+ * Build: cc -O2 -I.. ys_strapdown_check.c ../ys_strapdown.c ../ys_math.c -o ys_strapdown_check -lm
+ *
+ * Usage: ys_strapdown_check [-n samples] [-r rate]
+ *   -n num    samples of the sequence (default 40000)
+ *   -r rate   sample rate in Hz (default 200)
+ */
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <ys_strapdown.h>
+
+/* float attitude, the rounding of the two paths drifts apart about linearly with the sample count */
+#define TOL_QUAT            1e-5
+#define TOL_QUAT_PER_SAMPLE 2.5e-9
+/* relative to the largest |velocity| / |position| of the single pass */
+#define TOL_VEL 1e-4
+#define TOL_POS 1e-4
+
+static uint32_t g_cnt = 40000;
+static float g_rate   = 200.0f;
+
+static float *g_dq[4], *g_dv[3];
+
+//---------------------------------------------------------------------------
+
+static double urand(unsigned int *seed, double lo, double hi)
+{
+    return lo + (hi - lo) * (double)rand_r(seed) / RAND_MAX;
+}
+
+static void *xalloc(size_t size)
+{
+    void *p = malloc(size);
+
+    if (p == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    return p;
+}
+
+/* body rates and specific force drift slowly, like a vehicle, not white noise */
+static void fill_inputs(void)
+{
+    unsigned int seed = 2028;
+    double dt         = 1.0 / g_rate;
+    double w[3]       = {0.0, 0.0, 0.0}; /* rad/s */
+    double f[3]       = {0.0, 0.0, YS_GRAVITY};
+
+    for (uint32_t i = 0; i < g_cnt; i++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            w[k] = 0.999 * w[k] + urand(&seed, -0.01, 0.01);
+            f[k] = 0.999 * f[k] + urand(&seed, -0.02, 0.02) + (k == Z ? 0.001 * YS_GRAVITY : 0.0);
+        }
+
+        double half = 0.5 * dt * sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+        double s    = half > 0.0 ? sin(half) / (half / (0.5 * dt)) : 0.5 * dt;
+
+        g_dq[0][i] = (float)cos(half);
+        g_dq[1][i] = (float)(s * w[0]);
+        g_dq[2][i] = (float)(s * w[1]);
+        g_dq[3][i] = (float)(s * w[2]);
+
+        for (int k = 0; k < 3; k++)
+            g_dv[k][i] = (float)(f[k] * dt);
+    }
+}
+
+static void integrate(ys_strapdown_t *sd, uint32_t begin, uint32_t end)
+{
+    ys_quat_soa_t dq = {{&g_dq[0][begin], &g_dq[1][begin], &g_dq[2][begin], &g_dq[3][begin]}};
+    ys_vec3_soa_t dv = {{&g_dv[0][begin], &g_dv[1][begin], &g_dv[2][begin]}};
+
+    ys_strapdown_update_batch(sd, &dq, &dv, end - begin);
+}
+
+static double vec_err(const double a[3], const double b[3])
+{
+    double e = 0.0;
+
+    for (int k = 0; k < 3; k++)
+        e += (a[k] - b[k]) * (a[k] - b[k]);
+
+    return sqrt(e);
+}
+
+static double vec_norm(const double a[3])
+{
+    return sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+}
+
+/* q and -q are the same attitude */
+static double quat_err(const float a[4], const float b[4])
+{
+    double plus = 0.0, minus = 0.0;
+
+    for (int k = 0; k < 4; k++)
+    {
+        plus += ((double)a[k] - b[k]) * ((double)a[k] - b[k]);
+        minus += ((double)a[k] + b[k]) * ((double)a[k] + b[k]);
+    }
+
+    return sqrt(plus < minus ? plus : minus);
+}
+
+static int report(const char *name, double err, double tol)
+{
+    int ok = err <= tol;
+
+    printf("  %-22s err %.3e (tol %.1e)  %s\n", name, err, tol, ok ? "ok" : "FAIL");
+
+    return ok;
+}
+
+/* integrate 'chunks' pieces independently and join them in order */
+static int check_merge(const ys_strapdown_t *ref, const float init_quat[4], uint32_t chunks)
+{
+    float dt = 1.0f / g_rate;
+    ys_strapdown_t head;
+    int ok = 1;
+
+    ys_strapdown_init(&head, init_quat, dt);
+    integrate(&head, 0, g_cnt / chunks);
+
+    for (uint32_t c = 1; c < chunks; c++)
+    {
+        ys_strapdown_t tail;
+        uint32_t end = c + 1 == chunks ? g_cnt : (uint32_t)((uint64_t)g_cnt * (c + 1) / chunks);
+
+        /* the tail starts in its own body frame, without gravity */
+        ys_strapdown_init(&tail, NULL, dt);
+        tail.gravity = 0.0f;
+        integrate(&tail, (uint32_t)((uint64_t)g_cnt * c / chunks), end);
+
+        ys_strapdown_merge(&head.state, &tail.state, dt, YS_GRAVITY, &head.state);
+    }
+
+    printf("%u chunks\n", chunks);
+
+    ok &= report("quaternion", quat_err(head.state.quaternion, ref->state.quaternion), TOL_QUAT + TOL_QUAT_PER_SAMPLE * g_cnt);
+    ok &= report("velocity (relative)", vec_err(head.state.velocity, ref->state.velocity) / vec_norm(ref->state.velocity), TOL_VEL);
+    ok &= report("position (relative)", vec_err(head.state.position, ref->state.position) / vec_norm(ref->state.position), TOL_POS);
+
+    if (head.state.sample_cnt != ref->state.sample_cnt)
+    {
+        printf("  sample_cnt %u, expected %u  FAIL\n", head.state.sample_cnt, ref->state.sample_cnt);
+        ok = 0;
+    }
+
+    return ok;
+}
+
+/* a restored checkpoint continues exactly like the uninterrupted integrator */
+static int check_checkpoint(const ys_strapdown_t *ref, const float init_quat[4])
+{
+    ys_strapdown_t sd;
+    ys_strapdown_state_t cp;
+
+    ys_strapdown_init(&sd, init_quat, 1.0f / g_rate);
+    integrate(&sd, 0, g_cnt / 3);
+    ys_strapdown_save(&sd, &cp);
+
+    /* run on, then rewind to the checkpoint */
+    integrate(&sd, g_cnt / 3, g_cnt / 2);
+    ys_strapdown_restore(&sd, &cp);
+    integrate(&sd, g_cnt / 3, g_cnt);
+
+    int ok = memcmp(&sd.state, &ref->state, sizeof(ys_strapdown_state_t)) == 0;
+
+    printf("checkpoint\n  %-22s %s\n", "save / restore", ok ? "ok" : "FAIL");
+
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    static const uint32_t chunk_li[] = {2, 3, 8, 64};
+    float init_quat[4]               = {0.9f, 0.1f, -0.2f, 0.3f};
+    ys_strapdown_t ref;
+    int opt;
+    int ok = 1;
+
+    while ((opt = getopt(argc, argv, "n:r:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': g_cnt = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'r': g_rate = strtof(optarg, NULL); break;
+            default:
+                fprintf(stderr, "usage: %s [-n samples] [-r rate]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if (g_cnt < 128 || g_rate <= 0.0f)
+        return 2;
+
+    for (int k = 0; k < 4; k++)
+        g_dq[k] = xalloc(sizeof(float) * g_cnt);
+    for (int k = 0; k < 3; k++)
+        g_dv[k] = xalloc(sizeof(float) * g_cnt);
+
+    fill_inputs();
+
+    ys_strapdown_init(&ref, init_quat, 1.0f / g_rate);
+    integrate(&ref, 0, g_cnt);
+
+    printf("single pass: %u samples at %.0f Hz, |v| %.2f m/s, |p| %.1f m\n", g_cnt, g_rate,
+           vec_norm(ref.state.velocity), vec_norm(ref.state.position));
+
+    for (size_t i = 0; i < sizeof(chunk_li) / sizeof(chunk_li[0]); i++)
+        ok &= check_merge(&ref, init_quat, chunk_li[i]);
+
+    ok &= check_checkpoint(&ref, init_quat);
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+
+    return ok ? 0 : 1;
+}
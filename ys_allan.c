@@ -0,0 +1,341 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <ys_allan.h>
+
+#define ALLAN_RING      (2 * YS_ALLAN_SPAN)
+#define ALLAN_RING_MASK (ALLAN_RING - 1)
+
+#define allan_level_ring(_allan, _level) (&(_allan)->ring[(size_t)(_level) * ALLAN_RING * YS_ALLAN_CH_PAD])
+
+//-------------------------- internal func ----------------------------------
+
+static bool allan_init_taus(ys_allan_t *allan, const ys_allan_config_t *config);
+
+static void allan_push(ys_allan_t *allan, const double *ys_restrict y);
+
+static void allan_level_update(ys_allan_t *allan, uint8_t level);
+
+static void allan_accum(const double *ys_restrict cur, const double *ys_restrict mid, const double *ys_restrict head,
+                        double *ys_restrict sum);
+
+static void allan_on_frame(ys_result_callback_params_t *params);
+
+//---------------------------------------------------------------------------
+
+ys_allan_t *ys_allan_create(const ys_allan_config_t *config)
+{
+    ys_allan_t *allan;
+
+    if (config->rate <= 0.0 || config->tau_max <= 0.0)
+        return NULL;
+
+    allan = ys_malloc(sizeof(ys_allan_t));
+
+    if (allan == NULL)
+        return NULL;
+
+    memset(allan, 0, sizeof(ys_allan_t));
+
+    allan->rate = config->rate;
+
+    if (!allan_init_taus(allan, config))
+    {
+        ys_free(allan);
+        return NULL;
+    }
+
+    /* the initial prefix sum of every level is 0, ring slot 0 */
+    size_t ring_size = (size_t)allan->level_cnt * ALLAN_RING * YS_ALLAN_CH_PAD * sizeof(double);
+
+    allan->ring = ys_malloc(ring_size);
+
+    if (allan->ring == NULL)
+    {
+        ys_free(allan);
+        return NULL;
+    }
+
+    memset(allan->ring, 0, ring_size);
+
+    ys_parser_create_static(&allan->parser, allan_on_frame);
+    ys_parser_set_user_data(&allan->parser, allan);
+
+    return allan;
+}
+
+void ys_allan_free(ys_allan_t *allan)
+{
+    if (allan == NULL)
+        return;
+
+    ys_free(allan->ring);
+    ys_free(allan);
+}
+
+void ys_allan_add(ys_allan_t *allan, const float sample[YS_ALLAN_CH])
+{
+    double y[YS_ALLAN_CH_PAD] = {0};
+
+    for (uint8_t ch = 0; ch < YS_ALLAN_CH; ch++)
+    {
+        /* NaN marks a missing field (see ys_batch) */
+        if (sample[ch] != sample[ch])
+        {
+            allan->skip_cnt++;
+            return;
+        }
+
+        y[ch] = sample[ch];
+    }
+
+    allan_push(allan, y);
+}
+
+void ys_allan_add_block(ys_allan_t *allan, const ys_vec3_soa_t *angle, const ys_vec3_soa_t *accel, uint32_t n)
+{
+    float sample[YS_ALLAN_CH];
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        for (uint8_t k = 0; k < 3; k++)
+        {
+            sample[YS_ALLAN_ANGLE_X + k] = angle->v[k][i];
+            sample[YS_ALLAN_ACCEL_X + k] = accel->v[k][i];
+        }
+
+        ys_allan_add(allan, sample);
+    }
+}
+
+void ys_allan_parse(ys_allan_t *allan, const uint8_t *buf, size_t len)
+{
+    ys_parse_buf_ex(&allan->parser, buf, len, 0, NULL);
+}
+
+uint16_t ys_allan_result(const ys_allan_t *allan, ys_allan_point_t *points, uint16_t max)
+{
+    uint16_t cnt = 0;
+
+    for (uint16_t i = 0; i < allan->tau_cnt && cnt < max; i++)
+    {
+        const ys_allan_tau_t *tau = &allan->taus[i];
+        ys_allan_point_t *point   = &points[cnt];
+        double m                  = (double)((uint64_t)tau->m << tau->level); /* in input samples */
+        uint64_t len              = allan->level_len[tau->level];
+
+        /* one cluster difference per stored prefix sum once 2m of them are there */
+        if (len < 2 * (uint64_t)tau->m)
+            continue;
+
+        point->tau = m / allan->rate;
+        point->cnt = len - 2 * (uint64_t)tau->m + 1;
+
+        /* the prefix sums are in sample units: avar = E[d^2] / (2 * m^2) */
+        for (uint8_t ch = 0; ch < YS_ALLAN_CH; ch++)
+            point->adev[ch] = sqrt(tau->sum[ch] / (2.0 * m * m * (double)point->cnt));
+
+        cnt++;
+    }
+
+    return cnt;
+}
+
+void ys_allan_noise(const ys_allan_t *allan, ys_allan_noise_t noise[YS_ALLAN_CH])
+{
+    ys_allan_point_t points[YS_ALLAN_MAX_TAUS];
+    uint16_t cnt = ys_allan_result(allan, points, YS_ALLAN_MAX_TAUS);
+
+    ys_allan_noise_points(points, cnt, noise);
+}
+
+void ys_allan_noise_points(const ys_allan_point_t *points, uint16_t cnt, ys_allan_noise_t noise[YS_ALLAN_CH])
+{
+    memset(noise, 0, sizeof(ys_allan_noise_t) * YS_ALLAN_CH);
+
+    if (cnt == 0)
+        return;
+
+    for (uint8_t ch = 0; ch < YS_ALLAN_CH; ch++)
+    {
+        ys_allan_noise_t *out = &noise[ch];
+        uint16_t i;
+
+        /* random walk: adev at tau = 1 s, log-log interpolation */
+        for (i = 0; i < cnt && points[i].tau < 1.0; i++)
+            ;
+
+        if (i == 0)
+        {
+            out->random_walk = points[0].adev[ch] * sqrt(points[0].tau);
+        }
+        else if (i == cnt)
+        {
+            out->random_walk = points[cnt - 1].adev[ch] * sqrt(points[cnt - 1].tau);
+        }
+        else
+        {
+            double t0 = log(points[i - 1].tau), t1 = log(points[i].tau);
+            double a0 = log(points[i - 1].adev[ch]), a1 = log(points[i].adev[ch]);
+
+            out->random_walk = exp(a0 + (a1 - a0) * (0.0 - t0) / (t1 - t0));
+        }
+
+        /* bias instability: the flat bottom of the curve */
+        out->bias_instability = points[0].adev[ch];
+        out->bias_tau         = points[0].tau;
+
+        for (i = 1; i < cnt; i++)
+        {
+            if (points[i].adev[ch] < out->bias_instability)
+            {
+                out->bias_instability = points[i].adev[ch];
+                out->bias_tau         = points[i].tau;
+            }
+        }
+
+        out->bias_instability /= YS_ALLAN_BI_FACTOR;
+    }
+}
+
+//-------------------------- internal func ----------------------------------
+
+static bool allan_init_taus(ys_allan_t *allan, const ys_allan_config_t *config)
+{
+    uint16_t ppd   = config->points_per_decade ? config->points_per_decade : 10;
+    double tau_min = config->tau_min > 0.0 ? config->tau_min : 1.0 / config->rate;
+    double m_min   = tau_min * config->rate;
+    double m_max   = config->tau_max * config->rate;
+    uint64_t last  = 0;
+    uint16_t index = 0; /* position in the full tau sequence */
+    uint16_t end   = config->tau_end ? config->tau_end : YS_ALLAN_MAX_TAUS;
+
+    if (m_min < 1.0)
+        m_min = 1.0;
+
+    if (m_max < m_min)
+        return false;
+
+    /* log spaced cluster sizes, rounded to the sample grid of their level */
+    for (uint32_t p = 0; allan->tau_cnt < YS_ALLAN_MAX_TAUS && index < end; p++)
+    {
+        double m = m_min * pow(10.0, (double)p / ppd);
+        uint64_t im;
+        uint8_t level = 0;
+
+        if (m > m_max * (1.0 + 1e-9))
+            break;
+
+        im = (uint64_t)(m + 0.5);
+
+        /* m must stay below the span of its level, so that 2m fits in the ring */
+        while (((im + ((1ull << level) >> 1)) >> level) >= YS_ALLAN_SPAN)
+            level++;
+
+        if (level >= YS_ALLAN_MAX_LEVELS)
+            break;
+
+        uint32_t lm = (uint32_t)((im + ((1ull << level) >> 1)) >> level);
+
+        if (((uint64_t)lm << level) <= last)
+            continue; /* same cluster size after rounding */
+
+        last = (uint64_t)lm << level;
+
+        /* taus before the range still count, so every range splits the same sequence */
+        if (index++ < config->tau_begin)
+            continue;
+
+        ys_allan_tau_t *tau = &allan->taus[allan->tau_cnt++];
+
+        tau->m     = lm;
+        tau->level = level;
+
+        /* taus are in ascending order, so their levels are too */
+        while (allan->level_cnt <= level)
+            allan->level_first[allan->level_cnt++] = (uint16_t)(allan->tau_cnt - 1);
+    }
+
+    allan->level_first[allan->level_cnt] = allan->tau_cnt;
+
+    return allan->tau_cnt > 0;
+}
+
+static void allan_push(ys_allan_t *allan, const double *ys_restrict y)
+{
+    if (allan->sample_cnt == 0)
+        memcpy(allan->offset, y, sizeof(allan->offset));
+
+    for (uint8_t ch = 0; ch < YS_ALLAN_CH_PAD; ch++)
+        allan->theta[ch] += y[ch] - allan->offset[ch];
+
+    uint64_t n = ++allan->sample_cnt;
+
+    /* level l takes every 2^l-th prefix sum */
+    for (uint8_t level = 0; level < allan->level_cnt && (n & ((1ull << level) - 1)) == 0; level++)
+        allan_level_update(allan, level);
+}
+
+static void allan_level_update(ys_allan_t *allan, uint8_t level)
+{
+    double *ring = allan_level_ring(allan, level);
+    uint64_t k   = ++allan->level_len[level];
+    double *cur  = &ring[(k & ALLAN_RING_MASK) * YS_ALLAN_CH_PAD];
+
+    memcpy(cur, allan->theta, sizeof(allan->theta));
+
+    for (uint16_t i = allan->level_first[level]; i < allan->level_first[level + 1]; i++)
+    {
+        ys_allan_tau_t *tau = &allan->taus[i];
+        uint32_t m          = tau->m;
+
+        if (k < 2 * (uint64_t)m)
+            break; /* ascending m, the longer ones are not ready either */
+
+        allan_accum(cur,
+                    &ring[((k - m) & ALLAN_RING_MASK) * YS_ALLAN_CH_PAD],
+                    &ring[((k - 2 * m) & ALLAN_RING_MASK) * YS_ALLAN_CH_PAD],
+                    tau->sum);
+    }
+}
+
+static void allan_accum(const double *ys_restrict cur, const double *ys_restrict mid, const double *ys_restrict head,
+                        double *ys_restrict sum)
+{
+    for (uint8_t ch = 0; ch < YS_ALLAN_CH_PAD; ch++)
+    {
+        double d = cur[ch] - 2.0 * mid[ch] + head[ch];
+        sum[ch] += d * d;
+    }
+}
+
+static void allan_on_frame(ys_result_callback_params_t *params)
+{
+    ys_allan_t *allan = (ys_allan_t *)params->user_data;
+    uint8_t found     = 0;
+    double y[YS_ALLAN_CH_PAD] = {0};
+
+    for (uint8_t i = 0; i < params->field_cnt; i++)
+    {
+        if (params->field_li[i] == YS_ID_ANGLE)
+            found |= 1;
+        else if (params->field_li[i] == YS_ID_ACCEL)
+            found |= 2;
+    }
+
+    if (found != 3)
+    {
+        allan->skip_cnt++;
+        return;
+    }
+
+    for (uint8_t k = 0; k < 3; k++)
+    {
+        y[YS_ALLAN_ANGLE_X + k] = params->result->angle[k];
+        y[YS_ALLAN_ACCEL_X + k] = params->result->accel[k];
+    }
+
+    allan_push(allan, y);
+}
@@ -0,0 +1,203 @@
+/**
+ * Yesense 阿伦方差（Allan variance）流式计算
+ *
+ * 对 angle、accel 共 6 个通道，在一次遍历中计算对数间隔的一组簇时间 tau 上的重叠阿伦方差，
+ * 并提取角度 / 速度随机游走（ARW / VRW）与零偏不稳定性。
+ *
+ * 计算方法：
+ *  - 维护每个通道的前缀和 theta（积分值），簇均值之差 = (theta[k] - 2 * theta[k - m] + theta[k - 2m]) / m
+ *  - 簇长度 m < YS_ALLAN_SPAN 时，每个样本都参与计算（完全重叠）
+ *  - 更长的簇按 2 的幂抽取前缀和（第 l 级每 2^l 个样本保存一次），步长为 2^l 的部分重叠，
+ *    每级只保存 2 * YS_ALLAN_SPAN 个前缀和，内存与记录时长无关
+ *  - 每个样本的计算量与 tau 数量成正比，长簇的计算量按抽取倍数摊薄
+ *
+ * 注意：
+ *  - 输入样本应为等间隔采样，采样率由配置给出
+ *  - 每个 ys_allan_t 不使用全局变量，可在不同线程中分别计算不同的传感器，
+ *    或以不同的 tau 范围（tau_begin / tau_end）计算同一记录，再按 tau 顺序拼接各自的结果，
+ *    由 ys_allan_noise_points 提取噪声参数
+ *
+ * @author github0null
+ * @version 1.0
+ * @see https://github.com/github0null/
+*/
+
+#ifndef H_YS_ALLAN
+#define H_YS_ALLAN
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ys_parser.h"
+#include "ys_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 完全重叠的最大簇长度（样本数），必须为 2 的幂 */
+#ifndef YS_ALLAN_SPAN
+#define YS_ALLAN_SPAN 64
+#endif
+
+/* 最多 tau 数量 */
+#ifndef YS_ALLAN_MAX_TAUS
+#define YS_ALLAN_MAX_TAUS 128
+#endif
+
+/* 最多抽取级数 */
+#define YS_ALLAN_MAX_LEVELS 32
+
+/* 零偏不稳定性系数：bias_instability = min(adev) / 0.664 */
+#define YS_ALLAN_BI_FACTOR 0.664
+
+//////////////////////////////////////////////////////
+//                  Type Define
+//////////////////////////////////////////////////////
+
+/* 通道 */
+typedef enum
+{
+    YS_ALLAN_ANGLE_X = 0,
+    YS_ALLAN_ANGLE_Y,
+    YS_ALLAN_ANGLE_Z,
+    YS_ALLAN_ACCEL_X,
+    YS_ALLAN_ACCEL_Y,
+    YS_ALLAN_ACCEL_Z,
+    YS_ALLAN_CH
+} ys_allan_channel_t;
+
+/* 通道按 8 个 double 对齐存放，便于向量化 */
+#define YS_ALLAN_CH_PAD 8
+
+typedef struct
+{
+    double rate;                /* 采样率，单位：Hz */
+    double tau_min;             /* 最小簇时间，单位：s，不大于 0 时为 1 / rate */
+    double tau_max;             /* 最大簇时间，单位：s */
+    uint16_t points_per_decade; /* 每十倍程的 tau 数量，为 0 时为 10 */
+    uint16_t tau_begin;         /* 只计算 tau 序列中第 [tau_begin, tau_end) 个 tau，用于多个对象分担同一记录 */
+    uint16_t tau_end;           /* 为 0 时计算到最后一个 */
+} ys_allan_config_t;
+
+typedef struct
+{
+    uint32_t m;                  /* 簇长度（第 level 级的样本数） */
+    uint8_t level;               /* 抽取级数，簇长度 = m << level 个输入样本 */
+    double sum[YS_ALLAN_CH_PAD]; /* 簇差平方和 */
+} ys_allan_tau_t;
+
+typedef struct
+{
+    double rate;
+    uint16_t tau_cnt;
+    uint8_t level_cnt;
+    uint16_t level_first[YS_ALLAN_MAX_LEVELS + 1]; /* 每级第一个 tau 的索引 */
+    uint64_t level_len[YS_ALLAN_MAX_LEVELS];       /* 每级已保存的前缀和数量（不含初始的 0） */
+    ys_allan_tau_t taus[YS_ALLAN_MAX_TAUS];        /* 按簇长度升序 */
+    double *ring;                                  /* level_cnt * 2 * YS_ALLAN_SPAN * YS_ALLAN_CH_PAD */
+
+    double theta[YS_ALLAN_CH_PAD];  /* 前缀和 */
+    double offset[YS_ALLAN_CH_PAD]; /* 第一个样本，减去后再累加以保持精度 */
+    uint64_t sample_cnt;
+    uint64_t skip_cnt;              /* 含 NaN 或缺少字段而跳过的样本数 */
+
+    ys_parser_t parser;             /* 用于 ys_allan_parse */
+} ys_allan_t;
+
+/* 单个 tau 的结果 */
+typedef struct
+{
+    double tau;                /* 单位：s */
+    uint64_t cnt;              /* 参与计算的簇差数量 */
+    double adev[YS_ALLAN_CH];  /* 阿伦标准差，单位与输入相同 */
+} ys_allan_point_t;
+
+/* 噪声参数，单位与输入相同（angle：deg/s，accel：m/s^2） */
+typedef struct
+{
+    double random_walk;      /* tau = 1 s 处的阿伦标准差，即 ARW（deg/√s）/ VRW（m/s/√s），乘以 60 得到每 √h 的值 */
+    double bias_instability; /* 零偏不稳定性，min(adev) / 0.664 */
+    double bias_tau;         /* 取得最小值的 tau，单位：s */
+} ys_allan_noise_t;
+
+//////////////////////////////////////////////////////
+//                  Allan API
+//////////////////////////////////////////////////////
+
+/**
+ * 创建阿伦方差计算对象
+ *
+ * @param config 配置
+ *
+ * @return 计算对象，配置无效或内存不足时返回 NULL
+*/
+ys_allan_t *ys_allan_create(const ys_allan_config_t *config);
+
+/**
+ * 释放计算对象
+*/
+void ys_allan_free(ys_allan_t *allan);
+
+/**
+ * 输入一个样本
+ *
+ * @param sample 各通道数值，索引见 ys_allan_channel_t，含 NaN 的样本将被跳过
+*/
+void ys_allan_add(ys_allan_t *allan, const float sample[YS_ALLAN_CH]);
+
+/**
+ * 输入一块样本，例如 ys_batch 解码得到的 angle 与 accel 列
+ *
+ * @param angle 角速度块
+ *
+ * @param accel 加速度块
+ *
+ * @param n 样本数
+*/
+void ys_allan_add_block(ys_allan_t *allan, const ys_vec3_soa_t *angle, const ys_vec3_soa_t *accel, uint32_t n);
+
+/**
+ * 直接解析一段原始数据，使用其中同时包含 angle 与 accel 的帧
+ *
+ * @param buf 原始数据，可分多次输入
+ *
+ * @param len 数据长度
+*/
+void ys_allan_parse(ys_allan_t *allan, const uint8_t *buf, size_t len);
+
+/**
+ * 获取阿伦标准差曲线
+ *
+ * @param points 输出，按 tau 升序
+ *
+ * @param max points 的容量
+ *
+ * @return 输出的点数（尚无数据的 tau 不输出）
+*/
+uint16_t ys_allan_result(const ys_allan_t *allan, ys_allan_point_t *points, uint16_t max);
+
+/**
+ * 提取各通道的噪声参数
+ *
+ * tau = 1 s 不在计算范围内时，按斜率 -1/2（白噪声）由最近的一点外推
+ *
+ * @param noise 输出，索引见 ys_allan_channel_t
+*/
+void ys_allan_noise(const ys_allan_t *allan, ys_allan_noise_t noise[YS_ALLAN_CH]);
+
+/**
+ * 由阿伦标准差曲线提取各通道的噪声参数，例如多个对象按 tau 范围分担计算后拼接的曲线
+ *
+ * @param points 曲线，按 tau 升序
+ *
+ * @param cnt 点数
+ *
+ * @param noise 输出，索引见 ys_allan_channel_t
+*/
+void ys_allan_noise_points(const ys_allan_point_t *points, uint16_t cnt, ys_allan_noise_t noise[YS_ALLAN_CH]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
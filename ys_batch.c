@@ -0,0 +1,223 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <ys_batch.h>
+
+//-------------------------- type define  -----------------------------------
+
+typedef struct
+{
+    uint32_t column;  /* ys_batch_column_t */
+    uint8_t comp_cnt; /* column count of this field */
+    uint8_t elem_size;
+    uint16_t offset; /* offset of the column pointer (array) in ys_batch_t */
+} ys_batch_layout_t;
+
+static const ys_batch_layout_t batch_layout[] = {
+    {YS_BATCH_COL_LOCATION, 3, sizeof(double), offsetof(ys_batch_t, location)},
+    {YS_BATCH_COL_SAMPLE_TIMESTAMP, 1, sizeof(uint32_t), offsetof(ys_batch_t, sample_timestamp)},
+    {YS_BATCH_COL_DATA_READY_TIMESTAMP, 1, sizeof(uint32_t), offsetof(ys_batch_t, data_ready_timestamp)},
+    {YS_BATCH_COL_IMU_TEMP, 1, sizeof(float), offsetof(ys_batch_t, imu_temp)},
+    {YS_BATCH_COL_ACCEL, 3, sizeof(float), offsetof(ys_batch_t, accel)},
+    {YS_BATCH_COL_ANGLE, 3, sizeof(float), offsetof(ys_batch_t, angle)},
+    {YS_BATCH_COL_MAG, 3, sizeof(float), offsetof(ys_batch_t, mag)},
+    {YS_BATCH_COL_RAW_MAG, 3, sizeof(float), offsetof(ys_batch_t, raw_mag)},
+    {YS_BATCH_COL_EULER, 3, sizeof(float), offsetof(ys_batch_t, euler_angle)},
+    {YS_BATCH_COL_QUATERNION, 4, sizeof(float), offsetof(ys_batch_t, quaternion)},
+    {YS_BATCH_COL_QUATERNION_INC, 4, sizeof(float), offsetof(ys_batch_t, quaternion_inc)},
+    {YS_BATCH_COL_VELOCITY, 3, sizeof(float), offsetof(ys_batch_t, velocity)},
+    {YS_BATCH_COL_SPEED_INC, 3, sizeof(float), offsetof(ys_batch_t, speed_inc)},
+    {YS_BATCH_COL_TID, 1, sizeof(uint16_t), offsetof(ys_batch_t, tid)},
+    {YS_BATCH_COL_SECOND_IMU_TEMP, 1, sizeof(float), offsetof(ys_batch_t, second_imu_temp)},
+    {YS_BATCH_COL_SECOND_ACCEL, 3, sizeof(float), offsetof(ys_batch_t, second_accel)},
+    {YS_BATCH_COL_SECOND_ANGLE, 3, sizeof(float), offsetof(ys_batch_t, second_angle)},
+};
+
+#define BATCH_COL_DUAL_IMU (YS_BATCH_COL_SECOND_IMU_TEMP | YS_BATCH_COL_SECOND_ACCEL | YS_BATCH_COL_SECOND_ANGLE)
+
+#define BATCH_LAYOUT_NUM (sizeof(batch_layout) / sizeof(batch_layout[0]))
+
+#define ys_batch_align(_size) (((_size) + YS_BATCH_ALIGN - 1) / YS_BATCH_ALIGN * YS_BATCH_ALIGN)
+
+//-------------------------- internal func ----------------------------------
+
+static void batch_data_handler(ys_result_callback_params_t *params);
+
+static void write_float_col(float **cols, uint8_t comp_cnt, uint32_t row, const float *src, bool valid);
+
+//---------------------------------------------------------------------------
+
+size_t ys_batch_block_size(uint32_t capacity, uint32_t columns)
+{
+    size_t size = 0;
+
+    for (size_t i = 0; i < BATCH_LAYOUT_NUM; i++)
+    {
+        if (columns & batch_layout[i].column)
+            size += ys_batch_align(((size_t)capacity + YS_BATCH_SLACK) * batch_layout[i].elem_size) * batch_layout[i].comp_cnt;
+    }
+
+    return size;
+}
+
+void ys_batch_init(ys_batch_t *batch, void *block, uint32_t capacity, uint32_t columns)
+{
+    memset(batch, 0, sizeof(ys_batch_t));
+
+    batch->capacity = capacity;
+    batch->columns  = columns & YS_BATCH_COL_ALL;
+
+    if (block != NULL)
+        ys_batch_bind(batch, block);
+
+    ys_parser_create_static(&batch->parser, batch_data_handler);
+
+    if (batch->columns & BATCH_COL_DUAL_IMU)
+        ys_parser_enable_dual_imu(&batch->parser, &batch->dual_imu);
+}
+
+void ys_batch_bind(ys_batch_t *batch, void *block)
+{
+    uint8_t *ptr = (uint8_t *)block;
+
+    for (size_t i = 0; i < BATCH_LAYOUT_NUM; i++)
+    {
+        const ys_batch_layout_t *layout = &batch_layout[i];
+
+        if ((batch->columns & layout->column) == 0)
+            continue;
+
+        void **col_ptr = (void **)((uint8_t *)batch + layout->offset);
+
+        for (uint8_t k = 0; k < layout->comp_cnt; k++)
+        {
+            col_ptr[k] = ptr;
+            ptr += ys_batch_align(((size_t)batch->capacity + YS_BATCH_SLACK) * layout->elem_size);
+        }
+    }
+
+    batch->row_cnt = 0;
+}
+
+void ys_batch_clear(ys_batch_t *batch)
+{
+    batch->row_cnt = 0;
+}
+
+size_t ys_batch_decode(ys_batch_t *batch, const uint8_t *buf, size_t len)
+{
+    if (batch->row_cnt >= batch->capacity)
+        return 0;
+
+    /* set here, the batch object may have been moved since init */
+    ys_parser_set_user_data(&batch->parser, batch);
+
+    if (batch->columns & BATCH_COL_DUAL_IMU)
+        batch->parser.dual_imu = &batch->dual_imu;
+
+    return ys_parse_buf_ex(&batch->parser, buf, len, batch->capacity - batch->row_cnt, NULL);
+}
+
+//-------------------------- internal func ----------------------------------
+
+static void batch_data_handler(ys_result_callback_params_t *params)
+{
+    ys_batch_t *batch      = (ys_batch_t *)params->user_data;
+    ys_sensor_data_t *data = params->result;
+
+    /* one rescan may recover more frames than max_frames asked for, they go to the slack rows */
+    ys_assert(batch->row_cnt < batch->capacity + YS_BATCH_SLACK);
+
+    if (batch->row_cnt >= batch->capacity + YS_BATCH_SLACK)
+    {
+        batch->drop_cnt++;
+        return;
+    }
+
+    uint32_t row = batch->row_cnt++;
+
+    bool has_sample_ts = false, has_ready_ts = false, has_temp = false;
+    bool has_accel = false, has_angle = false, has_mag = false, has_raw_mag = false;
+    bool has_euler = false, has_quat = false, has_quat_inc = false;
+    bool has_location = false, has_velocity = false, has_speed_inc = false;
+    bool has_second_temp = false, has_second_accel = false, has_second_angle = false;
+
+    for (uint8_t i = 0; i < params->field_cnt; i++)
+    {
+        switch (params->field_li[i])
+        {
+            case YS_ID_SAMPLE_TIMESTAMP:     has_sample_ts = true; break;
+            case YS_ID_DATA_READY_TIMESTAMP: has_ready_ts = true; break;
+            case YS_ID_IMU_TEMP:             has_temp = true; break;
+            case YS_ID_ACCEL:                has_accel = true; break;
+            case YS_ID_ANGLE:                has_angle = true; break;
+            case YS_ID_MAGNETIC:             has_mag = true; break;
+            case YS_ID_RAW_MAGNETIC:         has_raw_mag = true; break;
+            case YS_ID_EULER:                has_euler = true; break;
+            case YS_ID_QUATERNION:           has_quat = true; break;
+            case YS_ID_QUATERNION_INCREMENT: has_quat_inc = true; break;
+            case YS_ID_LOCATION:
+            case YS_ID_HIGH_PRECI_LOCATION:  has_location = true; break;
+            case YS_ID_SPEED:                has_velocity = true; break;
+            case YS_ID_SPEED_INCREMENT:      has_speed_inc = true; break;
+            case YS_ID_SECOND_IMU_TEMP:      has_second_temp = true; break;
+            case YS_ID_SECOND_ACCEL:         has_second_accel = true; break;
+            case YS_ID_SECOND_ANGLE:         has_second_angle = true; break;
+            default:                         break;
+        }
+    }
+
+    if (batch->tid != NULL)
+        batch->tid[row] = params->tid;
+
+    if (batch->sample_timestamp != NULL)
+        batch->sample_timestamp[row] = has_sample_ts ? data->sample_timestamp : 0;
+
+    if (batch->data_ready_timestamp != NULL)
+        batch->data_ready_timestamp[row] = has_ready_ts ? data->data_ready_timestamp : 0;
+
+    if (batch->imu_temp != NULL)
+        batch->imu_temp[row] = has_temp ? data->imu_temp : NAN;
+
+    write_float_col(batch->accel, 3, row, data->accel, has_accel);
+    write_float_col(batch->angle, 3, row, data->angle, has_angle);
+    write_float_col(batch->mag, 3, row, data->mag, has_mag);
+    write_float_col(batch->raw_mag, 3, row, data->raw_mag, has_raw_mag);
+    write_float_col(batch->euler_angle, 3, row, data->euler_angle, has_euler);
+    write_float_col(batch->quaternion, 4, row, data->quaternion, has_quat);
+    write_float_col(batch->quaternion_inc, 4, row, data->quaternion_inc, has_quat_inc);
+    write_float_col(batch->velocity, 3, row, data->velocity, has_velocity);
+    write_float_col(batch->speed_inc, 3, row, data->speed_inc, has_speed_inc);
+
+    if (params->dual_imu != NULL)
+    {
+        ys_dual_imu_data_t *dual = params->dual_imu;
+
+        if (batch->second_imu_temp != NULL)
+            batch->second_imu_temp[row] = has_second_temp ? dual->second_imu_temp : NAN;
+
+        write_float_col(batch->second_accel, 3, row, dual->second_accel, has_second_accel);
+        write_float_col(batch->second_angle, 3, row, dual->second_angle, has_second_angle);
+    }
+
+    if (batch->location[0] != NULL)
+    {
+        for (uint8_t k = 0; k < 3; k++)
+        {
+            batch->location[k][row] = has_location ? data->location[k] : NAN;
+        }
+    }
+}
+
+static void write_float_col(float **cols, uint8_t comp_cnt, uint32_t row, const float *src, bool valid)
+{
+    if (cols[0] == NULL)
+        return;
+
+    for (uint8_t k = 0; k < comp_cnt; k++)
+    {
+        cols[k][row] = valid ? src[k] : NAN;
+    }
+}
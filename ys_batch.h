@@ -0,0 +1,160 @@
+/**
+ * Yesense 批量列式解码
+ *
+ * 将一段原始数据解码为按列存储的数组（每个字段分量一列），所有列位于调用者提供的同一块内存中，
+ * 解码过程中不产生逐帧的对象或内存分配，适合由上层语言（如 NumPy 数组）预先分配内存后直接填充。
+ *
+ * 每个 ys_batch_t 拥有独立的解析器状态，不使用全局变量，不同线程可同时解码不同的数据。
+ * 某帧中不存在的字段，浮点列填充 NaN，整数列填充 0。
+ *
+ * 解码结果中的向量列可直接组成 ys_math.h 中的 SoA 块进行批量计算，
+ * 例如 accel 与 second_accel 列可直接交给 ys_imu_vote_batch 进行双 IMU 一致性检查。
+ * 启用 YS_CALIB_EN 时，可在 ys_batch_init 之后对 batch->parser 调用 ys_parser_set_calib，
+ * 解码得到的 accel、angle、raw_mag 列即为标定后的结果；已解码的未标定列可使用 ys_calib_apply_batch。
+ *
+ * @author github0null
+ * @version 1.0
+ * @see https://github.com/github0null/
+*/
+
+#ifndef H_YS_BATCH
+#define H_YS_BATCH
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ys_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 列起始地址对齐（字节） */
+#ifndef YS_BATCH_ALIGN
+#define YS_BATCH_ALIGN 32
+#endif
+
+/* 坏帧的一次重新搜索最多恢复的帧数（缓存的字节中最多容纳的最短帧数），每列为此额外预留的行数 */
+#define YS_BATCH_SLACK (YS_BUFFER_SIZE / (YS_PARSER_MIN_MSG_LEN + 7))
+
+//////////////////////////////////////////////////////
+//                  Type Define
+//////////////////////////////////////////////////////
+
+/* 列选择 */
+typedef enum
+{
+    YS_BATCH_COL_TID                  = 1 << 0,
+    YS_BATCH_COL_SAMPLE_TIMESTAMP     = 1 << 1,
+    YS_BATCH_COL_DATA_READY_TIMESTAMP = 1 << 2,
+    YS_BATCH_COL_IMU_TEMP             = 1 << 3,
+    YS_BATCH_COL_ACCEL                = 1 << 4,
+    YS_BATCH_COL_ANGLE                = 1 << 5,
+    YS_BATCH_COL_MAG                  = 1 << 6,
+    YS_BATCH_COL_RAW_MAG              = 1 << 7,
+    YS_BATCH_COL_EULER                = 1 << 8,
+    YS_BATCH_COL_QUATERNION           = 1 << 9,
+    YS_BATCH_COL_QUATERNION_INC       = 1 << 10,
+    YS_BATCH_COL_LOCATION             = 1 << 11,
+    YS_BATCH_COL_VELOCITY             = 1 << 12,
+    YS_BATCH_COL_SPEED_INC            = 1 << 13,
+    YS_BATCH_COL_SECOND_IMU_TEMP      = 1 << 14, /* 选择任一第二颗 IMU 列时，解析器启用双 IMU 解析 */
+    YS_BATCH_COL_SECOND_ACCEL         = 1 << 15,
+    YS_BATCH_COL_SECOND_ANGLE         = 1 << 16,
+    YS_BATCH_COL_ALL                  = (1 << 17) - 1
+} ys_batch_column_t;
+
+typedef struct
+{
+    uint32_t capacity; /* 每次解码的行数，最多超出 YS_BATCH_SLACK 行，见 ys_batch_decode */
+    uint32_t row_cnt;  /* 已解码行数 */
+    uint32_t columns;  /* 已绑定的列，见 ys_batch_column_t */
+    uint32_t drop_cnt; /* 预留行也已用完时被丢弃的帧数，预留行数足够时始终为 0，仅用于检查 */
+
+    /* 列指针，未绑定的列为 NULL */
+    uint16_t *tid;
+    uint32_t *sample_timestamp;
+    uint32_t *data_ready_timestamp;
+    float *imu_temp;
+    float *accel[3];
+    float *angle[3];
+    float *mag[3];
+    float *raw_mag[3];
+    float *euler_angle[3];
+    float *quaternion[4];
+    float *quaternion_inc[4];
+    double *location[3];
+    float *velocity[3];
+    float *speed_inc[3];
+    float *second_imu_temp;
+    float *second_accel[3];
+    float *second_angle[3];
+
+    ys_parser_t parser;
+    ys_dual_imu_data_t dual_imu;
+} ys_batch_t;
+
+//////////////////////////////////////////////////////
+//                  Batch API
+//////////////////////////////////////////////////////
+
+/**
+ * 计算所需内存块大小
+ *
+ * @param capacity 行数
+ *
+ * @param columns 列选择，见 ys_batch_column_t
+ *
+ * @return 字节数（含 YS_BATCH_SLACK 行预留），内存块起始地址应按 YS_BATCH_ALIGN 对齐
+*/
+size_t ys_batch_block_size(uint32_t capacity, uint32_t columns);
+
+/**
+ * 初始化批量解码器，并将各列绑定到内存块中
+ *
+ * @param batch 批量解码器对象
+ *
+ * @param block 内存块，大小见 @ref ys_batch_block_size，为 NULL 时须在解码前调用 @ref ys_batch_bind
+ *
+ * @param capacity 行数
+ *
+ * @param columns 列选择，见 ys_batch_column_t
+*/
+void ys_batch_init(ys_batch_t *batch, void *block, uint32_t capacity, uint32_t columns);
+
+/**
+ * 将各列重新绑定到另一块内存并清空已解码的行，容量与列选择不变，解析器状态（未完成的半帧）保持不变
+ *
+ * 用于每次解码都交出一块新内存的场景（例如解码结果以 NumPy 数组的形式交给调用者，不再由解码器复用）
+ *
+ * @param batch 批量解码器对象
+ *
+ * @param block 内存块，大小见 @ref ys_batch_block_size
+*/
+void ys_batch_bind(ys_batch_t *batch, void *block);
+
+/**
+ * 清空已解码的行，解析器状态（未完成的半帧）与 drop_cnt 保持不变
+*/
+void ys_batch_clear(ys_batch_t *batch);
+
+/**
+ * 解码一段数据，直到数据结束或行数达到容量
+ *
+ * 行数最多超出容量 YS_BATCH_SLACK 行：行数将满时，一个坏帧触发的重新搜索可能一次恢复出多帧，
+ * 这些帧写入 ys_batch_block_size 预留的行中，不会丢弃（其字节已被消耗，下一次调用无法再解码）
+ *
+ * @param batch 批量解码器对象
+ *
+ * @param buf 原始数据
+ *
+ * @param len 数据长度
+ *
+ * @return 已处理的字节数，小于 len 时表示容量已满，清空或换用新的内存块后从该偏移继续
+*/
+size_t ys_batch_decode(ys_batch_t *batch, const uint8_t *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
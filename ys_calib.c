@@ -0,0 +1,285 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <ys_calib.h>
+#include <ys_parser.h>
+
+#define YS_CALIB_MAGIC 0x4C435359 /* "YSCL" */
+
+/* fixed part: magic, version, sensor_mask, ref_temp */
+#define CALIB_HEADER_LEN 12
+#define CALIB_SENSOR_LEN (15 * 4)
+#define CALIB_CHECK_LEN  2
+
+/* int32 -> physical unit, same as the factors used by the parser */
+static const float calib_raw_factor[YS_CALIB_SENSOR_NUM] = {
+    [YS_CALIB_ACCEL]   = 0.000001f,
+    [YS_CALIB_ANGLE]   = 0.000001f,
+    [YS_CALIB_RAW_MAG] = 0.001f,
+};
+
+//-------------------------- internal func ----------------------------------
+
+static void calib_fuse(ys_calib_vec3_t *cal, float factor);
+
+static uint32_t calib_read_u32(const uint8_t *buf);
+
+static float calib_read_f32(const uint8_t *buf);
+
+static void calib_write_u32(uint8_t *buf, uint32_t val);
+
+static void calib_write_f32(uint8_t *buf, float val);
+
+static void calib_kernel(const float *ys_restrict m, const float *ys_restrict b, const float *ys_restrict tc, float ref_temp,
+                         const float *ys_restrict temp,
+                         const float *ys_restrict ix, const float *ys_restrict iy, const float *ys_restrict iz,
+                         float *ys_restrict ox, float *ys_restrict oy, float *ys_restrict oz, uint32_t n);
+
+static void calib_kernel_const(const float *ys_restrict m, const float *ys_restrict b,
+                               const float *ys_restrict ix, const float *ys_restrict iy, const float *ys_restrict iz,
+                               float *ys_restrict ox, float *ys_restrict oy, float *ys_restrict oz, uint32_t n);
+
+//---------------------------------------------------------------------------
+
+void ys_calib_init(ys_calib_profile_t *profile, float ref_temp)
+{
+    memset(profile, 0, sizeof(ys_calib_profile_t));
+    profile->ref_temp = ref_temp;
+}
+
+void ys_calib_set(ys_calib_profile_t *profile, ys_calib_sensor_t sensor,
+                  const float matrix[9], const float bias[3], const float temp_coef[3])
+{
+    ys_calib_vec3_t *cal = &profile->sensor[sensor];
+
+    memset(cal, 0, sizeof(ys_calib_vec3_t));
+
+    if (matrix != NULL)
+        memcpy(cal->matrix, matrix, sizeof(cal->matrix));
+    else
+        cal->matrix[0] = cal->matrix[4] = cal->matrix[8] = 1.0f;
+
+    if (bias != NULL)
+        memcpy(cal->bias, bias, sizeof(cal->bias));
+
+    if (temp_coef != NULL)
+        memcpy(cal->temp_coef, temp_coef, sizeof(cal->temp_coef));
+
+    calib_fuse(cal, calib_raw_factor[sensor]);
+
+    profile->sensor_mask |= (uint16_t)(1u << sensor);
+}
+
+int ys_calib_load(ys_calib_profile_t *profile, const uint8_t *buf, size_t len)
+{
+    uint8_t crc[2];
+    uint16_t mask;
+    size_t off = CALIB_HEADER_LEN;
+
+    if (len < CALIB_HEADER_LEN + CALIB_CHECK_LEN ||
+        calib_read_u32(buf) != YS_CALIB_MAGIC ||
+        (uint16_t)(buf[4] | (buf[5] << 8)) != YS_CALIB_VERSION)
+    {
+        return -1;
+    }
+
+    mask = (uint16_t)(buf[6] | (buf[7] << 8));
+
+    if ((mask >> YS_CALIB_SENSOR_NUM) != 0)
+        return -1;
+
+    for (uint8_t i = 0; i < YS_CALIB_SENSOR_NUM; i++)
+    {
+        if (mask & (1u << i))
+            off += CALIB_SENSOR_LEN;
+    }
+
+    if (len != off + CALIB_CHECK_LEN)
+        return -1;
+
+    ys_checksum(buf, (uint32_t)off, crc);
+
+    if (crc[0] != buf[off] || crc[1] != buf[off + 1])
+        return -1;
+
+    ys_calib_init(profile, calib_read_f32(&buf[8]));
+
+    off = CALIB_HEADER_LEN;
+
+    for (uint8_t i = 0; i < YS_CALIB_SENSOR_NUM; i++)
+    {
+        float val[15];
+
+        if ((mask & (1u << i)) == 0)
+            continue;
+
+        for (uint8_t k = 0; k < 15; k++)
+            val[k] = calib_read_f32(&buf[off + k * 4]);
+
+        ys_calib_set(profile, (ys_calib_sensor_t)i, &val[0], &val[9], &val[12]);
+        off += CALIB_SENSOR_LEN;
+    }
+
+    return 0;
+}
+
+size_t ys_calib_save(const ys_calib_profile_t *profile, uint8_t *buf, size_t size)
+{
+    size_t need = CALIB_HEADER_LEN + CALIB_CHECK_LEN;
+    size_t off  = CALIB_HEADER_LEN;
+
+    for (uint8_t i = 0; i < YS_CALIB_SENSOR_NUM; i++)
+    {
+        if (profile->sensor_mask & (1u << i))
+            need += CALIB_SENSOR_LEN;
+    }
+
+    if (buf == NULL)
+        return need;
+
+    if (size < need)
+        return 0;
+
+    calib_write_u32(&buf[0], YS_CALIB_MAGIC);
+    buf[4] = (uint8_t)(YS_CALIB_VERSION & 0xFF);
+    buf[5] = (uint8_t)(YS_CALIB_VERSION >> 8);
+    buf[6] = (uint8_t)(profile->sensor_mask & 0xFF);
+    buf[7] = (uint8_t)(profile->sensor_mask >> 8);
+    calib_write_f32(&buf[8], profile->ref_temp);
+
+    for (uint8_t i = 0; i < YS_CALIB_SENSOR_NUM; i++)
+    {
+        const ys_calib_vec3_t *cal = &profile->sensor[i];
+
+        if ((profile->sensor_mask & (1u << i)) == 0)
+            continue;
+
+        for (uint8_t k = 0; k < 9; k++)
+            calib_write_f32(&buf[off + k * 4], cal->matrix[k]);
+
+        for (uint8_t k = 0; k < 3; k++)
+        {
+            calib_write_f32(&buf[off + (9 + k) * 4], cal->bias[k]);
+            calib_write_f32(&buf[off + (12 + k) * 4], cal->temp_coef[k]);
+        }
+
+        off += CALIB_SENSOR_LEN;
+    }
+
+    ys_checksum(buf, (uint32_t)off, &buf[off]);
+
+    return need;
+}
+
+void ys_calib_apply(const ys_calib_vec3_t *cal, const int32_t raw[3], float temp_delta, float out[3])
+{
+    const float *m = cal->fused;
+    float x = (float)raw[X], y = (float)raw[Y], z = (float)raw[Z];
+
+    out[X] = m[0] * x + m[1] * y + m[2] * z - (cal->bias[X] + cal->temp_coef[X] * temp_delta);
+    out[Y] = m[3] * x + m[4] * y + m[5] * z - (cal->bias[Y] + cal->temp_coef[Y] * temp_delta);
+    out[Z] = m[6] * x + m[7] * y + m[8] * z - (cal->bias[Z] + cal->temp_coef[Z] * temp_delta);
+}
+
+void ys_calib_apply_batch(const ys_calib_profile_t *profile, ys_calib_sensor_t sensor, const float *temp,
+                          const ys_vec3_soa_t *in, const ys_vec3_soa_t *out, uint32_t n)
+{
+    const ys_calib_vec3_t *cal = &profile->sensor[sensor];
+
+    if ((profile->sensor_mask & (1u << sensor)) == 0)
+    {
+        for (uint8_t i = 0; i < 3; i++)
+            memcpy(out->v[i], in->v[i], (size_t)n * sizeof(float));
+        return;
+    }
+
+    if (temp != NULL)
+    {
+        calib_kernel(cal->matrix, cal->bias, cal->temp_coef, profile->ref_temp, temp,
+                     in->v[X], in->v[Y], in->v[Z], out->v[X], out->v[Y], out->v[Z], n);
+    }
+    else
+    {
+        calib_kernel_const(cal->matrix, cal->bias,
+                           in->v[X], in->v[Y], in->v[Z], out->v[X], out->v[Y], out->v[Z], n);
+    }
+}
+
+//-------------------------- internal func ----------------------------------
+
+static void calib_fuse(ys_calib_vec3_t *cal, float factor)
+{
+    for (uint8_t i = 0; i < 9; i++)
+        cal->fused[i] = cal->matrix[i] * factor;
+}
+
+static uint32_t calib_read_u32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] |
+           ((uint32_t)buf[1] << 8) |
+           ((uint32_t)buf[2] << 16) |
+           ((uint32_t)buf[3] << 24);
+}
+
+static float calib_read_f32(const uint8_t *buf)
+{
+    uint32_t bits = calib_read_u32(buf);
+    float val;
+
+    memcpy(&val, &bits, sizeof(val));
+    return val;
+}
+
+static void calib_write_u32(uint8_t *buf, uint32_t val)
+{
+    buf[0] = (uint8_t)val;
+    buf[1] = (uint8_t)(val >> 8);
+    buf[2] = (uint8_t)(val >> 16);
+    buf[3] = (uint8_t)(val >> 24);
+}
+
+static void calib_write_f32(uint8_t *buf, float val)
+{
+    uint32_t bits;
+
+    memcpy(&bits, &val, sizeof(bits));
+    calib_write_u32(buf, bits);
+}
+
+static void calib_kernel(const float *ys_restrict m, const float *ys_restrict b, const float *ys_restrict tc, float ref_temp,
+                         const float *ys_restrict temp,
+                         const float *ys_restrict ix, const float *ys_restrict iy, const float *ys_restrict iz,
+                         float *ys_restrict ox, float *ys_restrict oy, float *ys_restrict oz, uint32_t n)
+{
+    /* coefficients in locals, so the loop only streams the columns */
+    float m0 = m[0], m1 = m[1], m2 = m[2], m3 = m[3], m4 = m[4], m5 = m[5], m6 = m[6], m7 = m[7], m8 = m[8];
+    float bx = b[X], by = b[Y], bz = b[Z];
+    float tx = tc[X], ty = tc[Y], tz = tc[Z];
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        float x = ix[i], y = iy[i], z = iz[i];
+        float dt = temp[i] - ref_temp;
+
+        ox[i] = m0 * x + m1 * y + m2 * z - (bx + tx * dt);
+        oy[i] = m3 * x + m4 * y + m5 * z - (by + ty * dt);
+        oz[i] = m6 * x + m7 * y + m8 * z - (bz + tz * dt);
+    }
+}
+
+static void calib_kernel_const(const float *ys_restrict m, const float *ys_restrict b,
+                               const float *ys_restrict ix, const float *ys_restrict iy, const float *ys_restrict iz,
+                               float *ys_restrict ox, float *ys_restrict oy, float *ys_restrict oz, uint32_t n)
+{
+    float m0 = m[0], m1 = m[1], m2 = m[2], m3 = m[3], m4 = m[4], m5 = m[5], m6 = m[6], m7 = m[7], m8 = m[8];
+    float bx = b[X], by = b[Y], bz = b[Z];
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        float x = ix[i], y = iy[i], z = iz[i];
+
+        ox[i] = m0 * x + m1 * y + m2 * z - bx;
+        oy[i] = m3 * x + m4 * y + m5 * z - by;
+        oz[i] = m6 * x + m7 * y + m8 * z - bz;
+    }
+}
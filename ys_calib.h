@@ -0,0 +1,157 @@
+/**
+ * Yesense 传感器标定
+ *
+ * 为加速度（accel）、角速度（angle）与原始磁场（raw_mag）提供逐台标定：
+ *
+ *   out = M * raw - (bias + temp_coef * (imu_temp - ref_temp))
+ *
+ * 其中 M 为 3x3 校正矩阵（比例因子与非正交误差），raw 为设备输出的物理量。
+ * 加载时 M 与协议中的整数比例因子合并为一个矩阵，解析器在解码字段时直接由 int32 原始值
+ * 一次乘加得到标定后的结果，不需要在回调之后再遍历一次数据。
+ *
+ * 标定配置以二进制格式保存（小端，与主机字节序无关）：
+ *
+ *   magic(4) 'YSCL' | version(2) | sensor_mask(2) | ref_temp(f32) |
+ *   { matrix(9 x f32) | bias(3 x f32) | temp_coef(3 x f32) } x 已启用的传感器（按 ys_calib_sensor_t 顺序） |
+ *   CK1 CK2（与协议帧相同的校验）
+ *
+ * 注意：
+ *  - 解析器需启用 YS_CALIB_EN，使用 ys_parser_set_calib 绑定配置
+ *  - 温度补偿使用解析器最近一次收到的 IMU 温度，尚未收到温度时不进行温度补偿
+ *
+ * @author github0null
+ * @version 1.0
+ * @see https://github.com/github0null/
+*/
+
+#ifndef H_YS_CALIB
+#define H_YS_CALIB
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ys_def.h"
+#include "ys_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define YS_CALIB_VERSION 1
+
+//////////////////////////////////////////////////////
+//                  Type Define
+//////////////////////////////////////////////////////
+
+typedef enum
+{
+    YS_CALIB_ACCEL = 0,
+    YS_CALIB_ANGLE,
+    YS_CALIB_RAW_MAG,
+    YS_CALIB_SENSOR_NUM
+} ys_calib_sensor_t;
+
+/* 单个三轴传感器的标定参数 */
+typedef struct
+{
+    float matrix[9];    /* 校正矩阵，行优先，作用于物理量 */
+    float bias[3];      /* 零偏，单位与输出相同 */
+    float temp_coef[3]; /* 零偏温度系数，单位：输出单位 / °C */
+    float fused[9];     /* matrix * 协议比例因子，作用于 int32 原始值，由 ys_calib_set 计算 */
+} ys_calib_vec3_t;
+
+typedef struct
+{
+    uint16_t sensor_mask; /* 已标定的传感器，(1 << ys_calib_sensor_t) */
+    float ref_temp;       /* 参考温度，单位：°C */
+    ys_calib_vec3_t sensor[YS_CALIB_SENSOR_NUM];
+} ys_calib_profile_t;
+
+//////////////////////////////////////////////////////
+//                  Calibration API
+//////////////////////////////////////////////////////
+
+/**
+ * 初始化标定配置，所有传感器均未标定
+ *
+ * @param ref_temp 参考温度，单位：°C
+*/
+void ys_calib_init(ys_calib_profile_t *profile, float ref_temp);
+
+/**
+ * 设置一个传感器的标定参数
+ *
+ * @param profile 标定配置
+ *
+ * @param sensor 传感器，见 ys_calib_sensor_t
+ *
+ * @param matrix 校正矩阵（行优先），为 NULL 时使用单位矩阵
+ *
+ * @param bias 零偏，为 NULL 时为 0
+ *
+ * @param temp_coef 零偏温度系数，为 NULL 时为 0
+*/
+void ys_calib_set(ys_calib_profile_t *profile, ys_calib_sensor_t sensor,
+                  const float matrix[9], const float bias[3], const float temp_coef[3]);
+
+/**
+ * 从内存中加载二进制标定配置
+ *
+ * @param profile 输出标定配置
+ *
+ * @param buf 配置数据
+ *
+ * @param len 数据长度
+ *
+ * @return 成功返回 0，格式、版本或校验错误返回 -1
+*/
+int ys_calib_load(ys_calib_profile_t *profile, const uint8_t *buf, size_t len);
+
+/**
+ * 将标定配置保存为二进制格式
+ *
+ * @param profile 标定配置
+ *
+ * @param buf 输出缓冲区，为 NULL 时仅计算所需长度
+ *
+ * @param size 缓冲区大小
+ *
+ * @return 写入（或需要）的字节数，缓冲区不足时返回 0
+*/
+size_t ys_calib_save(const ys_calib_profile_t *profile, uint8_t *buf, size_t size);
+
+/**
+ * 对一组 int32 原始值进行标定（解析器内部使用的融合乘加内核）
+ *
+ * @param cal 传感器标定参数
+ *
+ * @param raw 协议中的 int32 原始值
+ *
+ * @param temp_delta imu_temp - ref_temp
+ *
+ * @param out 输出物理量
+*/
+void ys_calib_apply(const ys_calib_vec3_t *cal, const int32_t raw[3], float temp_delta, float out[3]);
+
+/**
+ * 批量标定，用于对未标定的解码结果（例如 ys_batch 的列）进行重放
+ *
+ * @param profile 标定配置
+ *
+ * @param sensor 传感器，未标定时直接复制
+ *
+ * @param temp IMU 温度列，为 NULL 时不进行温度补偿
+ *
+ * @param in 输入向量块（物理量）
+ *
+ * @param out 输出向量块，不可与 in 重叠
+ *
+ * @param n 样本数
+*/
+void ys_calib_apply_batch(const ys_calib_profile_t *profile, ys_calib_sensor_t sensor, const float *temp,
+                          const ys_vec3_soa_t *in, const ys_vec3_soa_t *out, uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
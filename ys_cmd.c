@@ -0,0 +1,150 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <ys_cmd.h>
+
+#define YS_HEADER_1 0x59
+#define YS_HEADER_2 0x53
+
+/* offset of message field in frame */
+#define YS_MSG_OFFSET 5
+
+//---------------------------------------------------------------------------
+
+uint16_t ys_frame_encode(uint8_t *buf, uint16_t size, uint16_t tid, const uint8_t *msg, uint8_t msg_len)
+{
+    uint16_t frame_len = (uint16_t)(msg_len + YS_FRAME_OVERHEAD);
+
+    if (msg_len >= YS_MSG_MAX_LEN || size < frame_len)
+        return 0;
+
+    buf[0] = YS_HEADER_1;
+    buf[1] = YS_HEADER_2;
+    buf[2] = (uint8_t)(tid & 0xFF);
+    buf[3] = (uint8_t)(tid >> 8);
+    buf[4] = msg_len;
+
+    /* msg may already live in place */
+    if (&buf[YS_MSG_OFFSET] != msg)
+        memmove(&buf[YS_MSG_OFFSET], msg, msg_len);
+
+    ys_checksum(&buf[2], (uint32_t)msg_len + 3, &buf[YS_MSG_OFFSET + msg_len]);
+
+    return frame_len;
+}
+
+uint16_t ys_cmd_encode_output_content(uint8_t *buf, uint16_t size, uint16_t tid, uint8_t mode,
+                                      const uint8_t *ids, uint8_t id_cnt)
+{
+    uint8_t msg_len = (uint8_t)(id_cnt + 3);
+
+    if (id_cnt > YS_MSG_MAX_LEN - 4 || size < msg_len + YS_FRAME_OVERHEAD)
+        return 0;
+
+    uint8_t *msg = &buf[YS_MSG_OFFSET];
+
+    msg[0] = YS_CMD_CLASS_OUTPUT_CONTENT;
+    msg[1] = mode;
+    msg[2] = id_cnt;
+    memcpy(&msg[3], ids, id_cnt);
+
+    return ys_frame_encode(buf, size, tid, msg, msg_len);
+}
+
+uint16_t ys_cmd_encode_output_rate(uint8_t *buf, uint16_t size, uint16_t tid, uint8_t mode, uint16_t rate)
+{
+    uint8_t msg[4] = {
+        YS_CMD_CLASS_OUTPUT_RATE,
+        mode,
+        (uint8_t)(rate & 0xFF),
+        (uint8_t)(rate >> 8),
+    };
+
+    return ys_frame_encode(buf, size, tid, msg, sizeof(msg));
+}
+
+int ys_cmd_decode(const uint8_t *frame, uint16_t len, uint16_t *tid, uint8_t *cmd_class,
+                  const uint8_t **param, uint8_t *param_len)
+{
+    uint8_t crc[2];
+
+    if (len < YS_FRAME_OVERHEAD + 1 || frame[0] != YS_HEADER_1 || frame[1] != YS_HEADER_2)
+        return -1;
+
+    uint8_t msg_len = frame[4];
+
+    if (msg_len == 0 || len < msg_len + YS_FRAME_OVERHEAD)
+        return -1;
+
+    ys_checksum(&frame[2], (uint32_t)msg_len + 3, crc);
+
+    if (crc[0] != frame[YS_MSG_OFFSET + msg_len] || crc[1] != frame[YS_MSG_OFFSET + msg_len + 1])
+        return -1;
+
+    *tid       = (uint16_t)(frame[2] | ((uint16_t)frame[3] << 8));
+    *cmd_class = frame[YS_MSG_OFFSET];
+    *param     = &frame[YS_MSG_OFFSET + 1];
+    *param_len = (uint8_t)(msg_len - 1);
+
+    return 0;
+}
+
+int32_t ys_cmd_find_ack(const uint8_t *buf, uint32_t len, ys_cmd_ack_t *ack)
+{
+    for (uint32_t i = 0; i + YS_FRAME_OVERHEAD + 2 <= len; i++)
+    {
+        const uint8_t *param;
+        uint8_t param_len;
+
+        if (buf[i] != YS_HEADER_1 || buf[i + 1] != YS_HEADER_2 || buf[i + 4] != 2)
+            continue;
+
+        uint32_t remain = len - i;
+
+        if (ys_cmd_decode(&buf[i], (uint16_t)(remain > 0xFFFF ? 0xFFFF : remain),
+                          &ack->tid, &ack->cmd_class, &param, &param_len) == 0)
+        {
+            ack->status = param[0];
+            return (int32_t)(i + YS_FRAME_OVERHEAD + 2);
+        }
+    }
+
+    return -1;
+}
+
+uint16_t ys_output_frame_size(const uint8_t *ids, uint8_t id_cnt)
+{
+    uint16_t size = YS_FRAME_OVERHEAD;
+
+    for (uint8_t i = 0; i < id_cnt; i++)
+    {
+        uint8_t data_len = ys_data_id_len(ids[i]);
+
+        if (data_len == 0)
+            return 0;
+
+        size += 2 + data_len; /* id + len + data */
+    }
+
+    return size;
+}
+
+uint32_t ys_output_max_rate(uint32_t baud, const uint8_t *ids, uint8_t id_cnt)
+{
+    uint16_t frame_size = ys_output_frame_size(ids, id_cnt);
+
+    if (frame_size == 0)
+        return 0;
+
+    return baud / YS_UART_BITS_PER_BYTE / frame_size;
+}
+
+float ys_link_utilization(uint32_t baud, uint32_t rate, const uint8_t *ids, uint8_t id_cnt)
+{
+    uint16_t frame_size = ys_output_frame_size(ids, id_cnt);
+
+    if (frame_size == 0 || baud == 0)
+        return -1.0f;
+
+    return (float)frame_size * rate * YS_UART_BITS_PER_BYTE / (float)baud;
+}
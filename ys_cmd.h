@@ -0,0 +1,189 @@
+/**
+ * Yesense 配置指令编码与应答解析
+ *
+ * 配置指令与应答使用与输出报文相同的帧格式：
+ *
+ *   'Y' 'S' | TID(2) | LEN(1) | MESSAGE(LEN) | CK1 CK2
+ *
+ * 配置指令的 MESSAGE 字段为：
+ *
+ *   CLASS(1) | MODE(1) | PARAM...
+ *
+ * 应答的 MESSAGE 字段为：
+ *
+ *   CLASS(1) | STATUS(1)
+ *
+ * 指令类别与模式的取值见下方宏定义，若设备固件不同，可在 'ys_conf.h' 中覆盖。
+ *
+ * @author github0null
+ * @version 1.0
+ * @see https://github.com/github0null/
+*/
+
+#ifndef H_YS_CMD
+#define H_YS_CMD
+
+#include <stdint.h>
+#include "ys_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 指令类别：输出内容 */
+#ifndef YS_CMD_CLASS_OUTPUT_CONTENT
+#define YS_CMD_CLASS_OUTPUT_CONTENT 0x04
+#endif
+
+/* 指令类别：输出频率 */
+#ifndef YS_CMD_CLASS_OUTPUT_RATE
+#define YS_CMD_CLASS_OUTPUT_RATE 0x03
+#endif
+
+/* 指令模式：写入 RAM，立即生效，掉电丢失 */
+#ifndef YS_CMD_MODE_RAM
+#define YS_CMD_MODE_RAM 0x01
+#endif
+
+/* 指令模式：写入 FLASH，掉电保存 */
+#ifndef YS_CMD_MODE_FLASH
+#define YS_CMD_MODE_FLASH 0x02
+#endif
+
+/* 报文头、TID、LEN 与校验和的总长度 */
+#define YS_FRAME_OVERHEAD 7
+
+//////////////////////////////////////////////////////
+//                  Type Define
+//////////////////////////////////////////////////////
+
+typedef struct
+{
+    uint16_t tid;
+    uint8_t cmd_class; /* 应答的指令类别 */
+    uint8_t status;    /* 应答状态，0 表示成功 */
+} ys_cmd_ack_t;
+
+//////////////////////////////////////////////////////
+//                  Command API
+//////////////////////////////////////////////////////
+
+/**
+ * 将 message 字段封装为一帧完整的 YS 报文
+ *
+ * @param buf 输出缓冲区
+ *
+ * @param size 输出缓冲区大小
+ *
+ * @param tid 报文 TID
+ *
+ * @param msg message 字段
+ *
+ * @param msg_len message 字段长度
+ *
+ * @return 报文长度，缓冲区不足或 msg_len 超出范围时返回 0
+*/
+uint16_t ys_frame_encode(uint8_t *buf, uint16_t size, uint16_t tid, const uint8_t *msg, uint8_t msg_len);
+
+/**
+ * 编码“设置输出内容”指令
+ *
+ * @param buf 输出缓冲区
+ *
+ * @param size 输出缓冲区大小
+ *
+ * @param tid 报文 TID
+ *
+ * @param mode 指令模式，YS_CMD_MODE_RAM 或 YS_CMD_MODE_FLASH
+ *
+ * @param ids 需要输出的数据 ID 列表，见 @ref ys_data_id_t
+ *
+ * @param id_cnt 数据 ID 数量
+ *
+ * @return 报文长度，失败返回 0
+*/
+uint16_t ys_cmd_encode_output_content(uint8_t *buf, uint16_t size, uint16_t tid, uint8_t mode,
+                                      const uint8_t *ids, uint8_t id_cnt);
+
+/**
+ * 编码“设置输出频率”指令
+ *
+ * @param rate 输出频率，单位：Hz
+ *
+ * @return 报文长度，失败返回 0
+*/
+uint16_t ys_cmd_encode_output_rate(uint8_t *buf, uint16_t size, uint16_t tid, uint8_t mode, uint16_t rate);
+
+/**
+ * 解析配置指令或应答报文
+ *
+ * @param frame 一帧完整报文，从 'YS' 开始
+ *
+ * @param len 报文长度
+ *
+ * @param tid 输出报文 TID
+ *
+ * @param cmd_class 输出指令类别
+ *
+ * @param param 输出参数起始地址（指向 frame 内部，CLASS 字节之后）
+ *
+ * @param param_len 输出参数长度
+ *
+ * @return 成功返回 0，格式或校验错误返回 -1
+*/
+int ys_cmd_decode(const uint8_t *frame, uint16_t len, uint16_t *tid, uint8_t *cmd_class,
+                  const uint8_t **param, uint8_t *param_len);
+
+/**
+ * 在接收缓冲区中查找第一帧应答
+ *
+ * @param buf 接收缓冲区
+ *
+ * @param len 接收缓冲区长度
+ *
+ * @param ack 输出应答
+ *
+ * @return 找到时返回应答帧之后的偏移，否则返回 -1
+*/
+int32_t ys_cmd_find_ack(const uint8_t *buf, uint32_t len, ys_cmd_ack_t *ack);
+
+//////////////////////////////////////////////////////
+//                  Link Budget
+//////////////////////////////////////////////////////
+
+/**
+ * 计算输出报文长度
+ *
+ * @param ids 数据 ID 列表
+ *
+ * @param id_cnt 数据 ID 数量
+ *
+ * @return 一帧输出报文的字节数，包含未知 ID 时返回 0
+*/
+uint16_t ys_output_frame_size(const uint8_t *ids, uint8_t id_cnt);
+
+/**
+ * 计算给定波特率下的最大输出频率
+ *
+ * @param baud 波特率
+ *
+ * @return 最大输出频率，单位：Hz，包含未知 ID 时返回 0
+*/
+uint32_t ys_output_max_rate(uint32_t baud, const uint8_t *ids, uint8_t id_cnt);
+
+/**
+ * 计算链路占用率
+ *
+ * @param baud 波特率
+ *
+ * @param rate 输出频率，单位：Hz
+ *
+ * @return 链路占用率，1.0 表示占满，包含未知 ID 时返回负数
+*/
+float ys_link_utilization(uint32_t baud, uint32_t rate, const uint8_t *ids, uint8_t id_cnt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -39,14 +39,131 @@
 #define ys_static_inline static
 #endif
 
+/* restrict 关键字，用于批量计算函数，帮助编译器进行向量化 */
+#ifndef ys_restrict
+#if defined(_MSC_VER)
+#define ys_restrict __restrict
+#else
+#define ys_restrict restrict
+#endif
+#endif
+
 /* 报文中 message 字段最小长度，小于此值的报文将被忽略 */
 #ifndef YS_PARSER_MIN_MSG_LEN
 #define YS_PARSER_MIN_MSG_LEN 4
 #endif
 
-/* 解析第二颗 IMU 输出 */
-#ifdef YS_DUAL_IMU_EN
-#define YS_HAS_DUAL_IMU
+/**
+ * 延迟解析
+ *
+ * 启用后可在中断中使用 ys_parser_input_chunk 输入数据，中断内仅做帧头搜索与校验，
+ * TLV 解码与回调函数推迟到 ys_parser_poll 中执行
+ */
+#ifdef YS_DEFER_PARSE_EN
+#define YS_HAS_DEFER_PARSE
+#endif
+
+/* 延迟解析队列深度（帧数），队列满时新帧将被丢弃，队列下标为 uint8_t，取值 1 ~ 254 */
+#ifndef YS_DEFER_QUEUE_SIZE
+#define YS_DEFER_QUEUE_SIZE 2
+#endif
+
+#if YS_DEFER_QUEUE_SIZE < 1 || YS_DEFER_QUEUE_SIZE > 254
+#error "YS_DEFER_QUEUE_SIZE must be in 1 ~ 254"
+#endif
+
+/**
+ * 报文布局缓存
+ *
+ * 设备配置固定后每帧的字段序列完全相同，连续收到该数量的相同布局的帧后，解析器缓存字段偏移，
+ * 之后的帧只需比较各字段头即可按固定偏移解码；布局变化时自动回退到逐字段解析并重新学习。
+ * 定义为 0 以禁用
+ */
+#ifndef YS_LAYOUT_LEARN_CNT
+#define YS_LAYOUT_LEARN_CNT 4
+#endif
+
+#if YS_LAYOUT_LEARN_CNT > 0
+#define YS_HAS_LAYOUT_CACHE
+#endif
+
+/* 报文布局缓存最多字段数，字段更多的报文不进行缓存 */
+#ifndef YS_LAYOUT_MAX_FIELDS
+#define YS_LAYOUT_MAX_FIELDS 16
+#endif
+
+/* 报文 TID 后退不超过该值时视为乱序（迟到的帧），否则视为序列重新开始 */
+#ifndef YS_SEQ_MAX_MISORDER
+#define YS_SEQ_MAX_MISORDER 32
+#endif
+
+/* 报文 TID 前跳超过该值时视为序列重新开始（例如设备重启），不计入丢帧 */
+#ifndef YS_SEQ_MAX_DROPOUT
+#define YS_SEQ_MAX_DROPOUT 3000
+#endif
+
+/* 丢帧率统计窗口（应收帧数） */
+#ifndef YS_SEQ_WINDOW
+#define YS_SEQ_WINDOW 256
+#endif
+
+/* 链路占用率达到该值（千分比）时视为饱和 */
+#ifndef YS_LINK_SATURATION_PERMILLE
+#define YS_LINK_SATURATION_PERMILLE 900
+#endif
+
+/* 串口每字节传输位数（8N1：起始位 + 8 数据位 + 停止位） */
+#ifndef YS_UART_BITS_PER_BYTE
+#define YS_UART_BITS_PER_BYTE 10
+#endif
+
+/**
+ * 传感器标定（见 ys_calib.h）
+ *
+ * 启用后解析器在解码 accel、angle、raw_mag 字段时直接应用绑定的标定配置
+ */
+#ifdef YS_CALIB_EN
+#define YS_HAS_CALIB
+#endif
+
+/**
+ * USDT 静态探针（仅 Linux，需要 systemtap 提供的 <sys/sdt.h>）
+ *
+ * 启用后在解析路径上插入探针，探针未被跟踪时仅为一条 nop 指令；
+ * 跟踪脚本见 tools/ 目录，探针的第一个参数均为解析器指针，可用于区分不同的传感器
+ *
+ * 探针列表（provider: ys_parser）：
+ *   frame_start    (parser)                      收到帧头 'YS'
+ *   chk_err        (parser, tid, len)            校验错误
+ *   len_err        (parser, tid, len)            报文长度错误
+ *   resync         (parser, skip, replay_len)    从坏帧中跳过 skip 字节后重新搜索帧头
+ *   frame_done     (parser, tid, len, field_cnt) 一帧解码完成
+ *   callback_entry (parser, tid)                 进入回调函数
+ *   callback_exit  (parser, tid)                 回调函数返回
+ */
+#ifdef YS_USDT_EN
+#define YS_HAS_USDT
+#endif
+
+#ifdef YS_HAS_USDT
+#include <sys/sdt.h>
+#define ys_probe1(name, a1)             DTRACE_PROBE1(ys_parser, name, a1)
+#define ys_probe2(name, a1, a2)         DTRACE_PROBE2(ys_parser, name, a1, a2)
+#define ys_probe3(name, a1, a2, a3)     DTRACE_PROBE3(ys_parser, name, a1, a2, a3)
+#define ys_probe4(name, a1, a2, a3, a4) DTRACE_PROBE4(ys_parser, name, a1, a2, a3, a4)
+#else
+#ifndef ys_probe1
+#define ys_probe1(name, a1) ((void)0)
+#endif
+#ifndef ys_probe2
+#define ys_probe2(name, a1, a2) ((void)0)
+#endif
+#ifndef ys_probe3
+#define ys_probe3(name, a1, a2, a3) ((void)0)
+#endif
+#ifndef ys_probe4
+#define ys_probe4(name, a1, a2, a3, a4) ((void)0)
+#endif
 #endif
 
 #ifndef ys_critical_enter
@@ -57,6 +174,24 @@
 #define ys_critical_exit()
 #endif
 
+/**
+ * 跨线程 / 中断共享变量的发布与读取
+ *
+ * ys_store_release 之前的写入，对通过 ys_load_acquire 读到该值的一方一定可见，
+ * 用于单生产者单消费者队列的索引以及可热替换的指针。
+ * 默认使用 GCC / Clang 的 __atomic 内建函数，其他编译器退化为普通访问（相关变量均声明为 volatile，
+ * 适用于单核 MCU 以及 MSVC 的默认 volatile 语义），其他多核平台请在 'ys_conf.h' 中提供等价实现
+ */
+#if !defined(ys_load_acquire) || !defined(ys_store_release)
+#if defined(__GNUC__) || defined(__clang__)
+#define ys_load_acquire(ptr)       __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define ys_store_release(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#else
+#define ys_load_acquire(ptr)       (*(ptr))
+#define ys_store_release(ptr, val) (*(ptr) = (val))
+#endif
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -150,8 +285,11 @@ typedef struct
     /* 速度增量，单位：m/s */
     float speed_inc[3];
 
-#ifdef YS_HAS_DUAL_IMU
+} ys_sensor_data_t;
 
+/* 第二颗 IMU 输出，按解析器实例启用，见 ys_parser_enable_dual_imu */
+typedef struct
+{
     /* 第二颗 IMU 温度，单位：°C */
     float second_imu_temp;
 
@@ -161,9 +299,7 @@ typedef struct
     /* 第二颗 IMU 角速度，单位：deg/s */
     float second_angle[3];
 
-#endif // YS_HAS_DUAL_IMU
-
-} ys_sensor_data_t;
+} ys_dual_imu_data_t;
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,514 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <ys_health.h>
+
+#define HEALTH_ALIGN 32
+
+#define health_align(_size) (((_size) + HEALTH_ALIGN - 1) & ~(size_t)(HEALTH_ALIGN - 1))
+
+/* all ones when _cond holds, else 0 */
+#define HEALTH_MASK(_cond) (0u - (uint32_t)(_cond))
+
+/* stage slots after the six vector channels */
+#define HEALTH_STAGE_TEMP YS_HEALTH_VEC_CH
+#define HEALTH_STAGE_QUAT (YS_HEALTH_VEC_CH + 1)
+
+//-------------------------- type define  -----------------------------------
+
+/* per channel parameters of health_vec_kernel, disabled checks can never fire */
+typedef struct
+{
+    float alpha;
+    float limit;
+    uint32_t stuck;  /* >= 1 */
+    float jump_k2;
+    float jump_min2;
+    uint32_t warmup;
+    uint32_t window; /* 1 ~ 2^24 */
+    uint32_t n_max;  /* the sample count saturates here, max(warmup, window) */
+    uint32_t bit_stuck, bit_sat, bit_jump;
+} ys_health_vec_param_t;
+
+//-------------------------- internal func ----------------------------------
+
+static size_t health_layout(ys_health_t *health, uint8_t *block);
+
+static void health_clear_stage(ys_health_t *health);
+
+static void health_vec_kernel(const float *ys_restrict x, uint32_t *ys_restrict n, float *ys_restrict mean, float *ys_restrict var,
+                              float *ys_restrict ema, float *ys_restrict last, uint32_t *ys_restrict run,
+                              uint32_t *ys_restrict flags, const ys_health_vec_param_t *param, uint32_t cnt);
+
+static void health_temp_kernel(const float *ys_restrict x, uint32_t *ys_restrict n, float *ys_restrict ema, float *ys_restrict ref,
+                               uint32_t *ys_restrict flags, float alpha, float limit, uint32_t warmup, uint32_t bit, uint32_t cnt);
+
+static void health_quat_kernel(const float *ys_restrict q0, const float *ys_restrict q1, const float *ys_restrict q2,
+                               const float *ys_restrict q3, uint32_t *ys_restrict flags, float lo2, float hi2, uint32_t bit,
+                               uint32_t cnt);
+
+static void health_emit(ys_health_t *health, uint16_t sensor, uint32_t changed, const ys_health_input_t *input, uint32_t row);
+
+ys_static_inline float health_select(uint32_t mask, float a, float b);
+
+ys_static_inline uint32_t health_min(uint32_t a, uint32_t b);
+
+//---------------------------------------------------------------------------
+
+ys_health_t *ys_health_create(const ys_health_config_t *config, uint16_t sensor_cnt)
+{
+    ys_health_t layout;
+    ys_health_t *health;
+
+    if (sensor_cnt == 0)
+        return NULL;
+
+    memset(&layout, 0, sizeof(layout));
+    layout.config     = *config;
+    layout.sensor_cnt = sensor_cnt;
+    layout.sensor_pad = (uint16_t)((sensor_cnt + 7u) & ~7u);
+
+    if (layout.config.warmup == 0)
+        layout.config.warmup = 1;
+
+    if (layout.config.window == 0)
+        layout.config.window = YS_HEALTH_WINDOW;
+
+    if (layout.config.window > (1u << 24))
+        layout.config.window = 1u << 24;
+
+    size_t size    = health_align(sizeof(ys_health_t)) + health_layout(&layout, NULL) + HEALTH_ALIGN;
+    uint8_t *block = ys_malloc(size);
+
+    if (block == NULL)
+        return NULL;
+
+    memset(block, 0, size);
+
+    health  = (ys_health_t *)block;
+    *health = layout;
+
+    uintptr_t arrays = ((uintptr_t)block + sizeof(ys_health_t) + HEALTH_ALIGN - 1) & ~(uintptr_t)(HEALTH_ALIGN - 1);
+    health_layout(health, (uint8_t *)arrays);
+
+    health_clear_stage(health);
+
+    return health;
+}
+
+void ys_health_free(ys_health_t *health)
+{
+    ys_free(health);
+}
+
+void ys_health_reset(ys_health_t *health, uint16_t sensor)
+{
+    for (uint8_t ch = 0; ch < YS_HEALTH_VEC_CH; ch++)
+    {
+        health->n[ch][sensor]    = 0;
+        health->mean[ch][sensor] = 0.0f;
+        health->var[ch][sensor]  = 0.0f;
+        health->ema[ch][sensor]  = 0.0f;
+        health->last[ch][sensor] = 0.0f;
+        health->run[ch][sensor]  = 0;
+    }
+
+    health->temp_n[sensor]     = 0;
+    health->temp_ema[sensor]   = 0.0f;
+    health->temp_ref[sensor]   = 0.0f;
+    health->flags[sensor]      = 0;
+    health->prev_flags[sensor] = 0;
+
+    memset(&health->stats[sensor], 0, sizeof(ys_health_stat_t));
+}
+
+void ys_health_update(ys_health_t *health, const ys_health_input_t *input, uint32_t steps)
+{
+    const ys_health_config_t *config = &health->config;
+    uint32_t cnt                     = health->sensor_cnt;
+    ys_health_vec_param_t param[2];
+
+    /* [0]: accel, [1]: angle */
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        float limit = i == 0 ? config->accel_limit : config->angle_limit;
+
+        param[i].alpha     = config->ema_alpha;
+        param[i].limit     = limit > 0.0f ? limit : INFINITY;
+        param[i].stuck     = config->stuck_cnt > 0 ? config->stuck_cnt : 1;
+        param[i].jump_k2   = config->jump_sigma * config->jump_sigma;
+        param[i].jump_min2 = config->jump_min[i] * config->jump_min[i];
+        param[i].warmup    = config->warmup;
+        param[i].window    = config->window;
+        param[i].n_max     = config->warmup > config->window ? config->warmup : config->window;
+    }
+
+    float temp_limit = config->temp_drift > 0.0f ? config->temp_drift : INFINITY;
+    float quat_lo2   = config->quat_tol > 0.0f ? (1.0f - config->quat_tol) * (1.0f - config->quat_tol) : -INFINITY;
+    float quat_hi2   = config->quat_tol > 0.0f ? (1.0f + config->quat_tol) * (1.0f + config->quat_tol) : INFINITY;
+
+    for (uint32_t t = 0; t < steps; t++)
+    {
+        size_t row = (size_t)t * cnt;
+
+        for (uint8_t ch = 0; ch < YS_HEALTH_VEC_CH; ch++)
+        {
+            const float *x = ch < 3 ? input->accel[ch] : input->angle[ch - 3];
+            ys_health_vec_param_t *p = &param[ch < 3 ? 0 : 1];
+
+            if (x == NULL)
+                continue;
+
+            /* a disabled check has no flag bit */
+            p->bit_stuck = config->stuck_cnt > 0 ? YS_HEALTH_FLAG(YS_HEALTH_STUCK, ch) : 0;
+            p->bit_sat   = YS_HEALTH_FLAG(YS_HEALTH_SATURATED, ch);
+            p->bit_jump  = config->jump_sigma > 0.0f ? YS_HEALTH_FLAG(YS_HEALTH_BIAS_JUMP, ch) : 0;
+
+            health_vec_kernel(&x[row], health->n[ch], health->mean[ch], health->var[ch],
+                              health->ema[ch], health->last[ch], health->run[ch], health->flags, p, cnt);
+        }
+
+        if (input->imu_temp != NULL)
+        {
+            health_temp_kernel(&input->imu_temp[row], health->temp_n, health->temp_ema, health->temp_ref, health->flags,
+                               config->temp_alpha, temp_limit, config->warmup,
+                               YS_HEALTH_FLAG(YS_HEALTH_TEMP_DRIFT, 0), cnt);
+        }
+
+        if (input->quaternion[0] != NULL)
+        {
+            health_quat_kernel(&input->quaternion[0][row], &input->quaternion[1][row],
+                               &input->quaternion[2][row], &input->quaternion[3][row],
+                               health->flags, quat_lo2, quat_hi2, YS_HEALTH_FLAG(YS_HEALTH_QUAT_NORM, 0), cnt);
+        }
+
+        /* fault state changes are rare, only those sensors take the slow path */
+        for (uint16_t s = 0; s < cnt; s++)
+        {
+            uint32_t changed = health->flags[s] ^ health->prev_flags[s];
+
+            if (changed != 0)
+            {
+                health_emit(health, s, changed, input, (uint32_t)row + s);
+                health->prev_flags[s] = health->flags[s];
+            }
+        }
+
+        health->step++;
+    }
+}
+
+void ys_health_stage(ys_health_t *health, uint16_t sensor, const ys_sensor_data_t *data, uint8_t field_mask)
+{
+    for (uint8_t k = 0; k < 3; k++)
+    {
+        if (field_mask & YS_HEALTH_FIELD_ACCEL)
+            health->stage[YS_HEALTH_ACCEL_X + k][sensor] = data->accel[k];
+
+        if (field_mask & YS_HEALTH_FIELD_ANGLE)
+            health->stage[YS_HEALTH_ANGLE_X + k][sensor] = data->angle[k];
+    }
+
+    if (field_mask & YS_HEALTH_FIELD_TEMP)
+        health->stage[HEALTH_STAGE_TEMP][sensor] = data->imu_temp;
+
+    if (field_mask & YS_HEALTH_FIELD_QUAT)
+    {
+        for (uint8_t k = 0; k < 4; k++)
+            health->stage[HEALTH_STAGE_QUAT + k][sensor] = data->quaternion[k];
+    }
+}
+
+void ys_health_commit(ys_health_t *health)
+{
+    ys_health_input_t input;
+
+    for (uint8_t k = 0; k < 3; k++)
+    {
+        input.accel[k] = health->stage[YS_HEALTH_ACCEL_X + k];
+        input.angle[k] = health->stage[YS_HEALTH_ANGLE_X + k];
+    }
+
+    input.imu_temp = health->stage[HEALTH_STAGE_TEMP];
+
+    for (uint8_t k = 0; k < 4; k++)
+        input.quaternion[k] = health->stage[HEALTH_STAGE_QUAT + k];
+
+    ys_health_update(health, &input, 1);
+
+    health_clear_stage(health);
+}
+
+bool ys_health_pop_event(ys_health_t *health, ys_health_event_t *event)
+{
+    if (health->event_head == health->event_tail)
+        return false;
+
+    *event              = health->events[health->event_tail];
+    health->event_tail  = (uint16_t)((health->event_tail + 1) % YS_HEALTH_EVENT_CNT);
+
+    return true;
+}
+
+//-------------------------- internal func ----------------------------------
+
+/* assign the arrays from 'block', or only compute the size when 'block' is NULL */
+static size_t health_layout(ys_health_t *health, uint8_t *block)
+{
+    size_t off = 0;
+
+#define HEALTH_TAKE(_ptr, _type, _cnt)                        \
+    do {                                                      \
+        if (block != NULL) (_ptr) = (_type *)(block + off);   \
+        off += health_align((size_t)(_cnt) * sizeof(_type));  \
+    } while (0)
+
+    for (uint8_t ch = 0; ch < YS_HEALTH_VEC_CH; ch++)
+    {
+        HEALTH_TAKE(health->n[ch], uint32_t, health->sensor_pad);
+        HEALTH_TAKE(health->mean[ch], float, health->sensor_pad);
+        HEALTH_TAKE(health->var[ch], float, health->sensor_pad);
+        HEALTH_TAKE(health->ema[ch], float, health->sensor_pad);
+        HEALTH_TAKE(health->last[ch], float, health->sensor_pad);
+        HEALTH_TAKE(health->run[ch], uint32_t, health->sensor_pad);
+    }
+
+    HEALTH_TAKE(health->temp_n, uint32_t, health->sensor_pad);
+    HEALTH_TAKE(health->temp_ema, float, health->sensor_pad);
+    HEALTH_TAKE(health->temp_ref, float, health->sensor_pad);
+    HEALTH_TAKE(health->flags, uint32_t, health->sensor_pad);
+    HEALTH_TAKE(health->prev_flags, uint32_t, health->sensor_pad);
+
+    for (uint8_t i = 0; i < YS_HEALTH_VEC_CH + 5; i++)
+        HEALTH_TAKE(health->stage[i], float, health->sensor_pad);
+
+    HEALTH_TAKE(health->stats, ys_health_stat_t, health->sensor_cnt);
+
+#undef HEALTH_TAKE
+
+    return off;
+}
+
+static void health_clear_stage(ys_health_t *health)
+{
+    for (uint8_t i = 0; i < YS_HEALTH_VEC_CH + 5; i++)
+    {
+        for (uint16_t s = 0; s < health->sensor_pad; s++)
+            health->stage[i][s] = NAN;
+    }
+}
+
+static void health_vec_kernel(const float *ys_restrict x, uint32_t *ys_restrict n, float *ys_restrict mean, float *ys_restrict var,
+                              float *ys_restrict ema, float *ys_restrict last, uint32_t *ys_restrict run,
+                              uint32_t *ys_restrict flags, const ys_health_vec_param_t *param, uint32_t cnt)
+{
+    float alpha        = param->alpha;
+    float limit        = param->limit;
+    uint32_t stuck     = param->stuck;
+    float jump_k2      = param->jump_k2;
+    float jump_min2    = param->jump_min2;
+    uint32_t warmup    = param->warmup;
+    uint32_t window    = param->window;
+    uint32_t n_max     = param->n_max;
+    uint32_t bit_stuck = param->bit_stuck;
+    uint32_t bit_sat   = param->bit_sat;
+    uint32_t bit_jump  = param->bit_jump;
+    uint32_t bits      = bit_stuck | bit_sat | bit_jump;
+
+    /*
+     * every select is mask arithmetic on values loaded up front: a '?:' lets gcc branch
+     * (jump threading), and a branch or a conditional load stops the SSE2 vectorizer
+     */
+    for (uint32_t s = 0; s < cnt; s++)
+    {
+        float v      = x[s];
+        uint32_t n0  = n[s];
+        float mean0  = mean[s];
+        float var0   = var[s];
+        float ema0   = ema[s];
+        float last0  = last[s];
+        uint32_t r0  = run[s];
+        uint32_t fl0 = flags[s];
+
+        uint32_t valid = HEALTH_MASK(v == v); /* NaN: missing */
+        uint32_t w     = valid & 1u;
+        float wf       = (float)(int32_t)w;
+        float xv       = health_select(valid, v, mean0);
+        uint32_t nv    = n0 + (w & HEALTH_MASK(n0 < n_max));
+
+        /*
+         * cumulative mean and population variance for the first 'window' samples,
+         * then an exponential average with a = 1 / window. a is 0 for a missing sample,
+         * everything is left unchanged
+         */
+        uint32_t k = health_min(nv, window);
+        float a    = wf / (float)(int32_t)(k + (k == 0));
+        float d    = xv - mean0;
+        float mu   = mean0 + a * d;
+        float vr   = (1.0f - a) * (var0 + a * d * d);
+
+        mean[s] = mu;
+        var[s]  = vr;
+        n[s]    = nv;
+
+        /* the first sample initializes the ema */
+        float b = wf * health_select(HEALTH_MASK(n0 == 0), 1.0f, alpha);
+        float e = ema0 + b * (xv - ema0);
+        ema[s]  = e;
+
+        /* 'last' only holds a sample once the first valid one was seen */
+        uint32_t r = (r0 + 1) & HEALTH_MASK(xv == last0) & HEALTH_MASK(n0 > 0);
+        r          = health_min(r, stuck - 1); /* saturate, r + 1 can not wrap */
+        r          = (r & valid) | (r0 & ~valid);
+        run[s]     = r;
+        last[s]    = health_select(valid, v, last0);
+
+        /* (ema - mean)^2 > k^2 * var + min^2 */
+        float dj  = e - mu;
+        float lhs = dj * dj;
+        float rhs = jump_k2 * vr + jump_min2;
+
+        /* r counts the repeats, r + 1 equal samples in a row */
+        uint32_t f = (bit_stuck & HEALTH_MASK(r + 1 >= stuck)) |
+                     (bit_sat & HEALTH_MASK(fabsf(xv) >= limit)) |
+                     (bit_jump & HEALTH_MASK(lhs > rhs) & HEALTH_MASK(nv >= warmup));
+
+        uint32_t keep = ~(bits & valid);
+
+        flags[s] = (fl0 & keep) | (f & ~keep);
+    }
+}
+
+static void health_temp_kernel(const float *ys_restrict x, uint32_t *ys_restrict n, float *ys_restrict ema, float *ys_restrict ref,
+                               uint32_t *ys_restrict flags, float alpha, float limit, uint32_t warmup, uint32_t bit, uint32_t cnt)
+{
+    for (uint32_t s = 0; s < cnt; s++)
+    {
+        float t      = x[s];
+        uint32_t n0  = n[s];
+        float ema0   = ema[s];
+        float ref0   = ref[s];
+        uint32_t fl0 = flags[s];
+
+        uint32_t valid = HEALTH_MASK(t == t);
+        uint32_t nv    = n0 + (valid & 1u & HEALTH_MASK(n0 < warmup)); /* stops at warmup */
+        float tv       = health_select(valid, t, ema0); /* a missing sample leaves the ema unchanged */
+        float a        = health_select(HEALTH_MASK(n0 == 0), 1.0f, alpha);
+        float e        = ema0 + a * (tv - ema0);
+
+        /* the baseline is the smoothed temperature when the warmup ends */
+        float r = health_select(valid & HEALTH_MASK(n0 + 1 == warmup), e, ref0);
+
+        n[s]   = nv;
+        ema[s] = e;
+        ref[s] = r;
+
+        uint32_t f    = bit & HEALTH_MASK(fabsf(e - r) > limit) & HEALTH_MASK(nv >= warmup);
+        uint32_t keep = ~(bit & valid);
+
+        flags[s] = (fl0 & keep) | (f & ~keep);
+    }
+}
+
+static void health_quat_kernel(const float *ys_restrict q0, const float *ys_restrict q1, const float *ys_restrict q2,
+                               const float *ys_restrict q3, uint32_t *ys_restrict flags, float lo2, float hi2, uint32_t bit,
+                               uint32_t cnt)
+{
+    for (uint32_t s = 0; s < cnt; s++)
+    {
+        /* compare the squared norm, no sqrt */
+        float n2      = q0[s] * q0[s] + q1[s] * q1[s] + q2[s] * q2[s] + q3[s] * q3[s];
+        uint32_t lo   = n2 < lo2 ? bit : 0;
+        uint32_t hi   = n2 > hi2 ? bit : 0;
+        uint32_t keep = n2 == n2 ? ~bit : ~0u;
+
+        flags[s] = (flags[s] & keep) | lo | hi; /* NaN compares false */
+    }
+}
+
+static void health_emit(ys_health_t *health, uint16_t sensor, uint32_t changed, const ys_health_input_t *input, uint32_t row)
+{
+    ys_health_stat_t *stat = &health->stats[sensor];
+    uint32_t flags         = health->flags[sensor];
+
+    stat->flags = flags;
+
+    for (uint8_t b = 0; b < 32; b++)
+    {
+        uint32_t bit = 1u << b;
+
+        if ((changed & bit) == 0)
+            continue;
+
+        ys_health_event_t event = {
+            .step   = health->step,
+            .sensor = sensor,
+            .active = (flags & bit) ? 1 : 0,
+        };
+
+        if (b < 3 * YS_HEALTH_VEC_CH)
+        {
+            event.check   = (uint8_t)(b / YS_HEALTH_VEC_CH);
+            event.channel = (uint8_t)(b % YS_HEALTH_VEC_CH);
+
+            if (event.check == YS_HEALTH_BIAS_JUMP)
+                event.value = health->ema[event.channel][sensor] - health->mean[event.channel][sensor];
+            else
+                event.value = health->last[event.channel][sensor];
+        }
+        else
+        {
+            event.check = (uint8_t)(YS_HEALTH_TEMP_DRIFT + b - 3 * YS_HEALTH_VEC_CH);
+
+            if (event.check == YS_HEALTH_TEMP_DRIFT)
+            {
+                event.value = health->temp_ema[sensor] - health->temp_ref[sensor];
+            }
+            else
+            {
+                float n2 = 0.0f;
+
+                for (uint8_t k = 0; k < 4; k++)
+                    n2 += input->quaternion[k][row] * input->quaternion[k][row];
+
+                event.value = n2;
+            }
+        }
+
+        if (event.active)
+            stat->fault_cnt[event.check]++;
+
+        uint16_t next = (uint16_t)((health->event_head + 1) % YS_HEALTH_EVENT_CNT);
+
+        if (next == health->event_tail)
+        {
+            health->event_drop_cnt++;
+            continue;
+        }
+
+        health->events[health->event_head] = event;
+        health->event_head                  = next;
+    }
+}
+
+/* a where mask is all ones, b where it is 0, bitwise so that it needs no branch */
+ys_static_inline float health_select(uint32_t mask, float a, float b)
+{
+    uint32_t ua, ub;
+
+    memcpy(&ua, &a, sizeof(ua));
+    memcpy(&ub, &b, sizeof(ub));
+
+    ua = (ua & mask) | (ub & ~mask);
+
+    memcpy(&a, &ua, sizeof(a));
+
+    return a;
+}
+
+ys_static_inline uint32_t health_min(uint32_t a, uint32_t b)
+{
+    return b ^ ((a ^ b) & HEALTH_MASK(a < b));
+}
@@ -0,0 +1,230 @@
+/**
+ * Yesense 传感器健康检测
+ *
+ * 对多个传感器的解码结果逐时刻进行以下检查，每个传感器只保存 O(1) 的状态：
+ *  - 卡死：某一轴连续 stuck_cnt 个有效样本数值完全相同（缺失的样本不打断也不计入）
+ *  - 饱和：某一轴的绝对值达到量程阈值
+ *  - 零偏跳变：短期均值（EMA）偏离长期均值超过 jump_sigma 倍标准差与 jump_min 的平方和，
+ *    适用于静止或低动态的设备。长期均值与方差的窗口为 window 个样本：前 window 个样本为累计平均
+ *    （与 Welford 相同），之后为系数 1 / window 的指数平均，长时间运行时仍能跟随缓慢的变化
+ *  - 温度漂移：平滑后的 imu_temp 相对预热结束时的温度变化超过阈值
+ *  - 四元数模长：| |q| - 1 | 超过容差
+ *
+ * 状态按传感器连续存放（SoA），每个检查对所有传感器做一次无分支循环，可被编译器向量化
+ * （gcc -O3 即可，x86-64 基线 SSE2 无需 -march；-O2 时需加 -ftree-vectorize）。
+ * 故障状态变化（出现 / 消失）时生成紧凑的事件记录，存入事件队列，并累加到每个传感器的统计计数中。
+ *
+ * 输入方式：
+ *  - 批量：ys_health_update，每个通道指向 steps * sensor_cnt 个数值，第 t 行为时刻 t 所有传感器的值
+ *  - 回调：在各传感器的回调中调用 ys_health_stage 暂存结果，再周期调用 ys_health_commit 计算一个时刻，
+ *    未暂存的传感器在该时刻视为缺失
+ *  - NaN 表示缺失，缺失的样本不参与任何检查
+ *
+ * 注意：同一个 ys_health_t 只能由一个线程使用
+ *
+ * @author github0null
+ * @version 1.0
+ * @see https://github.com/github0null/
+*/
+
+#ifndef H_YS_HEALTH
+#define H_YS_HEALTH
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ys_def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 长期均值与方差的默认窗口（样本数），config.window 为 0 时使用 */
+#ifndef YS_HEALTH_WINDOW
+#define YS_HEALTH_WINDOW 65536
+#endif
+
+/* 事件队列深度，队列满时丢弃新事件并计数 */
+#ifndef YS_HEALTH_EVENT_CNT
+#define YS_HEALTH_EVENT_CNT 64
+#endif
+
+//////////////////////////////////////////////////////
+//                  Type Define
+//////////////////////////////////////////////////////
+
+/* 检查项 */
+typedef enum
+{
+    YS_HEALTH_STUCK = 0,
+    YS_HEALTH_SATURATED,
+    YS_HEALTH_BIAS_JUMP,
+    YS_HEALTH_TEMP_DRIFT,
+    YS_HEALTH_QUAT_NORM,
+    YS_HEALTH_CHECK_NUM
+} ys_health_check_t;
+
+/* 向量通道，卡死 / 饱和 / 零偏跳变按通道检查 */
+typedef enum
+{
+    YS_HEALTH_ACCEL_X = 0,
+    YS_HEALTH_ACCEL_Y,
+    YS_HEALTH_ACCEL_Z,
+    YS_HEALTH_ANGLE_X,
+    YS_HEALTH_ANGLE_Y,
+    YS_HEALTH_ANGLE_Z,
+    YS_HEALTH_VEC_CH
+} ys_health_channel_t;
+
+/* ys_health_stage 的有效字段 */
+typedef enum
+{
+    YS_HEALTH_FIELD_ACCEL = 1 << 0,
+    YS_HEALTH_FIELD_ANGLE = 1 << 1,
+    YS_HEALTH_FIELD_TEMP  = 1 << 2,
+    YS_HEALTH_FIELD_QUAT  = 1 << 3
+} ys_health_field_t;
+
+/* 故障标志位：卡死 0 ~ 5，饱和 6 ~ 11，零偏跳变 12 ~ 17（按通道），温度漂移 18，四元数模长 19 */
+#define YS_HEALTH_FLAG(_check, _ch) \
+    (1u << ((_check) <= YS_HEALTH_BIAS_JUMP ? (_check) * YS_HEALTH_VEC_CH + (_ch) : 3 * YS_HEALTH_VEC_CH + (_check) - YS_HEALTH_TEMP_DRIFT))
+
+typedef struct
+{
+    uint32_t stuck_cnt;   /* 卡死判定的连续相同样本数，0 表示关闭 */
+    float accel_limit;    /* 加速度饱和阈值，单位：m/s^2，0 表示关闭 */
+    float angle_limit;    /* 角速度饱和阈值，单位：deg/s，0 表示关闭 */
+    float jump_sigma;     /* 零偏跳变阈值（标准差倍数），0 表示关闭 */
+    float jump_min[2];    /* 零偏跳变最小幅度，[0]：加速度，[1]：角速度 */
+    float ema_alpha;      /* 短期均值平滑系数，(0, 1] */
+    uint32_t warmup;      /* 预热样本数，之后才进行零偏跳变与温度漂移检查 */
+    uint32_t window;      /* 长期均值与方差的窗口（样本数），不超过 2^24，0 表示 YS_HEALTH_WINDOW */
+    float temp_drift;     /* 温度漂移阈值，单位：°C，0 表示关闭 */
+    float temp_alpha;     /* 温度平滑系数，(0, 1] */
+    float quat_tol;       /* 四元数模长容差，0 表示关闭 */
+} ys_health_config_t;
+
+/* 事件记录 */
+typedef struct
+{
+    uint32_t step;   /* 时刻序号 */
+    uint16_t sensor; /* 传感器索引 */
+    uint8_t check;   /* 检查项，见 ys_health_check_t */
+    uint8_t channel; /* 通道，见 ys_health_channel_t（温度与四元数为 0） */
+    uint8_t active;  /* 1：故障出现，0：故障消失 */
+    float value;     /* 卡死 / 饱和：当前值，零偏跳变：EMA - 均值，温度：相对预热温度的变化，四元数：模长平方 */
+} ys_health_event_t;
+
+/* 每个传感器的统计 */
+typedef struct
+{
+    uint32_t flags;                          /* 当前故障标志，见 YS_HEALTH_FLAG */
+    uint32_t fault_cnt[YS_HEALTH_CHECK_NUM]; /* 各检查项故障出现次数 */
+} ys_health_stat_t;
+
+/* 输入，每个指针指向 steps * sensor_cnt 个数值，为 NULL 时跳过相关检查 */
+typedef struct
+{
+    const float *accel[3];
+    const float *angle[3];
+    const float *imu_temp;
+    const float *quaternion[4];
+} ys_health_input_t;
+
+typedef struct
+{
+    ys_health_config_t config;
+    uint16_t sensor_cnt;
+    uint16_t sensor_pad;  /* 数组长度，按 8 对齐 */
+    uint32_t step;        /* 已处理的时刻数 */
+
+    /* 向量通道状态，[channel][sensor] */
+    uint32_t *n[YS_HEALTH_VEC_CH]; /* 有效样本数，达到 max(warmup, window) 后不再增加 */
+    float *mean[YS_HEALTH_VEC_CH];
+    float *var[YS_HEALTH_VEC_CH];
+    float *ema[YS_HEALTH_VEC_CH];
+    float *last[YS_HEALTH_VEC_CH];
+    uint32_t *run[YS_HEALTH_VEC_CH]; /* 与上一个有效样本相同的连续次数 */
+
+    /* 温度状态 */
+    uint32_t *temp_n; /* 有效样本数，达到 warmup 后不再增加 */
+    float *temp_ema;
+    float *temp_ref;
+
+    uint32_t *flags;      /* 本时刻的故障标志 */
+    uint32_t *prev_flags; /* 上一时刻的故障标志 */
+
+    float *stage[YS_HEALTH_VEC_CH + 5]; /* ys_health_stage 暂存区：accel, angle, imu_temp, quaternion，缺失为 NaN */
+
+    ys_health_stat_t *stats;
+
+    /* 事件队列 */
+    ys_health_event_t events[YS_HEALTH_EVENT_CNT];
+    uint16_t event_head, event_tail;
+    uint32_t event_drop_cnt;
+} ys_health_t;
+
+//////////////////////////////////////////////////////
+//                  Health API
+//////////////////////////////////////////////////////
+
+/**
+ * 创建健康检测对象（一次性分配所有内存）
+ *
+ * @param config 配置
+ *
+ * @param sensor_cnt 传感器数量
+ *
+ * @return 健康检测对象，内存不足时返回 NULL
+*/
+ys_health_t *ys_health_create(const ys_health_config_t *config, uint16_t sensor_cnt);
+
+/**
+ * 释放健康检测对象
+*/
+void ys_health_free(ys_health_t *health);
+
+/**
+ * 清除一个传感器的统计状态（例如更换设备后），重新开始预热
+*/
+void ys_health_reset(ys_health_t *health, uint16_t sensor);
+
+/**
+ * 批量检查
+ *
+ * @param input 输入数据
+ *
+ * @param steps 时刻数
+*/
+void ys_health_update(ys_health_t *health, const ys_health_input_t *input, uint32_t steps);
+
+/**
+ * 暂存一个传感器在当前时刻的解析结果，通常在解析器回调中调用
+ *
+ * @param sensor 传感器索引
+ *
+ * @param data 解析结果
+ *
+ * @param field_mask 本帧包含的字段，见 ys_health_field_t
+*/
+void ys_health_stage(ys_health_t *health, uint16_t sensor, const ys_sensor_data_t *data, uint8_t field_mask);
+
+/**
+ * 对暂存的数据进行一个时刻的检查，并清空暂存区
+*/
+void ys_health_commit(ys_health_t *health);
+
+/**
+ * 取出一个事件
+ *
+ * @param event 输出事件
+ *
+ * @return 队列为空时返回 false
+*/
+bool ys_health_pop_event(ys_health_t *health, ys_health_event_t *event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,430 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <ys_index.h>
+
+#define YS_INDEX_MAGIC   0x58495359 /* "YSIX" */
+#define YS_INDEX_VERSION 2 /* 2: frames without a time stamp are left out of the summaries */
+
+//-------------------------- type define  -----------------------------------
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t block_size;
+    uint32_t block_cnt;
+    uint32_t block_info_size; /* sizeof(ys_index_block_t), guards against layout mismatch */
+} ys_index_file_header_t;
+
+/* time stamp unwrapper, extends the 32 bit 'sample_timestamp' */
+typedef struct
+{
+    uint64_t high;
+    uint32_t last;
+    uint8_t valid;
+} ys_time_unwrap_t;
+
+typedef struct
+{
+    ys_time_unwrap_t time;
+    uint64_t time_begin;
+    uint64_t time_end;
+    ys_index_field_t field;
+    ys_index_result_t *result;
+} ys_index_query_ctx_t;
+
+//-------------------------- internal func ----------------------------------
+
+static void index_block_reset(ys_index_block_t *block, uint64_t offset);
+
+static int index_block_close(ys_index_t *idx);
+
+static void index_data_handler(ys_result_callback_params_t *params);
+
+static void query_data_handler(ys_result_callback_params_t *params);
+
+static uint8_t get_sample_fields(ys_result_callback_params_t *params, float value[YS_INDEX_FIELD_NUM]);
+
+static uint64_t unwrap_time(ys_time_unwrap_t *unwrap, uint32_t ts);
+
+static bool has_field(ys_result_callback_params_t *params, uint8_t id);
+
+static void result_merge(ys_index_result_t *result, float min, float max, double sum, uint32_t cnt);
+
+//---------------------------------------------------------------------------
+
+ys_index_t *ys_index_create(uint32_t block_size)
+{
+    ys_index_t *idx = ys_malloc(sizeof(ys_index_t));
+
+    if (idx == NULL)
+        return NULL;
+
+    memset(idx, 0, sizeof(ys_index_t));
+    idx->block_size = block_size != 0 ? block_size : YS_INDEX_BLOCK_SIZE;
+
+    ys_parser_create_static(&idx->parser, index_data_handler);
+    ys_parser_set_user_data(&idx->parser, idx);
+    index_block_reset(&idx->cur, 0);
+
+    return idx;
+}
+
+void ys_index_free(ys_index_t *idx)
+{
+    if (idx == NULL)
+        return;
+
+    if (idx->blocks != NULL)
+        ys_free(idx->blocks);
+
+    ys_free(idx);
+}
+
+int ys_index_append(ys_index_t *idx, const uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        ys_parser_status_t status = ys_parser_input(&idx->parser, buf[i]);
+
+        idx->pos++;
+
+        /* only cut blocks at frame ends, so that every block can be decoded on its own */
+        if (status == YS_STATUS_DONE && idx->pos - idx->cur.offset >= idx->block_size)
+        {
+            if (index_block_close(idx) != 0)
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+int ys_index_finish(ys_index_t *idx)
+{
+    if (idx->pos == idx->cur.offset)
+        return 0; /* empty tail */
+
+    return index_block_close(idx);
+}
+
+int ys_index_save(const ys_index_t *idx, const char *path)
+{
+    FILE *fp = fopen(path, "wb");
+
+    if (fp == NULL)
+        return -1;
+
+    ys_index_file_header_t header = {
+        .magic           = YS_INDEX_MAGIC,
+        .version         = YS_INDEX_VERSION,
+        .block_size      = idx->block_size,
+        .block_cnt       = idx->block_cnt,
+        .block_info_size = sizeof(ys_index_block_t),
+    };
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(idx->blocks, sizeof(ys_index_block_t), idx->block_cnt, fp) == idx->block_cnt;
+
+    return (fclose(fp) == 0 && ok) ? 0 : -1;
+}
+
+ys_index_t *ys_index_load(const char *path)
+{
+    ys_index_file_header_t header;
+    ys_index_t *idx = NULL;
+
+    FILE *fp = fopen(path, "rb");
+
+    if (fp == NULL)
+        return NULL;
+
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        header.magic != YS_INDEX_MAGIC ||
+        header.version != YS_INDEX_VERSION ||
+        header.block_info_size != sizeof(ys_index_block_t))
+    {
+        goto failed;
+    }
+
+    /* the block count comes from the file, check it against the bytes actually there before allocating */
+    long data_begin = ftell(fp);
+
+    if (data_begin < 0 || fseek(fp, 0, SEEK_END) != 0)
+        goto failed;
+
+    long file_end = ftell(fp);
+
+    if (file_end < data_begin ||
+        (uint64_t)header.block_cnt > (uint64_t)(file_end - data_begin) / sizeof(ys_index_block_t) ||
+        fseek(fp, data_begin, SEEK_SET) != 0)
+    {
+        goto failed;
+    }
+
+    idx = ys_index_create(header.block_size);
+
+    if (idx == NULL)
+        goto failed;
+
+    if (header.block_cnt > 0)
+    {
+        idx->blocks = ys_malloc(sizeof(ys_index_block_t) * header.block_cnt);
+
+        if (idx->blocks == NULL)
+            goto failed;
+
+        idx->block_cap = header.block_cnt;
+
+        if (fread(idx->blocks, sizeof(ys_index_block_t), header.block_cnt, fp) != header.block_cnt)
+            goto failed;
+
+        idx->block_cnt = header.block_cnt;
+    }
+
+    fclose(fp);
+    return idx;
+
+failed:
+    ys_index_free(idx);
+    fclose(fp);
+    return NULL;
+}
+
+void ys_index_query(const ys_index_t *idx, const uint8_t *capture, size_t capture_len,
+                    uint64_t time_begin, uint64_t time_end, ys_index_field_t field,
+                    ys_index_result_t *result)
+{
+    memset(result, 0, sizeof(ys_index_result_t));
+
+    for (uint32_t i = 0; i < idx->block_cnt; i++)
+    {
+        const ys_index_block_t *block = &idx->blocks[i];
+
+        /* zone map pruning */
+        if (block->time_cnt == 0 || block->time_end < time_begin || block->time_begin > time_end)
+            continue;
+
+        result->err_cnt += block->err_cnt;
+
+        /* fully covered, answer from summary */
+        if (block->time_begin >= time_begin && block->time_end <= time_end)
+        {
+            result_merge(result, block->min[field], block->max[field], block->sum[field], block->cnt[field]);
+            result->summary_blocks++;
+            continue;
+        }
+
+        /* boundary block, decode it */
+        if (block->offset + block->length > capture_len)
+            continue; /* capture is shorter than the index, skip it */
+
+        ys_index_query_ctx_t ctx = {
+            .time = {
+                .high  = block->time_begin & 0xFFFFFFFF00000000ULL,
+                .last  = (uint32_t)block->time_begin,
+                .valid = 1,
+            },
+            .time_begin = time_begin,
+            .time_end   = time_end,
+            .field      = field,
+            .result     = result,
+        };
+
+        ys_parser_t parser;
+        ys_parser_create_static(&parser, query_data_handler);
+        ys_parser_set_user_data(&parser, &ctx);
+
+        const uint8_t *data = &capture[block->offset];
+
+        for (uint32_t k = 0; k < block->length; k++)
+        {
+            ys_parser_input(&parser, data[k]);
+        }
+
+        result->decoded_blocks++;
+    }
+}
+
+//-------------------------- internal func ----------------------------------
+
+static void index_block_reset(ys_index_block_t *block, uint64_t offset)
+{
+    memset(block, 0, sizeof(ys_index_block_t));
+    block->offset = offset;
+}
+
+static int index_block_close(ys_index_t *idx)
+{
+    ys_index_block_t *cur = &idx->cur;
+
+    if (idx->block_cnt == idx->block_cap)
+    {
+        uint32_t new_cap             = idx->block_cap != 0 ? idx->block_cap * 2 : 64;
+        ys_index_block_t *new_blocks = ys_malloc(sizeof(ys_index_block_t) * new_cap);
+
+        if (new_blocks == NULL)
+            return -1;
+
+        if (idx->blocks != NULL)
+        {
+            memcpy(new_blocks, idx->blocks, sizeof(ys_index_block_t) * idx->block_cnt);
+            ys_free(idx->blocks);
+        }
+
+        idx->blocks    = new_blocks;
+        idx->block_cap = new_cap;
+    }
+
+    /* collect crc / length errors seen since last block */
+    cur->err_cnt = (uint16_t)(idx->parser.trace_inf.err_frame_cnt - idx->last_err_cnt);
+    cur->length  = (uint32_t)(idx->pos - cur->offset);
+
+    idx->last_err_cnt = idx->parser.trace_inf.err_frame_cnt;
+    idx->blocks[idx->block_cnt++] = *cur;
+
+    index_block_reset(cur, idx->pos);
+
+    return 0;
+}
+
+static void index_data_handler(ys_result_callback_params_t *params)
+{
+    ys_index_t *idx          = (ys_index_t *)params->user_data;
+    ys_index_block_t *block  = &idx->cur;
+    float value[YS_INDEX_FIELD_NUM];
+
+    if (block->frame_cnt == 0)
+        block->tid_first = params->tid;
+
+    block->tid_last = params->tid;
+    block->frame_cnt++;
+
+    if (has_field(params, YS_ID_SAMPLE_TIMESTAMP))
+    {
+        ys_time_unwrap_t unwrap = {idx->time_high, idx->last_time, idx->has_time};
+        uint64_t time           = unwrap_time(&unwrap, params->result->sample_timestamp);
+
+        idx->time_high = unwrap.high;
+        idx->last_time = unwrap.last;
+        idx->has_time  = unwrap.valid;
+
+        if (block->time_cnt == 0 || time < block->time_begin)
+            block->time_begin = time;
+        if (block->time_cnt == 0 || time > block->time_end)
+            block->time_end = time;
+
+        block->time_cnt++;
+    }
+    else
+    {
+        /* a time range query can never select it, keep it out of the summaries too */
+        return;
+    }
+
+    uint8_t mask = get_sample_fields(params, value);
+
+    for (int i = 0; i < YS_INDEX_FIELD_NUM; i++)
+    {
+        if ((mask & (1 << i)) == 0)
+            continue;
+
+        if (block->cnt[i] == 0 || value[i] < block->min[i])
+            block->min[i] = value[i];
+        if (block->cnt[i] == 0 || value[i] > block->max[i])
+            block->max[i] = value[i];
+
+        block->sum[i] += value[i];
+        block->cnt[i]++;
+    }
+}
+
+static void query_data_handler(ys_result_callback_params_t *params)
+{
+    ys_index_query_ctx_t *ctx = (ys_index_query_ctx_t *)params->user_data;
+    float value[YS_INDEX_FIELD_NUM];
+
+    if (!has_field(params, YS_ID_SAMPLE_TIMESTAMP))
+        return;
+
+    uint64_t time = unwrap_time(&ctx->time, params->result->sample_timestamp);
+
+    if (time < ctx->time_begin || time > ctx->time_end)
+        return;
+
+    if (get_sample_fields(params, value) & (1 << ctx->field))
+    {
+        result_merge(ctx->result, value[ctx->field], value[ctx->field], value[ctx->field], 1);
+    }
+}
+
+static uint8_t get_sample_fields(ys_result_callback_params_t *params, float value[YS_INDEX_FIELD_NUM])
+{
+    ys_sensor_data_t *data = params->result;
+    uint8_t mask           = 0;
+
+    if (has_field(params, YS_ID_ACCEL))
+    {
+        value[YS_INDEX_ACCEL_NORM] = sqrtf(data->accel[X] * data->accel[X] +
+                                           data->accel[Y] * data->accel[Y] +
+                                           data->accel[Z] * data->accel[Z]);
+        mask |= 1 << YS_INDEX_ACCEL_NORM;
+    }
+
+    if (has_field(params, YS_ID_ANGLE))
+    {
+        value[YS_INDEX_ANGLE_NORM] = sqrtf(data->angle[X] * data->angle[X] +
+                                           data->angle[Y] * data->angle[Y] +
+                                           data->angle[Z] * data->angle[Z]);
+        mask |= 1 << YS_INDEX_ANGLE_NORM;
+    }
+
+    if (has_field(params, YS_ID_IMU_TEMP))
+    {
+        value[YS_INDEX_IMU_TEMP] = data->imu_temp;
+        mask |= 1 << YS_INDEX_IMU_TEMP;
+    }
+
+    return mask;
+}
+
+static uint64_t unwrap_time(ys_time_unwrap_t *unwrap, uint32_t ts)
+{
+    /* a large backward jump means the 32 bit counter wrapped */
+    if (unwrap->valid && ts < unwrap->last && (unwrap->last - ts) > 0x80000000UL)
+        unwrap->high += 0x100000000ULL;
+
+    unwrap->last  = ts;
+    unwrap->valid = 1;
+
+    return unwrap->high | ts;
+}
+
+static bool has_field(ys_result_callback_params_t *params, uint8_t id)
+{
+    for (uint8_t i = 0; i < params->field_cnt; i++)
+    {
+        if (params->field_li[i] == id)
+            return true;
+    }
+
+    return false;
+}
+
+static void result_merge(ys_index_result_t *result, float min, float max, double sum, uint32_t cnt)
+{
+    if (cnt == 0)
+        return;
+
+    if (result->cnt == 0 || min < result->min)
+        result->min = min;
+    if (result->cnt == 0 || max > result->max)
+        result->max = max;
+
+    result->sum += sum;
+    result->cnt += cnt;
+}
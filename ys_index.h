@@ -0,0 +1,170 @@
+/**
+ * Yesense 录制数据分块索引（zone map）
+ *
+ * 在采集时或离线一次遍历中，将原始录制数据按帧边界切分为块，为每个块记录摘要：
+ * 字节范围、时间范围、tid 范围、帧数、错误帧数以及各统计量的最小 / 最大 / 累加值。
+ *
+ * 时间范围查询先使用摘要跳过不相交的块，完全落在查询范围内的块直接由摘要给出结果，
+ * 只有与查询边界相交的块才需要重新解析。
+ *
+ * 注意：
+ *  - 一个索引对应一路传感器的一份录制数据
+ *  - 时间使用展开后的 sample_timestamp（64 位，单位 us），不含该字段的帧不参与时间及统计量摘要，
+ *    因此任何时间范围查询都不会统计这些帧
+ *  - 索引文件使用本机字节序
+ *
+ * @author github0null
+ * @version 1.0
+ * @see https://github.com/github0null/
+*/
+
+#ifndef H_YS_INDEX
+#define H_YS_INDEX
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ys_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 默认块大小（字节），实际块在该大小之后的第一个帧结束处切分 */
+#ifndef YS_INDEX_BLOCK_SIZE
+#define YS_INDEX_BLOCK_SIZE 65536
+#endif
+
+//////////////////////////////////////////////////////
+//                  Type Define
+//////////////////////////////////////////////////////
+
+/* 块摘要统计量 */
+typedef enum
+{
+    YS_INDEX_ACCEL_NORM = 0, /* |accel|，单位：m/s^2 */
+    YS_INDEX_ANGLE_NORM,     /* |angle|，单位：deg/s */
+    YS_INDEX_IMU_TEMP,       /* imu_temp，单位：°C */
+    YS_INDEX_FIELD_NUM
+} ys_index_field_t;
+
+/* 块摘要 */
+typedef struct
+{
+    uint64_t offset;     /* 块在录制数据中的起始偏移 */
+    uint64_t time_begin; /* 块内最早的采样时间，单位：us */
+    uint64_t time_end;   /* 块内最晚的采样时间，单位：us */
+
+    double sum[YS_INDEX_FIELD_NUM];
+    float min[YS_INDEX_FIELD_NUM];
+    float max[YS_INDEX_FIELD_NUM];
+    uint32_t cnt[YS_INDEX_FIELD_NUM];
+
+    uint32_t length;    /* 块长度（字节） */
+    uint32_t frame_cnt; /* 有效帧数 */
+    uint32_t time_cnt;  /* 含时间戳的帧数，为 0 时 time_begin / time_end 无效 */
+    uint32_t err_cnt;   /* 校验 / 长度错误数，见 ys_trace_info_t.err_frame_cnt */
+    uint16_t tid_first;
+    uint16_t tid_last;
+} ys_index_block_t;
+
+typedef struct
+{
+    ys_index_block_t *blocks;
+    uint32_t block_cnt;
+    uint32_t block_cap;
+    uint32_t block_size;
+
+    /* builder state */
+    ys_parser_t parser;
+    ys_index_block_t cur;
+    uint64_t pos;
+    uint64_t time_high;
+    uint32_t last_time;
+    uint16_t last_err_cnt;
+    uint8_t has_time;
+} ys_index_t;
+
+/* 查询结果 */
+typedef struct
+{
+    double sum;
+    float min;
+    float max;
+    uint32_t cnt;            /* 参与统计的样本数，为 0 时 min / max 无效 */
+    uint32_t err_cnt;        /* 与查询范围相交的块内的错误数 */
+    uint32_t summary_blocks; /* 直接使用摘要的块数 */
+    uint32_t decoded_blocks; /* 重新解析的边界块数 */
+} ys_index_result_t;
+
+//////////////////////////////////////////////////////
+//                  Index API
+//////////////////////////////////////////////////////
+
+/**
+ * 创建一个空索引
+ *
+ * @param block_size 块大小（字节），为 0 时使用 YS_INDEX_BLOCK_SIZE
+ *
+ * @return 索引对象，内存不足时返回 NULL
+*/
+ys_index_t *ys_index_create(uint32_t block_size);
+
+/**
+ * 释放索引
+*/
+void ys_index_free(ys_index_t *idx);
+
+/**
+ * 向索引追加一段原始录制数据，可在采集时随数据写入一起调用
+ *
+ * @return 成功返回 0，内存不足返回 -1
+*/
+int ys_index_append(ys_index_t *idx, const uint8_t *buf, size_t len);
+
+/**
+ * 结束索引构建，关闭最后一个块
+ *
+ * @return 成功返回 0，内存不足返回 -1
+*/
+int ys_index_finish(ys_index_t *idx);
+
+/**
+ * 保存索引到文件
+ *
+ * @return 成功返回 0，失败返回 -1
+*/
+int ys_index_save(const ys_index_t *idx, const char *path);
+
+/**
+ * 从文件加载索引
+ *
+ * @return 索引对象，失败时返回 NULL
+*/
+ys_index_t *ys_index_load(const char *path);
+
+/**
+ * 在时间范围 [time_begin, time_end] 内统计某个字段
+ *
+ * @param idx 索引对象
+ *
+ * @param capture 与索引对应的原始录制数据（例如 mmap 映射的文件），用于解析边界块
+ *
+ * @param capture_len 录制数据长度
+ *
+ * @param time_begin 起始时间，单位：us
+ *
+ * @param time_end 结束时间，单位：us
+ *
+ * @param field 统计字段
+ *
+ * @param result 查询结果
+*/
+void ys_index_query(const ys_index_t *idx, const uint8_t *capture, size_t capture_len,
+                    uint64_t time_begin, uint64_t time_end, ys_index_field_t field,
+                    ys_index_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
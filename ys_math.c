@@ -0,0 +1,300 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <ys_math.h>
+
+/* WGS84 ellipsoid */
+#define WGS84_A  6378137.0
+#define WGS84_E2 6.69437999014e-3
+
+#define DEG_TO_RAD 0.017453292519943295
+
+//-------------------------- single sample ----------------------------------
+
+void ys_quat_rotate(const float q[4], const float v[3], float out[3])
+{
+    float w = q[0], x = q[1], y = q[2], z = q[3];
+
+    /* t = 2 * cross(q.xyz, v) */
+    float tx = 2.0f * (y * v[Z] - z * v[Y]);
+    float ty = 2.0f * (z * v[X] - x * v[Z]);
+    float tz = 2.0f * (x * v[Y] - y * v[X]);
+
+    /* out = v + w * t + cross(q.xyz, t) */
+    float ox = v[X] + w * tx + (y * tz - z * ty);
+    float oy = v[Y] + w * ty + (z * tx - x * tz);
+    float oz = v[Z] + w * tz + (x * ty - y * tx);
+
+    out[X] = ox;
+    out[Y] = oy;
+    out[Z] = oz;
+}
+
+void ys_quat_mul(const float a[4], const float b[4], float out[4])
+{
+    float w = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+    float x = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+    float y = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+    float z = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+
+    out[0] = w;
+    out[1] = x;
+    out[2] = y;
+    out[3] = z;
+}
+
+void ys_quat_normalize(float q[4])
+{
+    float norm = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+
+    if (norm > 0.0f)
+    {
+        float inv = 1.0f / norm;
+        q[0] *= inv;
+        q[1] *= inv;
+        q[2] *= inv;
+        q[3] *= inv;
+    }
+}
+
+void ys_quat_slerp(const float a[4], const float b[4], float t, float out[4])
+{
+    float dot  = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    float sign = 1.0f;
+    float wa, wb;
+
+    /* q and -q are the same rotation, take the short way */
+    if (dot < 0.0f)
+    {
+        dot  = -dot;
+        sign = -1.0f;
+    }
+
+    if (dot > 0.9995f)
+    {
+        /* nearly parallel, fall back to normalized lerp */
+        wa = 1.0f - t;
+        wb = t;
+    }
+    else
+    {
+        float theta     = acosf(dot);
+        float inv_sin_t = 1.0f / sinf(theta);
+
+        wa = sinf((1.0f - t) * theta) * inv_sin_t;
+        wb = sinf(t * theta) * inv_sin_t;
+    }
+
+    wb *= sign;
+
+    for (int i = 0; i < 4; i++)
+    {
+        out[i] = wa * a[i] + wb * b[i];
+    }
+
+    ys_quat_normalize(out);
+}
+
+//-------------------------- batch kernels ----------------------------------
+
+/*
+ * the loops live in static functions taking restrict qualified parameters,
+ * compilers ignore 'restrict' on local pointer copies when checking aliasing
+ */
+
+static void quat_to_rotm_kernel(
+    const float *ys_restrict qw, const float *ys_restrict qx, const float *ys_restrict qy, const float *ys_restrict qz,
+    float *ys_restrict r00, float *ys_restrict r01, float *ys_restrict r02,
+    float *ys_restrict r10, float *ys_restrict r11, float *ys_restrict r12,
+    float *ys_restrict r20, float *ys_restrict r21, float *ys_restrict r22,
+    uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        float w = qw[i], x = qx[i], y = qy[i], z = qz[i];
+
+        float xx = x * x, yy = y * y, zz = z * z;
+        float xy = x * y, xz = x * z, yz = y * z;
+        float wx = w * x, wy = w * y, wz = w * z;
+
+        r00[i] = 1.0f - 2.0f * (yy + zz);
+        r01[i] = 2.0f * (xy - wz);
+        r02[i] = 2.0f * (xz + wy);
+
+        r10[i] = 2.0f * (xy + wz);
+        r11[i] = 1.0f - 2.0f * (xx + zz);
+        r12[i] = 2.0f * (yz - wx);
+
+        r20[i] = 2.0f * (xz - wy);
+        r21[i] = 2.0f * (yz + wx);
+        r22[i] = 1.0f - 2.0f * (xx + yy);
+    }
+}
+
+static void linear_accel_kernel(
+    const float *ys_restrict qw, const float *ys_restrict qx, const float *ys_restrict qy, const float *ys_restrict qz,
+    const float *ys_restrict ax, const float *ys_restrict ay, const float *ys_restrict az,
+    float *ys_restrict oe, float *ys_restrict on, float *ys_restrict ou,
+    float gravity, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        float w = qw[i], x = qx[i], y = qy[i], z = qz[i];
+        float vx = ax[i], vy = ay[i], vz = az[i];
+
+        /* t = 2 * cross(q.xyz, v), out = v + w * t + cross(q.xyz, t) */
+        float tx = 2.0f * (y * vz - z * vy);
+        float ty = 2.0f * (z * vx - x * vz);
+        float tz = 2.0f * (x * vy - y * vx);
+
+        oe[i] = vx + w * tx + (y * tz - z * ty);
+        on[i] = vy + w * ty + (z * tx - x * tz);
+        ou[i] = vz + w * tz + (x * ty - y * tx) - gravity;
+    }
+}
+
+static void geodetic_to_ecef_kernel(
+    const double *ys_restrict lat, const double *ys_restrict lon, const double *ys_restrict alt,
+    double *ys_restrict ex, double *ys_restrict ey, double *ys_restrict ez,
+    uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        double sin_lat = sin(lat[i] * DEG_TO_RAD), cos_lat = cos(lat[i] * DEG_TO_RAD);
+        double sin_lon = sin(lon[i] * DEG_TO_RAD), cos_lon = cos(lon[i] * DEG_TO_RAD);
+
+        double rn = WGS84_A / sqrt(1.0 - WGS84_E2 * sin_lat * sin_lat);
+
+        ex[i] = (rn + alt[i]) * cos_lat * cos_lon;
+        ey[i] = (rn + alt[i]) * cos_lat * sin_lon;
+        ez[i] = (rn * (1.0 - WGS84_E2) + alt[i]) * sin_lat;
+    }
+}
+
+static uint32_t imu_vote_kernel(
+    const float *ys_restrict ax, const float *ys_restrict ay, const float *ys_restrict az,
+    const float *ys_restrict bx, const float *ys_restrict by, const float *ys_restrict bz,
+    const float *ys_restrict rx, const float *ys_restrict ry, const float *ys_restrict rz,
+    float *ys_restrict ox, float *ys_restrict oy, float *ys_restrict oz,
+    float *ys_restrict diff, uint8_t *ys_restrict mismatch,
+    float tol, uint32_t n)
+{
+    uint32_t cnt = 0;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        float dx = ax[i] - bx[i], dy = ay[i] - by[i], dz = az[i] - bz[i];
+        float d  = sqrtf(dx * dx + dy * dy + dz * dz);
+
+        /* distance of each imu to the reference */
+        float ea = (ax[i] - rx[i]) * (ax[i] - rx[i]) + (ay[i] - ry[i]) * (ay[i] - ry[i]) + (az[i] - rz[i]) * (az[i] - rz[i]);
+        float eb = (bx[i] - rx[i]) * (bx[i] - rx[i]) + (by[i] - ry[i]) * (by[i] - ry[i]) + (bz[i] - rz[i]) * (bz[i] - rz[i]);
+
+        int bad = d > tol;
+
+        /* agree: average, disagree: the one closer to the reference. kept branchless */
+        float w = 0.5f + (float)bad * ((float)(ea <= eb) - 0.5f);
+
+        ox[i] = bx[i] + w * dx;
+        oy[i] = by[i] + w * dy;
+        oz[i] = bz[i] + w * dz;
+
+        diff[i]     = d;
+        mismatch[i] = (uint8_t)bad;
+        cnt += (uint32_t)bad;
+    }
+
+    return cnt;
+}
+
+static void ecef_to_enu_kernel(
+    const double ref_ecef[3], const double ref_rotm[9],
+    double *ys_restrict oe, double *ys_restrict on, double *ys_restrict ou,
+    uint32_t n)
+{
+    double rx = ref_ecef[X], ry = ref_ecef[Y], rz = ref_ecef[Z];
+
+    double m00 = ref_rotm[0], m01 = ref_rotm[1], m02 = ref_rotm[2];
+    double m10 = ref_rotm[3], m11 = ref_rotm[4], m12 = ref_rotm[5];
+    double m20 = ref_rotm[6], m21 = ref_rotm[7], m22 = ref_rotm[8];
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        double dx = oe[i] - rx, dy = on[i] - ry, dz = ou[i] - rz;
+
+        oe[i] = m00 * dx + m01 * dy + m02 * dz;
+        on[i] = m10 * dx + m11 * dy + m12 * dz;
+        ou[i] = m20 * dx + m21 * dy + m22 * dz;
+    }
+}
+
+void ys_quat_to_rotm_batch(const ys_quat_soa_t *q, const ys_rotm_soa_t *rotm, uint32_t n)
+{
+    quat_to_rotm_kernel(
+        q->q[0], q->q[1], q->q[2], q->q[3],
+        rotm->r[0], rotm->r[1], rotm->r[2],
+        rotm->r[3], rotm->r[4], rotm->r[5],
+        rotm->r[6], rotm->r[7], rotm->r[8],
+        n);
+}
+
+void ys_rotate_to_enu_batch(const ys_quat_soa_t *q, const ys_vec3_soa_t *body, const ys_vec3_soa_t *enu, uint32_t n)
+{
+    ys_linear_accel_batch(q, body, enu, 0.0f, n);
+}
+
+void ys_linear_accel_batch(const ys_quat_soa_t *q, const ys_vec3_soa_t *accel, const ys_vec3_soa_t *lin_accel, float gravity, uint32_t n)
+{
+    linear_accel_kernel(
+        q->q[0], q->q[1], q->q[2], q->q[3],
+        accel->v[X], accel->v[Y], accel->v[Z],
+        lin_accel->v[E], lin_accel->v[N], lin_accel->v[U],
+        gravity, n);
+}
+
+uint32_t ys_imu_vote_batch(const ys_vec3_soa_t *a, const ys_vec3_soa_t *b, const ys_vec3_soa_t *ref, float tol,
+                           const ys_vec3_soa_t *out, float *diff, uint8_t *mismatch, uint32_t n)
+{
+    /* without a reference the first imu wins, it is at distance 0 from itself */
+    if (ref == NULL)
+        ref = a;
+
+    return imu_vote_kernel(
+        a->v[X], a->v[Y], a->v[Z],
+        b->v[X], b->v[Y], b->v[Z],
+        ref->v[X], ref->v[Y], ref->v[Z],
+        out->v[X], out->v[Y], out->v[Z],
+        diff, mismatch, tol, n);
+}
+
+void ys_geodetic_to_ecef_batch(const ys_dvec3_soa_t *lla, const ys_dvec3_soa_t *ecef, uint32_t n)
+{
+    geodetic_to_ecef_kernel(
+        lla->v[LAT], lla->v[LON], lla->v[ALT],
+        ecef->v[X], ecef->v[Y], ecef->v[Z],
+        n);
+}
+
+void ys_geodetic_to_enu_batch(const double ref[3], const ys_dvec3_soa_t *lla, const ys_dvec3_soa_t *enu, uint32_t n)
+{
+    double sin_lat = sin(ref[LAT] * DEG_TO_RAD), cos_lat = cos(ref[LAT] * DEG_TO_RAD);
+    double sin_lon = sin(ref[LON] * DEG_TO_RAD), cos_lon = cos(ref[LON] * DEG_TO_RAD);
+
+    double rn          = WGS84_A / sqrt(1.0 - WGS84_E2 * sin_lat * sin_lat);
+    double ref_ecef[3] = {
+        (rn + ref[ALT]) * cos_lat * cos_lon,
+        (rn + ref[ALT]) * cos_lat * sin_lon,
+        (rn * (1.0 - WGS84_E2) + ref[ALT]) * sin_lat,
+    };
+
+    /* ecef -> enu */
+    double ref_rotm[9] = {
+        -sin_lon, cos_lon, 0.0,
+        -sin_lat * cos_lon, -sin_lat * sin_lon, cos_lat,
+        cos_lat * cos_lon, cos_lat * sin_lon, sin_lat,
+    };
+
+    /* convert to ecef into the output block, then rotate the offset in place */
+    ys_geodetic_to_ecef_batch(lla, enu, n);
+    ecef_to_enu_kernel(ref_ecef, ref_rotm, enu->v[E], enu->v[N], enu->v[U], n);
+}
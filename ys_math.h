@@ -0,0 +1,204 @@
+/**
+ * Yesense 姿态与大地坐标批量计算
+ *
+ * 所有批量函数均以结构数组（SoA）形式输入输出：每个分量各自为一段连续数组，
+ * 循环体无分支，便于编译器生成 SSE/AVX2/NEON 向量指令（建议使用 -O3 编译，
+ * 含开方的函数还需 -fno-math-errno）。
+ *
+ * 约定：
+ *  - 四元数分量顺序为 q0(w), q1(x), q2(y), q3(z)，与 ys_sensor_data_t.quaternion 一致，
+ *    表示由载体坐标系到站心坐标系（E,N,U）的旋转
+ *  - 向量分量索引见 IMU_XYZ_AXIS / IMU_ENU_AXIS
+ *  - 位置分量索引见 IMU_LOCATION，经纬度单位 deg，海拔单位 m（WGS84）
+ *
+ * @author github0null
+ * @version 1.0
+ * @see https://github.com/github0null/
+*/
+
+#ifndef H_YS_MATH
+#define H_YS_MATH
+
+#include <stdint.h>
+#include "ys_def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 重力加速度，单位：m/s^2 */
+#ifndef YS_GRAVITY
+#define YS_GRAVITY 9.80665f
+#endif
+
+//////////////////////////////////////////////////////
+//                  Type Define
+//////////////////////////////////////////////////////
+
+/* 三维向量块，v[X], v[Y], v[Z]（或 v[E], v[N], v[U]）各指向 n 个元素 */
+typedef struct
+{
+    float *v[3];
+} ys_vec3_soa_t;
+
+/* 四元数块，q[0] ~ q[3] 各指向 n 个元素 */
+typedef struct
+{
+    float *q[4];
+} ys_quat_soa_t;
+
+/* 旋转矩阵块，按行优先存储，r[row * 3 + col] 指向 n 个元素 */
+typedef struct
+{
+    float *r[9];
+} ys_rotm_soa_t;
+
+/* 双精度三维向量块，用于位置（LAT, LON, ALT）以及 ECEF / ENU 坐标 */
+typedef struct
+{
+    double *v[3];
+} ys_dvec3_soa_t;
+
+//////////////////////////////////////////////////////
+//                  Single Sample
+//////////////////////////////////////////////////////
+
+/**
+ * 使用四元数旋转一个向量：out = q * v * q^-1
+ *
+ * @param q 单位四元数
+ *
+ * @param v 输入向量
+ *
+ * @param out 输出向量，可与 v 相同
+*/
+void ys_quat_rotate(const float q[4], const float v[3], float out[3]);
+
+/**
+ * 四元数乘法：out = a * b
+ *
+ * @param out 输出四元数，可与 a 或 b 相同
+*/
+void ys_quat_mul(const float a[4], const float b[4], float out[4]);
+
+/**
+ * 四元数归一化
+*/
+void ys_quat_normalize(float q[4]);
+
+/**
+ * 四元数球面线性插值，自动选择最短路径
+ *
+ * @param a 起始四元数（t = 0）
+ *
+ * @param b 结束四元数（t = 1）
+ *
+ * @param t 插值系数，范围 [0, 1]
+ *
+ * @param out 输出四元数，可与 a 或 b 相同
+*/
+void ys_quat_slerp(const float a[4], const float b[4], float t, float out[4]);
+
+//////////////////////////////////////////////////////
+//                  Batch Kernels
+//////////////////////////////////////////////////////
+
+/**
+ * 四元数转旋转矩阵（载体 -> 站心）
+ *
+ * @param q 输入四元数块
+ *
+ * @param rotm 输出旋转矩阵块
+ *
+ * @param n 样本数
+*/
+void ys_quat_to_rotm_batch(const ys_quat_soa_t *q, const ys_rotm_soa_t *rotm, uint32_t n);
+
+/**
+ * 将载体坐标系下的向量旋转到站心坐标系（E,N,U）
+ *
+ * @param q 输入四元数块
+ *
+ * @param body 载体坐标系向量块，如 accel
+ *
+ * @param enu 输出站心坐标系向量块，不可与 body 重叠
+ *
+ * @param n 样本数
+*/
+void ys_rotate_to_enu_batch(const ys_quat_soa_t *q, const ys_vec3_soa_t *body, const ys_vec3_soa_t *enu, uint32_t n);
+
+/**
+ * 计算站心坐标系下的运动加速度：将载体加速度旋转到 E,N,U 后减去重力
+ *
+ * 与先调用 @ref ys_rotate_to_enu_batch 再减去重力等价，但只遍历一次内存
+ *
+ * @param q 输入四元数块
+ *
+ * @param accel 载体加速度块，单位：m/s^2
+ *
+ * @param lin_accel 输出站心坐标系运动加速度块，不可与 accel 重叠
+ *
+ * @param gravity 重力加速度，通常为 YS_GRAVITY
+ *
+ * @param n 样本数
+*/
+void ys_linear_accel_batch(const ys_quat_soa_t *q, const ys_vec3_soa_t *accel, const ys_vec3_soa_t *lin_accel, float gravity, uint32_t n);
+
+/**
+ * 双 IMU 一致性检查与表决
+ *
+ * 逐样本计算两颗 IMU 输出之差的模长，小于等于 tol 时输出两者的平均值；
+ * 超过 tol 时认为其中一颗异常，输出更接近参考向量的一颗（三取二表决）。
+ *
+ * 适用于加速度与角速度，分别调用即可，例如 a 为 accel、b 为 ys_dual_imu_data_t.second_accel
+ *
+ * @param a 第一颗 IMU 向量块
+ *
+ * @param b 第二颗 IMU 向量块
+ *
+ * @param ref 参考向量块（例如上一时刻的表决结果、第三个传感器或模型预测），为 NULL 时不一致的样本输出 a
+ *
+ * @param tol 允许的差值模长，单位与输入相同
+ *
+ * @param out 输出表决结果块，不可与输入重叠
+ *
+ * @param diff 输出两颗 IMU 之差的模长，n 个元素
+ *
+ * @param mismatch 输出不一致标志（0 / 1），n 个元素
+ *
+ * @param n 样本数
+ *
+ * @return 不一致的样本数
+*/
+uint32_t ys_imu_vote_batch(const ys_vec3_soa_t *a, const ys_vec3_soa_t *b, const ys_vec3_soa_t *ref, float tol,
+                           const ys_vec3_soa_t *out, float *diff, uint8_t *mismatch, uint32_t n);
+
+/**
+ * 大地坐标（LAT, LON, ALT）转 ECEF 坐标（WGS84）
+ *
+ * @param lla 输入位置块
+ *
+ * @param ecef 输出 ECEF 坐标块，单位：m，不可与 lla 重叠
+ *
+ * @param n 样本数
+*/
+void ys_geodetic_to_ecef_batch(const ys_dvec3_soa_t *lla, const ys_dvec3_soa_t *ecef, uint32_t n);
+
+/**
+ * 大地坐标（LAT, LON, ALT）转以 ref 为原点的站心坐标（E,N,U）
+ *
+ * @param ref 原点位置，索引见 IMU_LOCATION
+ *
+ * @param lla 输入位置块
+ *
+ * @param enu 输出站心坐标块，单位：m，不可与 lla 重叠
+ *
+ * @param n 样本数
+*/
+void ys_geodetic_to_enu_batch(const double ref[3], const ys_dvec3_soa_t *lla, const ys_dvec3_soa_t *enu, uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
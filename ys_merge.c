@@ -0,0 +1,390 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ys_merge.h>
+#include <ys_math.h>
+
+/* gaps longer than this many grid periods are not interpolated */
+#ifndef YS_RESAMPLE_MAX_GAP
+#define YS_RESAMPLE_MAX_GAP 4
+#endif
+
+//-------------------------- internal func ----------------------------------
+
+static void merge_drain(ys_merge_t *merge);
+
+static uint16_t merge_emit_top(ys_merge_t *merge);
+
+static void heap_sift_up(ys_merge_t *merge, uint16_t pos);
+
+static void heap_sift_down(ys_merge_t *merge, uint16_t pos);
+
+static void lerp_arr(float *dst, const float *a, const float *b, float t, uint8_t size);
+
+static float lerp_angle(float a, float b, float t);
+
+#define stream_head(_stream)         (&(_stream)->queue[(_stream)->head])
+
+#define stream_tail(_stream, _depth) (&(_stream)->queue[((_stream)->head + (_stream)->count - 1) % (_depth)])
+
+//---------------------------------------------------------------------------
+
+ys_merge_t *ys_merge_create(uint16_t stream_num, uint16_t depth, uint64_t window,
+                            ys_merge_output_t output, void *user_data)
+{
+    ys_merge_t *merge;
+
+    /* the stream queues are rings of 'depth' samples */
+    if (depth == 0)
+        return NULL;
+
+    merge = ys_malloc(sizeof(ys_merge_t));
+
+    if (merge == NULL)
+        return NULL;
+
+    memset(merge, 0, sizeof(ys_merge_t));
+
+    merge->streams = ys_malloc(sizeof(ys_merge_stream_t) * stream_num);
+    merge->heap    = ys_malloc(sizeof(uint16_t) * stream_num);
+
+    if (merge->streams == NULL || merge->heap == NULL)
+        goto failed;
+
+    memset(merge->streams, 0, sizeof(ys_merge_stream_t) * stream_num);
+
+    for (uint16_t i = 0; i < stream_num; i++)
+    {
+        merge->streams[i].queue = ys_malloc(sizeof(ys_merge_sample_t) * depth);
+
+        if (merge->streams[i].queue == NULL)
+            goto failed;
+    }
+
+    merge->stream_num = stream_num;
+    merge->depth      = depth;
+    merge->window     = window;
+    merge->output     = output;
+    merge->user_data  = user_data;
+
+    return merge;
+
+failed:
+    merge->stream_num = stream_num;
+    ys_merge_free(merge);
+    return NULL;
+}
+
+void ys_merge_free(ys_merge_t *merge)
+{
+    if (merge == NULL)
+        return;
+
+    if (merge->streams != NULL)
+    {
+        for (uint16_t i = 0; i < merge->stream_num; i++)
+        {
+            if (merge->streams[i].queue != NULL)
+                ys_free(merge->streams[i].queue);
+        }
+
+        ys_free(merge->streams);
+    }
+
+    if (merge->heap != NULL)
+        ys_free(merge->heap);
+
+    ys_free(merge);
+}
+
+void ys_merge_set_clock_offset(ys_merge_t *merge, uint16_t stream, int64_t clock_offset)
+{
+    ys_assert(stream < merge->stream_num);
+    merge->streams[stream].clock_offset = clock_offset;
+}
+
+void ys_merge_push(ys_merge_t *merge, uint16_t stream, const ys_result_callback_params_t *params)
+{
+    ys_merge_stream_t *st;
+    ys_merge_sample_t sample;
+    bool has_time = false;
+
+    ys_assert(stream < merge->stream_num);
+    st = &merge->streams[stream];
+
+    for (uint8_t i = 0; i < params->field_cnt; i++)
+    {
+        if (params->field_li[i] == YS_ID_SAMPLE_TIMESTAMP)
+        {
+            has_time = true;
+            break;
+        }
+    }
+
+    if (!has_time)
+        return;
+
+    uint32_t ts = params->result->sample_timestamp;
+
+    /* unwrap 32 bit sample time */
+    if (st->has_time && ts < st->last_time && (st->last_time - ts) > 0x80000000UL)
+        st->time_high += 0x100000000ULL;
+
+    st->last_time = ts;
+    st->has_time  = 1;
+
+    int64_t time = (int64_t)(st->time_high | ts) + st->clock_offset;
+
+    sample.time   = time > 0 ? (uint64_t)time : 0;
+    sample.stream = stream;
+    sample.tid    = params->tid;
+    memcpy(&sample.data, params->result, sizeof(ys_sensor_data_t));
+
+    ys_merge_push_sample(merge, &sample);
+}
+
+void ys_merge_push_sample(ys_merge_t *merge, const ys_merge_sample_t *sample)
+{
+    ys_merge_stream_t *st;
+
+    ys_assert(sample->stream < merge->stream_num);
+    st = &merge->streams[sample->stream];
+
+    /* too late, already passed the output point, or out of order within its own stream */
+    if ((merge->has_output && sample->time < merge->last_out_time) ||
+        (st->count > 0 && sample->time < stream_tail(st, merge->depth)->time))
+    {
+        st->late_cnt++;
+        return;
+    }
+
+    /*
+     * stream queue is full, push out the oldest samples to make room. the heap top
+     * can belong to another stream, only count the samples of this stream
+     */
+    while (st->count == merge->depth)
+    {
+        if (merge_emit_top(merge) == sample->stream)
+            st->overflow_cnt++;
+    }
+
+    st->queue[(st->head + st->count) % merge->depth] = *sample;
+    st->count++;
+
+    if (st->count == 1)
+    {
+        merge->heap[merge->heap_size] = sample->stream;
+        heap_sift_up(merge, merge->heap_size++);
+    }
+
+    if (sample->time > merge->max_time)
+        merge->max_time = sample->time;
+
+    merge_drain(merge);
+}
+
+void ys_merge_flush(ys_merge_t *merge)
+{
+    while (merge->heap_size > 0)
+    {
+        merge_emit_top(merge);
+    }
+}
+
+void ys_resampler_init(ys_resampler_t *rs, uint64_t period, ys_resample_output_t output, void *user_data)
+{
+    memset(rs, 0, sizeof(ys_resampler_t));
+    rs->period    = period;
+    rs->output    = output;
+    rs->user_data = user_data;
+}
+
+void ys_resampler_push(ys_resampler_t *rs, const ys_merge_sample_t *sample)
+{
+    ys_merge_sample_t out;
+
+    if (sample->time < rs->prev.time && rs->has_prev)
+        return; /* out of order */
+
+    /* first sample or a long gap (missing frames): restart on the next grid point */
+    if (!rs->has_prev || sample->time - rs->prev.time > rs->period * YS_RESAMPLE_MAX_GAP)
+    {
+        rs->next_time = (sample->time + rs->period - 1) / rs->period * rs->period;
+        rs->prev      = *sample;
+        rs->has_prev  = 1;
+    }
+
+    while (rs->next_time <= sample->time)
+    {
+        ys_sample_interp(&rs->prev, sample, rs->next_time, &out);
+        rs->output(&out, rs->user_data);
+        rs->next_time += rs->period;
+    }
+
+    rs->prev = *sample;
+}
+
+void ys_sample_interp(const ys_merge_sample_t *a, const ys_merge_sample_t *b, uint64_t time, ys_merge_sample_t *out)
+{
+    const ys_sensor_data_t *da = &a->data;
+    const ys_sensor_data_t *db = &b->data;
+    ys_sensor_data_t *dst      = &out->data;
+    float t                    = 1.0f;
+
+    if (b->time > a->time)
+        t = (float)(time - a->time) / (float)(b->time - a->time);
+
+    /* increments and non interpolated fields are taken from the later sample */
+    *out      = *b;
+    out->time = time;
+
+    dst->sample_timestamp     = da->sample_timestamp + (uint32_t)(time - a->time);
+    dst->data_ready_timestamp = da->data_ready_timestamp + (uint32_t)(time - a->time);
+
+    dst->imu_temp = da->imu_temp + (db->imu_temp - da->imu_temp) * t;
+
+    lerp_arr(dst->accel, da->accel, db->accel, t, 3);
+    lerp_arr(dst->angle, da->angle, db->angle, t, 3);
+    lerp_arr(dst->mag, da->mag, db->mag, t, 3);
+    lerp_arr(dst->raw_mag, da->raw_mag, db->raw_mag, t, 3);
+    lerp_arr(dst->velocity, da->velocity, db->velocity, t, 3);
+
+    for (int i = 0; i < 3; i++)
+    {
+        dst->euler_angle[i] = lerp_angle(da->euler_angle[i], db->euler_angle[i], t);
+        dst->location[i]    = da->location[i] + (db->location[i] - da->location[i]) * t;
+    }
+
+    ys_quat_slerp(da->quaternion, db->quaternion, t, dst->quaternion);
+}
+
+//-------------------------- internal func ----------------------------------
+
+static void merge_drain(ys_merge_t *merge)
+{
+    while (merge->heap_size > 0)
+    {
+        ys_merge_stream_t *top = &merge->streams[merge->heap[0]];
+
+        /* every stream has a pending sample, the smallest one is final */
+        if (merge->heap_size == merge->stream_num)
+        {
+            merge_emit_top(merge);
+        }
+
+        /* some streams are late or missing, only wait for the reorder window */
+        else if (stream_head(top)->time + merge->window <= merge->max_time)
+        {
+            merge_emit_top(merge);
+        }
+
+        else
+        {
+            break;
+        }
+    }
+}
+
+static uint16_t merge_emit_top(ys_merge_t *merge)
+{
+    uint16_t stream           = merge->heap[0];
+    ys_merge_stream_t *st     = &merge->streams[stream];
+    ys_merge_sample_t *sample = stream_head(st);
+
+    merge->last_out_time = sample->time;
+    merge->has_output    = 1;
+
+    merge->output(sample, merge->max_time - sample->time, merge->user_data);
+
+    st->head = (uint16_t)((st->head + 1) % merge->depth);
+    st->count--;
+
+    if (st->count == 0)
+    {
+        merge->heap[0] = merge->heap[--merge->heap_size];
+    }
+
+    if (merge->heap_size > 0)
+        heap_sift_down(merge, 0);
+
+    return stream;
+}
+
+ys_static_inline bool heap_less(ys_merge_t *merge, uint16_t a, uint16_t b)
+{
+    uint64_t ta = stream_head(&merge->streams[a])->time;
+    uint64_t tb = stream_head(&merge->streams[b])->time;
+
+    return ta < tb || (ta == tb && a < b);
+}
+
+static void heap_sift_up(ys_merge_t *merge, uint16_t pos)
+{
+    uint16_t *heap = merge->heap;
+
+    while (pos > 0)
+    {
+        uint16_t parent = (uint16_t)((pos - 1) / 2);
+
+        if (!heap_less(merge, heap[pos], heap[parent]))
+            break;
+
+        uint16_t tmp = heap[pos];
+        heap[pos]    = heap[parent];
+        heap[parent] = tmp;
+        pos          = parent;
+    }
+}
+
+static void heap_sift_down(ys_merge_t *merge, uint16_t pos)
+{
+    uint16_t *heap = merge->heap;
+
+    for (;;)
+    {
+        uint16_t left     = (uint16_t)(pos * 2 + 1);
+        uint16_t right    = (uint16_t)(pos * 2 + 2);
+        uint16_t smallest = pos;
+
+        if (left < merge->heap_size && heap_less(merge, heap[left], heap[smallest]))
+            smallest = left;
+        if (right < merge->heap_size && heap_less(merge, heap[right], heap[smallest]))
+            smallest = right;
+
+        if (smallest == pos)
+            break;
+
+        uint16_t tmp   = heap[pos];
+        heap[pos]      = heap[smallest];
+        heap[smallest] = tmp;
+        pos            = smallest;
+    }
+}
+
+static void lerp_arr(float *dst, const float *a, const float *b, float t, uint8_t size)
+{
+    for (uint8_t i = 0; i < size; i++)
+    {
+        dst[i] = a[i] + (b[i] - a[i]) * t;
+    }
+}
+
+static float lerp_angle(float a, float b, float t)
+{
+    float diff = b - a;
+
+    if (diff > 180.0f)
+        diff -= 360.0f;
+    else if (diff < -180.0f)
+        diff += 360.0f;
+
+    float res = a + diff * t;
+
+    if (res > 180.0f)
+        res -= 360.0f;
+    else if (res < -180.0f)
+        res += 360.0f;
+
+    return res;
+}
@@ -0,0 +1,197 @@
+/**
+ * Yesense 多传感器数据流时间对齐合并
+ *
+ * 将 N 路传感器的解析结果按时间顺序合并为一路输出（基于最小堆的 k 路归并），
+ * 并提供可选的重采样器，将单路数据插值到统一的时间网格上。
+ *
+ * 输出规则：
+ *  - 当所有数据流都有待输出样本时，输出时间最早的样本
+ *  - 否则仅输出时间早于 (已见最新时间 - 重排窗口) 的样本，因此某一路数据延迟或中断时不会阻塞其他数据流
+ *  - 时间早于上一个已输出样本的迟到样本将被丢弃并计数
+ *
+ * 时间使用展开后的 sample_timestamp（64 位，单位 us）加上每一路的时钟偏移。
+ *
+ * @author github0null
+ * @version 1.0
+ * @see https://github.com/github0null/
+*/
+
+#ifndef H_YS_MERGE
+#define H_YS_MERGE
+
+#include <stdint.h>
+#include "ys_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////
+//                  Type Define
+//////////////////////////////////////////////////////
+
+typedef struct
+{
+    uint64_t time;   /* 对齐后的采样时间，单位：us */
+    uint16_t stream; /* 数据流索引 */
+    uint16_t tid;
+    ys_sensor_data_t data;
+} ys_merge_sample_t;
+
+/**
+ * 合并输出回调
+ *
+ * @param sample 输出样本
+ *
+ * @param align_latency 对齐延迟：输出时已见的最新时间与该样本时间之差，单位：us
+ *
+ * @param user_data 用户数据
+*/
+typedef void (*ys_merge_output_t)(const ys_merge_sample_t *sample, uint64_t align_latency, void *user_data);
+
+typedef struct
+{
+    ys_merge_sample_t *queue; /* ring buffer, 'depth' samples */
+    uint16_t head;
+    uint16_t count;
+
+    int64_t clock_offset; /* added to the unwrapped time */
+    uint64_t time_high;
+    uint32_t last_time;
+    uint8_t has_time;
+
+    uint32_t late_cnt;     /* 迟到丢弃的样本数 */
+    uint32_t overflow_cnt; /* 本路队列满时，本路样本被强制提前输出的次数 */
+} ys_merge_stream_t;
+
+typedef struct
+{
+    ys_merge_stream_t *streams;
+    uint16_t *heap; /* stream index, ordered by head sample time */
+    uint16_t heap_size;
+    uint16_t stream_num;
+    uint16_t depth;
+
+    uint64_t window;        /* 重排窗口，单位：us */
+    uint64_t max_time;      /* 已见的最新时间 */
+    uint64_t last_out_time; /* 上一个输出样本的时间 */
+    uint8_t has_output;
+
+    ys_merge_output_t output;
+    void *user_data;
+} ys_merge_t;
+
+/* 重采样器输出回调，sample->time 为网格时间 */
+typedef void (*ys_resample_output_t)(const ys_merge_sample_t *sample, void *user_data);
+
+typedef struct
+{
+    uint64_t period;    /* 网格周期，单位：us */
+    uint64_t next_time; /* 下一个网格时间 */
+    ys_merge_sample_t prev;
+    uint8_t has_prev;
+
+    ys_resample_output_t output;
+    void *user_data;
+} ys_resampler_t;
+
+//////////////////////////////////////////////////////
+//                  Merge API
+//////////////////////////////////////////////////////
+
+/**
+ * 创建一个多路合并器
+ *
+ * @param stream_num 数据流数量
+ *
+ * @param depth 每路数据流的缓存深度（样本数），不能为 0
+ *
+ * @param window 重排窗口，单位：us
+ *
+ * @param output 输出回调
+ *
+ * @param user_data 用户数据
+ *
+ * @return 合并器对象，参数无效或内存不足时返回 NULL
+*/
+ys_merge_t *ys_merge_create(uint16_t stream_num, uint16_t depth, uint64_t window,
+                            ys_merge_output_t output, void *user_data);
+
+/**
+ * 释放合并器
+*/
+void ys_merge_free(ys_merge_t *merge);
+
+/**
+ * 设置某一路数据流的时钟偏移，用于将各传感器的采样时钟对齐到同一时间基准
+ *
+ * @param clock_offset 时钟偏移，单位：us
+*/
+void ys_merge_set_clock_offset(ys_merge_t *merge, uint16_t stream, int64_t clock_offset);
+
+/**
+ * 输入一路数据流的一个解析结果，可直接在该路解析器的结果回调中调用
+ *
+ * 解析结果中需包含 YS_ID_SAMPLE_TIMESTAMP 字段，否则将被忽略
+ *
+ * @param merge 合并器对象
+ *
+ * @param stream 数据流索引
+ *
+ * @param params 解析器回调参数
+*/
+void ys_merge_push(ys_merge_t *merge, uint16_t stream, const ys_result_callback_params_t *params);
+
+/**
+ * 输入一个已对齐时间的样本，sample->stream 指定数据流
+*/
+void ys_merge_push_sample(ys_merge_t *merge, const ys_merge_sample_t *sample);
+
+/**
+ * 输出所有缓存的样本，通常在数据结束时调用
+*/
+void ys_merge_flush(ys_merge_t *merge);
+
+//////////////////////////////////////////////////////
+//                  Resampler API
+//////////////////////////////////////////////////////
+
+/**
+ * 初始化重采样器
+ *
+ * @param rs 重采样器对象
+ *
+ * @param period 网格周期，单位：us
+ *
+ * @param output 输出回调
+ *
+ * @param user_data 用户数据
+*/
+void ys_resampler_init(ys_resampler_t *rs, uint64_t period, ys_resample_output_t output, void *user_data);
+
+/**
+ * 输入一个样本，输出落在上一个样本与该样本之间的所有网格点。
+ *
+ * 向量与温度、位置使用线性插值，欧拉角按 ±180° 回绕插值，四元数使用球面线性插值，
+ * 增量类数据（quaternion_inc, speed_inc）取后一个样本的值。
+*/
+void ys_resampler_push(ys_resampler_t *rs, const ys_merge_sample_t *sample);
+
+/**
+ * 在两个样本之间插值
+ *
+ * @param a 前一个样本
+ *
+ * @param b 后一个样本
+ *
+ * @param time 插值时间，应位于 [a->time, b->time] 内
+ *
+ * @param out 输出样本
+*/
+void ys_sample_interp(const ys_merge_sample_t *a, const ys_merge_sample_t *b, uint64_t time, ys_merge_sample_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -7,6 +7,9 @@
 #define YS_HEADER_1    0x59
 #define YS_HEADER_2    0x53
 
+/* header, tid, len, message and checksum */
+#define YS_FRAME_MAX_LEN (5 + YS_MSG_MAX_LEN + 2)
+
 #define INTEGER_LEN    4
 #define INTEGER_64_LEN 8
 
@@ -75,13 +78,46 @@ typedef struct
 } ys_packet_info_t;
 #pragma pack()
 
+typedef void (*ys_field_decoder_t)(ys_parser_t *parser, const uint8_t *data);
+
+typedef struct
+{
+    uint8_t len;
+    ys_field_decoder_t decode;
+} ys_field_desc_t;
+
+enum
+{
+    FIELD_IMU_TEMP = 0,
+    FIELD_SPEED_INCREMENT,
+    FIELD_SECOND_IMU_TEMP,
+    FIELD_SECOND_ACCEL,
+    FIELD_SECOND_ANGLE,
+    FIELD_QUATERNION_INCREMENT,
+    FIELD_ACCEL,
+    FIELD_ANGLE,
+    FIELD_MAGNETIC,
+    FIELD_RAW_MAGNETIC,
+    FIELD_EULER,
+    FIELD_QUATERNION,
+    FIELD_LOCATION,
+    FIELD_HIGH_PRECI_LOCATION,
+    FIELD_SPEED,
+    FIELD_SAMPLE_TIMESTAMP,
+    FIELD_DATA_READY_TIMESTAMP,
+    FIELD_SKIP, /* known field which is not decoded, skipped by length */
+    FIELD_NUM
+};
+
+#define YS_FIELD_NONE 0xFF
+
 //-------------------------- internal func ----------------------------------
 
-static int32_t get_signed_int(uint8_t *buf, uint16_t offset);
+static int32_t get_signed_int(const uint8_t *buf, uint16_t offset);
 
-static int64_t get_signed_int64(uint8_t *buf, uint16_t offset);
+static int64_t get_signed_int64(const uint8_t *buf, uint16_t offset);
 
-static void int_to_float_arr(float *dst, uint16_t dst_size, uint8_t *src, float ratio);
+static void int_to_float_arr(float *dst, uint16_t dst_size, const uint8_t *src, float ratio);
 
 static void ys_buffer_push(ys_parser_t *parser, uint8_t dat);
 
@@ -91,9 +127,64 @@ static void ys_buffer_reset(ys_parser_t *parser);
 
 static int8_t ys_parse_frame(ys_parser_t *parser, ys_frame *frame);
 
-static int32_t find_ys_header(uint8_t *buf, uint32_t len);
+static ys_parser_status_t ys_parser_feed(ys_parser_t *parser, uint8_t byte, bool defer, uint32_t *frame_cnt);
+
+static ys_parser_status_t ys_parser_step(ys_parser_t *parser, uint8_t byte, bool defer);
+
+static uint16_t ys_parser_resync(ys_parser_t *parser, uint8_t byte, bool defer);
+
+static int16_t ys_resync_check(const uint8_t *replay, const uint8_t *sum, const uint8_t *wsum, uint16_t start, uint16_t len);
+
+static void ys_resync_sum(ys_buffer *buf);
+
+static void ys_resync_keep(ys_parser_t *parser, uint16_t start, uint16_t end);
+
+static uint32_t ys_parser_feed_msg(ys_parser_t *parser, const uint8_t *data, uint32_t len);
 
-static bool parse_data_by_id(ys_sensor_data_t *sensor_data, uint8_t id, uint8_t len, uint8_t *data);
+#ifdef YS_HAS_DEFER_PARSE
+static bool ys_defer_push(ys_parser_t *parser, ys_frame *frame);
+#endif
+
+static void ys_seq_update(ys_link_stat_t *link, uint16_t tid);
+
+static void ys_parse_fields(ys_parser_t *parser, ys_frame *frame, ys_result_callback_params_t *cb_params);
+
+static uint8_t ys_find_field(ys_parser_t *parser, uint8_t id, uint8_t len);
+
+#ifdef YS_HAS_LAYOUT_CACHE
+static bool ys_layout_match(const ys_layout_cache *layout, const ys_frame *frame);
+static void ys_layout_decode(ys_parser_t *parser, ys_frame *frame, ys_result_callback_params_t *cb_params);
+static void ys_layout_learn(ys_parser_t *parser, const ys_layout_cache *layout);
+#endif
+
+static int16_t get_signed_int16(const uint8_t *buf, uint16_t offset);
+
+static uint32_t get_unsigned_int(const uint8_t *buf, uint16_t offset);
+
+#ifdef YS_HAS_CALIB
+static bool calib_decode(ys_parser_t *parser, ys_calib_sensor_t sensor, float *dst, const uint8_t *data);
+#endif
+
+/* field decoders, 'data' points to the field data after id and len */
+
+static void decode_imu_temp(ys_parser_t *parser, const uint8_t *data);
+static void decode_speed_inc(ys_parser_t *parser, const uint8_t *data);
+static void decode_second_imu_temp(ys_parser_t *parser, const uint8_t *data);
+static void decode_second_accel(ys_parser_t *parser, const uint8_t *data);
+static void decode_second_angle(ys_parser_t *parser, const uint8_t *data);
+static void decode_quat_inc(ys_parser_t *parser, const uint8_t *data);
+static void decode_accel(ys_parser_t *parser, const uint8_t *data);
+static void decode_angle(ys_parser_t *parser, const uint8_t *data);
+static void decode_mag(ys_parser_t *parser, const uint8_t *data);
+static void decode_raw_mag(ys_parser_t *parser, const uint8_t *data);
+static void decode_euler(ys_parser_t *parser, const uint8_t *data);
+static void decode_quat(ys_parser_t *parser, const uint8_t *data);
+static void decode_location(ys_parser_t *parser, const uint8_t *data);
+static void decode_high_preci_location(ys_parser_t *parser, const uint8_t *data);
+static void decode_speed(ys_parser_t *parser, const uint8_t *data);
+static void decode_sample_timestamp(ys_parser_t *parser, const uint8_t *data);
+static void decode_data_ready_timestamp(ys_parser_t *parser, const uint8_t *data);
+static void decode_skip(ys_parser_t *parser, const uint8_t *data);
 
 #define ys_action_go_next(_parser)    _parser->cur_action++
 
@@ -101,7 +192,59 @@ static bool parse_data_by_id(ys_sensor_data_t *sensor_data, uint8_t id, uint8_t
 
 #define ys_record_error(_parser, err) _parser->trace_inf.err_frame_cnt++, _parser->trace_inf.status = err
 
-#define ys_check_msg_len(len)         (((len) >= YS_PARSER_MIN_MSG_LEN) && ((len) < 200))
+#define ys_check_msg_len(len)         (((len) >= YS_PARSER_MIN_MSG_LEN) && ((len) < YS_MSG_MAX_LEN))
+
+/* decoders of the supported fields, indexed by FIELD_xxx */
+static const ys_field_desc_t field_desc[FIELD_NUM] = {
+    [FIELD_IMU_TEMP]             = {IMU_TEMP_DATA_LEN, decode_imu_temp},
+    [FIELD_SPEED_INCREMENT]      = {SPEED_INCREMENT_DATA_LEN, decode_speed_inc},
+    [FIELD_SECOND_IMU_TEMP]      = {SECOND_IMU_TEMP_DATA_LEN, decode_second_imu_temp},
+    [FIELD_SECOND_ACCEL]         = {SECOND_ACCEL_DATA_LEN, decode_second_accel},
+    [FIELD_SECOND_ANGLE]         = {SECOND_ANGLE_DATA_LEN, decode_second_angle},
+    [FIELD_QUATERNION_INCREMENT] = {QUATERNION_INCREMENT_DATA_LEN, decode_quat_inc},
+    [FIELD_ACCEL]                = {ACCEL_DATA_LEN, decode_accel},
+    [FIELD_ANGLE]                = {ANGLE_DATA_LEN, decode_angle},
+    [FIELD_MAGNETIC]             = {MAGNETIC_DATA_LEN, decode_mag},
+    [FIELD_RAW_MAGNETIC]         = {MAGNETIC_RAW_DATA_LEN, decode_raw_mag},
+    [FIELD_EULER]                = {EULER_DATA_LEN, decode_euler},
+    [FIELD_QUATERNION]           = {QUATERNION_DATA_LEN, decode_quat},
+    [FIELD_LOCATION]             = {LOCATION_DATA_LEN, decode_location},
+    [FIELD_HIGH_PRECI_LOCATION]  = {HIGH_PRECI_LOCATION_DATA_LEN, decode_high_preci_location},
+    [FIELD_SPEED]                = {SPEED_DATA_LEN, decode_speed},
+    [FIELD_SAMPLE_TIMESTAMP]     = {SAMPLE_TIMESTAMP_DATA_LEN, decode_sample_timestamp},
+    [FIELD_DATA_READY_TIMESTAMP] = {DATA_READY_TIMESTAMP_DATA_LEN, decode_data_ready_timestamp},
+    [FIELD_SKIP]                 = {0, decode_skip},
+};
+
+/* data id -> field_desc index + 1, 0 for unsupported ids */
+#define FIELD_INDEX_COMMON                                   \
+    [IMU_TEMP_ID]             = FIELD_IMU_TEMP + 1,             \
+    [SPEED_INCREMENT_ID]      = FIELD_SPEED_INCREMENT + 1,      \
+    [QUATERNION_INCREMENT_ID] = FIELD_QUATERNION_INCREMENT + 1, \
+    [ACCEL_ID]                = FIELD_ACCEL + 1,                \
+    [ANGLE_ID]                = FIELD_ANGLE + 1,                \
+    [MAGNETIC_ID]             = FIELD_MAGNETIC + 1,             \
+    [RAW_MAGNETIC_ID]         = FIELD_RAW_MAGNETIC + 1,         \
+    [EULER_ID]                = FIELD_EULER + 1,                \
+    [QUATERNION_ID]           = FIELD_QUATERNION + 1,           \
+    [LOCATION_ID]             = FIELD_LOCATION + 1,             \
+    [HIGH_PRECI_LOCATION_ID]  = FIELD_HIGH_PRECI_LOCATION + 1,  \
+    [SPEED_ID]                = FIELD_SPEED + 1,                \
+    [SAMPLE_TIMESTAMP_ID]     = FIELD_SAMPLE_TIMESTAMP + 1,     \
+    [DATA_READY_TIMESTAMP_ID] = FIELD_DATA_READY_TIMESTAMP + 1
+
+/* single imu parser, the second imu fields are skipped */
+static const uint8_t field_index[256] = {
+    FIELD_INDEX_COMMON,
+};
+
+/* dual imu parser, see ys_parser_enable_dual_imu */
+static const uint8_t field_index_dual[256] = {
+    FIELD_INDEX_COMMON,
+    [SECOND_IMU_TEMP_ID] = FIELD_SECOND_IMU_TEMP + 1,
+    [SECOND_ACCEL_ID]    = FIELD_SECOND_ACCEL + 1,
+    [SECOND_ANGLE_ID]    = FIELD_SECOND_ANGLE + 1,
+};
 
 //---------------------------------------------------------------------------
 
@@ -135,7 +278,56 @@ void *ys_parser_get_user_data(ys_parser_t *parser)
     return parser->user_data;
 }
 
+void ys_parser_enable_dual_imu(ys_parser_t *parser, ys_dual_imu_data_t *dual_imu)
+{
+    parser->dual_imu = dual_imu;
+
+#ifdef YS_HAS_LAYOUT_CACHE
+    /* the learned layout depends on which fields are decoded */
+    memset(&parser->layout, 0, sizeof(ys_layout_cache));
+#endif
+}
+
+#ifdef YS_HAS_CALIB
+void ys_parser_set_calib(ys_parser_t *parser, const ys_calib_profile_t *profile)
+{
+    /* the fields of the profile written before are visible to the frame which loads it */
+    ys_store_release(&parser->calib, profile);
+}
+#endif
+
 ys_parser_status_t ys_parser_input(ys_parser_t *parser, uint8_t byte)
+{
+    parser->trace_inf.link.rx_bytes++;
+    return ys_parser_feed(parser, byte, false, NULL);
+}
+
+/* frame_cnt (may be NULL) counts every frame done by this byte, including the ones recovered by the rescan */
+static ys_parser_status_t ys_parser_feed(ys_parser_t *parser, uint8_t byte, bool defer, uint32_t *frame_cnt)
+{
+    ys_parser_status_t status = ys_parser_step(parser, byte, defer);
+
+    if (status == YS_STATUS_DONE && frame_cnt != NULL)
+        (*frame_cnt)++;
+
+    if (status < YS_STATUS_RUNNING)
+    {
+        if (status == YS_STATUS_CHK_ERR)
+            ys_probe3(chk_err, parser, parser->cur_frame.tid, parser->cur_frame.len);
+        else if (status == YS_STATUS_MSG_LEN_ERR)
+            ys_probe3(len_err, parser, parser->cur_frame.tid, byte);
+
+        /* a real header may hide in the bytes of the broken frame, rescan them */
+        uint16_t recovered = ys_parser_resync(parser, byte, defer);
+
+        if (frame_cnt != NULL)
+            *frame_cnt += recovered;
+    }
+
+    return status;
+}
+
+static ys_parser_status_t ys_parser_step(ys_parser_t *parser, uint8_t byte, bool defer)
 {
     /* reset parser status */
     parser->trace_inf.status = YS_STATUS_RUNNING;
@@ -159,12 +351,21 @@ ys_parser_status_t ys_parser_input(ys_parser_t *parser, uint8_t byte)
     {
         if (byte != YS_HEADER_2)
         {
+            /* 'YYS': the second 'Y' may start the frame */
+            if (byte == YS_HEADER_1)
+            {
+                ys_buffer_reset(parser);
+                ys_buffer_push(parser, byte);
+                return (ys_parser_status_t)parser->trace_inf.status;
+            }
+
             ys_action_reset(parser);
             return (ys_parser_status_t)parser->trace_inf.status;
         }
 
         ys_buffer_push(parser, byte);
         ys_action_go_next(parser);
+        ys_probe1(frame_start, parser);
     }
 
     // TID LOW BYTE
@@ -221,6 +422,7 @@ ys_parser_status_t ys_parser_input(ys_parser_t *parser, uint8_t byte)
     {
         if (parser->cur_frame.crc[0] == byte) // check ck1
         {
+            ys_buffer_push(parser, byte); // keep it for resync
             ys_action_go_next(parser);
         }
         else // ck1 error
@@ -236,7 +438,24 @@ ys_parser_status_t ys_parser_input(ys_parser_t *parser, uint8_t byte)
         // if check done !, parse full frame
         if (parser->cur_frame.crc[1] == byte)
         {
-            ys_parse_frame(parser, &parser->cur_frame);
+#ifdef YS_HAS_DEFER_PARSE
+            if (defer)
+            {
+                if (!ys_defer_push(parser, &parser->cur_frame))
+                {
+                    parser->trace_inf.drop_frame_cnt++; /* defer queue full, drop it */
+                    ys_action_reset(parser);
+                    return (ys_parser_status_t)parser->trace_inf.status;
+                }
+            }
+            else
+#else
+            (void)defer;
+#endif
+            {
+                ys_parse_frame(parser, &parser->cur_frame);
+            }
+
             parser->trace_inf.done_frame_cnt++;        /* increment done frame cnt */
             parser->trace_inf.status = YS_STATUS_DONE; /* set done flags */
         }
@@ -261,272 +480,400 @@ ys_parser_status_t ys_parser_input(ys_parser_t *parser, uint8_t byte)
 
 void ys_parse_buf(ys_parser_t *parser, uint8_t *buffer, uint32_t buffer_size)
 {
-    uint16_t prev_index = 0;
+    ys_parse_buf_ex(parser, buffer, buffer_size, 0, NULL);
+}
+
+size_t ys_parse_buf_ex(ys_parser_t *parser, const uint8_t *buffer, size_t len, uint32_t max_frames, ys_parse_result_t *result)
+{
+    size_t index       = 0;
+    uint32_t frame_cnt = 0;
+
+    while (index < len && (max_frames == 0 || frame_cnt < max_frames))
+    {
+        /* fast skip noise between frames */
+        if (parser->cur_action == ON_PARSE_HEADDER_1)
+        {
+            const uint8_t *pos = memchr(&buffer[index], YS_HEADER_1, len - index);
+
+            if (pos == NULL)
+            {
+                index = len;
+                break;
+            }
+
+            index = (size_t)(pos - buffer);
+        }
+
+        /* bulk copy message body */
+        else if (parser->cur_action == ON_PARSE_MESSAGE)
+        {
+            size_t avail = len - index;
+            index += ys_parser_feed_msg(parser, &buffer[index], avail > YS_MSG_MAX_LEN ? YS_MSG_MAX_LEN : (uint32_t)avail);
+            continue;
+        }
 
-    for (uint16_t index = 0; index < buffer_size;)
+        ys_parser_feed(parser, buffer[index++], false, &frame_cnt);
+    }
+
+    parser->trace_inf.link.rx_bytes += (uint32_t)index;
+
+    if (result != NULL)
     {
-        int32_t ys_pos = find_ys_header(&buffer[index], buffer_size - index);
+        result->consumed  = index;
+        result->frame_cnt = frame_cnt;
+        result->action    = parser->cur_action;
+        result->pending   = parser->cur_action == ON_PARSE_HEADDER_1 ? 0 : (uint16_t)(parser->data_buf.count - parser->data_buf.start);
+    }
 
-        if (ys_pos == -1)
-            break; /* not found ys header, exit */
+    return index;
+}
 
-        /* locate start pos */
-        index += ys_pos;
-        prev_index = index;
+void ys_checksum(const uint8_t *buf, uint32_t len, uint8_t crc[2])
+{
+    crc[0] = 0;
+    crc[1] = 0;
 
-        int16_t status = YS_STATUS_RUNNING;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        ys_calcu_checksum(crc, buf[i]);
+    }
+}
 
-        for (; index < buffer_size && status == YS_STATUS_RUNNING; index++)
+uint8_t ys_data_id_len(uint8_t id)
+{
+    switch (id)
+    {
+        case IMU_TEMP_ID:             return IMU_TEMP_DATA_LEN;
+        case SECOND_IMU_TEMP_ID:      return SECOND_IMU_TEMP_DATA_LEN;
+        case FREE_ACCEL_ID:           return FREE_ACCEL_DATA_LEN;
+        case SPEED_INCREMENT_ID:      return SPEED_INCREMENT_DATA_LEN;
+        case SECOND_ACCEL_ID:         return SECOND_ACCEL_DATA_LEN;
+        case SECOND_ANGLE_ID:         return SECOND_ANGLE_DATA_LEN;
+        case QUATERNION_INCREMENT_ID: return QUATERNION_INCREMENT_DATA_LEN;
+        case ACCEL_ID:                return ACCEL_DATA_LEN;
+        case ANGLE_ID:                return ANGLE_DATA_LEN;
+        case MAGNETIC_ID:             return MAGNETIC_DATA_LEN;
+        case RAW_MAGNETIC_ID:         return MAGNETIC_RAW_DATA_LEN;
+        case EULER_ID:                return EULER_DATA_LEN;
+        case QUATERNION_ID:           return QUATERNION_DATA_LEN;
+        case UTC_ID:                  return UTC_DATA_LEN;
+        case SAMPLE_TIMESTAMP_ID:     return SAMPLE_TIMESTAMP_DATA_LEN;
+        case DATA_READY_TIMESTAMP_ID: return DATA_READY_TIMESTAMP_DATA_LEN;
+        case LOCATION_ID:             return LOCATION_DATA_LEN;
+        case HIGH_PRECI_LOCATION_ID:  return HIGH_PRECI_LOCATION_DATA_LEN;
+        case SPEED_ID:                return SPEED_DATA_LEN;
+        default:                      return 0;
+    }
+}
+
+uint8_t ys_parser_update_link(ys_parser_t *parser, uint32_t baud, uint32_t elapsed_ms)
+{
+    ys_link_stat_t *link = &parser->trace_inf.link;
+    uint32_t rx_bytes    = link->rx_bytes - link->last_rx_bytes;
+    uint32_t lost        = link->lost_frame_cnt - link->last_lost_cnt;
+    uint16_t done        = (uint16_t)(parser->trace_inf.done_frame_cnt - link->last_done_cnt);
+    uint16_t err         = (uint16_t)(parser->trace_inf.err_frame_cnt - link->last_err_cnt);
+    uint64_t capacity    = (uint64_t)baud * elapsed_ms; /* bits per 1000 seconds */
+    uint8_t flags        = 0;
+
+    if (capacity > 0)
+    {
+        uint64_t load       = (uint64_t)rx_bytes * YS_UART_BITS_PER_BYTE * 1000 * 1000 / capacity;
+        link->load_permille = (uint16_t)(load > 0xFFFF ? 0xFFFF : load);
+    }
+
+    link->err_permille = (done + err) > 0 ? (uint16_t)((uint32_t)err * 1000 / ((uint32_t)done + err)) : 0;
+
+    if (link->load_permille >= YS_LINK_SATURATION_PERMILLE)
+        flags |= YS_LINK_SATURATED;
+    if (lost > 0)
+        flags |= YS_LINK_LOSS;
+    if (err > 0)
+        flags |= YS_LINK_ERROR;
+    if ((flags & YS_LINK_SATURATED) && (flags & (YS_LINK_LOSS | YS_LINK_ERROR)))
+        flags |= YS_LINK_OVERRUN;
+
+    link->flags         = flags;
+    link->last_rx_bytes = link->rx_bytes;
+    link->last_lost_cnt = link->lost_frame_cnt;
+    link->last_done_cnt = parser->trace_inf.done_frame_cnt;
+    link->last_err_cnt  = parser->trace_inf.err_frame_cnt;
+
+    return flags;
+}
+
+#ifdef YS_HAS_DEFER_PARSE
+
+uint32_t ys_parser_input_chunk(ys_parser_t *parser, const uint8_t *chunk, uint32_t len, uint32_t budget)
+{
+    uint32_t index = 0;
+
+    if (budget != 0 && budget < len)
+        len = budget;
+
+    while (index < len)
+    {
+        /* fast skip noise between frames */
+        if (parser->cur_action == ON_PARSE_HEADDER_1)
         {
-            status = ys_parser_input(parser, buffer[index]);
+            const uint8_t *pos = memchr(&chunk[index], YS_HEADER_1, len - index);
+
+            if (pos == NULL)
+            {
+                parser->trace_inf.status = YS_STATUS_RUNNING;
+                index                    = len;
+                break;
+            }
+
+            index = (uint32_t)(pos - chunk);
         }
 
-        if (status < YS_STATUS_RUNNING) /* if parse failed, rollback index ! */
+        /* bulk copy message body */
+        else if (parser->cur_action == ON_PARSE_MESSAGE)
         {
-            index = prev_index + 2; /* '+2': skip ys header */
+            index += ys_parser_feed_msg(parser, &chunk[index], len - index);
+            continue;
         }
+
+        ys_parser_feed(parser, chunk[index++], true, NULL);
     }
+
+    parser->trace_inf.link.rx_bytes += index;
+
+    return index;
 }
 
-int8_t ys_parse_frame(ys_parser_t *parser, ys_frame *frame)
+uint8_t ys_parser_poll(ys_parser_t *parser, uint8_t max_frames)
 {
-    int16_t msg_len;
-    uint8_t *packet_ptr;
+    ys_defer_queue *queue = &parser->defer_queue;
+    uint8_t frame_cnt     = 0;
+    uint8_t tail          = queue->tail; /* only written here */
+
+    while (max_frames == 0 || frame_cnt < max_frames)
+    {
+        /* acquire: pairs with the release in ys_defer_push, the slot is filled */
+        if (ys_load_acquire(&queue->head) == tail)
+            break; /* queue empty */
+
+        /* the slot at 'tail' is owned by us until tail is advanced */
+        ys_pending_frame *pending = &queue->frames[tail];
+
+        ys_frame frame = {
+            .tid = pending->tid,
+            .len = pending->len,
+            .msg = pending->msg,
+        };
+
+        ys_parse_frame(parser, &frame);
+        frame_cnt++;
+
+        /* release: the slot may be refilled only after we stopped reading it */
+        tail = (uint8_t)((tail + 1) % (YS_DEFER_QUEUE_SIZE + 1));
+        ys_store_release(&queue->tail, tail);
+    }
+
+    return frame_cnt;
+}
+
+#endif // YS_HAS_DEFER_PARSE
 
+int8_t ys_parse_frame(ys_parser_t *parser, ys_frame *frame)
+{
     ys_result_callback_params_t cb_params = {
         .tid       = frame->tid,
         .result    = &parser->sensor_data,
         .user_data = parser->user_data,
+        .dual_imu  = parser->dual_imu,
         .field_cnt = 0,
     };
 
+    ys_seq_update(&parser->trace_inf.link, frame->tid);
+
     memset(&parser->sensor_data, 0, sizeof(ys_sensor_data_t));
 
-    for (packet_ptr = frame->msg, msg_len = frame->len; msg_len > 0;)
-    {
-        // get packet info
-        ys_packet_info_t *packet_info = (ys_packet_info_t *)packet_ptr;
+    if (parser->dual_imu != NULL)
+        memset(parser->dual_imu, 0, sizeof(ys_dual_imu_data_t));
 
-        if (parse_data_by_id(
-                &parser->sensor_data,
-                packet_info->id,
-                packet_info->len,
-                packet_ptr + sizeof(ys_packet_info_t)))
-        {
-            cb_params.field_li[cb_params.field_cnt++] = packet_info->id; /* set available field id */
-            msg_len -= (sizeof(ys_packet_info_t) + packet_info->len);
-            packet_ptr += (sizeof(ys_packet_info_t) + packet_info->len);
-        }
-        else
-        {
-            msg_len--;
-            packet_ptr++;
-        }
+#ifdef YS_HAS_CALIB
+    /* take the bound profile once, all fields of this frame use the same one */
+    parser->calib_active = ys_load_acquire(&parser->calib);
+    cb_params.calib = parser->calib_active;
+#endif
+
+#ifdef YS_HAS_LAYOUT_CACHE
+    if (ys_layout_match(&parser->layout, frame))
+    {
+        ys_layout_decode(parser, frame, &cb_params);
+    }
+    else
+#endif
+    {
+        ys_parse_fields(parser, frame, &cb_params);
     }
 
+    ys_probe4(frame_done, parser, frame->tid, frame->len, cb_params.field_cnt);
+
     /* invoke result callbk */
     ys_assert(parser->callbk != NULL);
+    ys_probe2(callback_entry, parser, frame->tid);
     parser->callbk(&cb_params);
+    ys_probe2(callback_exit, parser, frame->tid);
 
     return true;
 }
 
-bool parse_data_by_id(ys_sensor_data_t *sensor_data, uint8_t id, uint8_t len, uint8_t *data)
+static void ys_parse_fields(ys_parser_t *parser, ys_frame *frame, ys_result_callback_params_t *cb_params)
 {
-    switch (id)
-    {
-        case IMU_TEMP_ID:
-        {
-            if (IMU_TEMP_DATA_LEN == len)
-            {
-                volatile int16_t temp = *((int16_t *)data);
-                sensor_data->imu_temp = (float)temp * IMU_TEMP_FACTOR;
-                return true;
-            }
-        }
-        break;
+    int16_t msg_len;
+    uint8_t *packet_ptr;
 
-        case SPEED_INCREMENT_ID:
-        {
-            if (SPEED_INCREMENT_DATA_LEN == len)
-            {
-                int_to_float_arr(sensor_data->speed_inc, 3, data, NOT_MAG_DATA_FACTOR);
-                return true;
-            }
-        }
-        break;
+#ifdef YS_HAS_LAYOUT_CACHE
+    ys_layout_cache layout = {
+        .msg_len = (uint8_t)frame->len,
+    };
+    bool cacheable = true;
+#endif
+
+    for (packet_ptr = frame->msg, msg_len = frame->len; msg_len > 0;)
+    {
+        // get packet info
+        ys_packet_info_t *packet_info = (ys_packet_info_t *)packet_ptr;
+        uint8_t desc_idx              = ys_find_field(parser, packet_info->id, packet_info->len);
 
-#ifdef YS_HAS_DUAL_IMU
+        /* a known field which this parser does not decode, skip it as a whole */
+        if (desc_idx == YS_FIELD_NONE && packet_info->len != 0 && ys_data_id_len(packet_info->id) == packet_info->len)
+            desc_idx = FIELD_SKIP;
 
-        case SECOND_IMU_TEMP_ID:
+        if (desc_idx != YS_FIELD_NONE)
         {
-            if (SECOND_IMU_TEMP_DATA_LEN == len)
+            field_desc[desc_idx].decode(parser, packet_ptr + sizeof(ys_packet_info_t));
+
+#ifdef YS_HAS_LAYOUT_CACHE
+            if (layout.field_cnt < YS_LAYOUT_MAX_FIELDS)
             {
-                volatile int16_t temp        = *((int16_t *)data);
-                sensor_data->second_imu_temp = ((float)temp) * IMU_TEMP_FACTOR;
-                return true;
-            }
-        }
-        break;
+                layout.offset[layout.field_cnt] = (uint8_t)(packet_ptr - frame->msg);
+                layout.desc[layout.field_cnt]   = desc_idx;
+                memcpy(&layout.tag[layout.field_cnt], packet_ptr, sizeof(uint16_t));
+                layout.field_cnt++;
 
-        case SECOND_ACCEL_ID:
-        {
-            if (SECOND_ACCEL_DATA_LEN == len)
+                if (desc_idx != FIELD_SKIP)
+                    layout.id[layout.id_cnt++] = packet_info->id;
+            }
+            else
             {
-                int_to_float_arr(sensor_data->second_accel, 3, data, NOT_MAG_DATA_FACTOR);
-                return true;
+                cacheable = false;
             }
-        }
-        break;
+#endif
+
+            if (desc_idx != FIELD_SKIP)
+                cb_params->field_li[cb_params->field_cnt++] = packet_info->id; /* set available field id */
 
-        case SECOND_ANGLE_ID:
+            msg_len -= (sizeof(ys_packet_info_t) + packet_info->len);
+            packet_ptr += (sizeof(ys_packet_info_t) + packet_info->len);
+        }
+        else
         {
-            if (SECOND_ANGLE_DATA_LEN == len)
-            {
-                int_to_float_arr(sensor_data->second_angle, 3, data, NOT_MAG_DATA_FACTOR);
-                return true;
-            }
+#ifdef YS_HAS_LAYOUT_CACHE
+            cacheable = false;
+#endif
+            msg_len--;
+            packet_ptr++;
         }
-        break;
+    }
 
+#ifdef YS_HAS_LAYOUT_CACHE
+    ys_layout_learn(parser, cacheable && msg_len == 0 ? &layout : NULL);
 #endif
+}
 
-        case QUATERNION_INCREMENT_ID:
-        {
-            if (QUATERNION_INCREMENT_DATA_LEN == len)
-            {
-                int_to_float_arr(sensor_data->quaternion_inc, 4, data, NOT_MAG_DATA_FACTOR);
-                return true;
-            }
-        }
-        break;
+static uint8_t ys_find_field(ys_parser_t *parser, uint8_t id, uint8_t len)
+{
+    uint8_t desc_idx = parser->dual_imu != NULL ? field_index_dual[id] : field_index[id];
 
-        case ACCEL_ID:
-        {
-            if (ACCEL_DATA_LEN == len)
-            {
-                int_to_float_arr(sensor_data->accel, 3, data, NOT_MAG_DATA_FACTOR);
-                return true;
-            }
-        }
-        break;
+    /* unknown id, or the length does not match */
+    if (desc_idx == 0 || field_desc[desc_idx - 1].len != len)
+        return YS_FIELD_NONE;
 
-        case ANGLE_ID:
-        {
-            if (ANGLE_DATA_LEN == len)
-            {
-                int_to_float_arr(sensor_data->angle, 3, data, NOT_MAG_DATA_FACTOR);
-                return true;
-            }
-        }
-        break;
+    return (uint8_t)(desc_idx - 1);
+}
 
-        case MAGNETIC_ID:
-        {
-            if (MAGNETIC_DATA_LEN == len)
-            {
-                int_to_float_arr(sensor_data->mag, 3, data, NOT_MAG_DATA_FACTOR);
-                return true;
-            }
-        }
-        break;
+#ifdef YS_HAS_LAYOUT_CACHE
 
-        case RAW_MAGNETIC_ID:
-        {
-            if (MAGNETIC_RAW_DATA_LEN == len)
-            {
-                int_to_float_arr(sensor_data->raw_mag, 3, data, MAG_RAW_DATA_FACTOR);
-                return true;
-            }
-        }
-        break;
+static bool ys_layout_match(const ys_layout_cache *layout, const ys_frame *frame)
+{
+    if (!layout->active || layout->msg_len != frame->len)
+        return false;
 
-        case EULER_ID:
-        {
-            if (EULER_DATA_LEN == len)
-            {
-                int_to_float_arr(sensor_data->euler_angle, 3, data, NOT_MAG_DATA_FACTOR);
-                return true;
-            }
-        }
-        break;
+    for (uint8_t i = 0; i < layout->field_cnt; i++)
+    {
+        uint16_t tag;
 
-        case QUATERNION_ID:
-        {
-            if (QUATERNION_DATA_LEN == len)
-            {
-                int_to_float_arr(sensor_data->quaternion, 4, data, NOT_MAG_DATA_FACTOR);
-                return true;
-            }
-        }
-        break;
+        memcpy(&tag, &frame->msg[layout->offset[i]], sizeof(uint16_t));
 
-        case LOCATION_ID:
-        {
-            if (LOCATION_DATA_LEN == len)
-            {
-                sensor_data->location[LAT] = get_signed_int(data, 0) * LONG_LAT_DATA_FACTOR;
-                sensor_data->location[LON] = get_signed_int(data, INTEGER_LEN) * LONG_LAT_DATA_FACTOR;
-                sensor_data->location[ALT] = get_signed_int(data, INTEGER_LEN * 2) * ALT_DATA_FACTOR;
-                return true;
-            }
-        }
-        break;
+        if (tag != layout->tag[i])
+            return false;
+    }
 
-        case HIGH_PRECI_LOCATION_ID:
-        {
-            if (HIGH_PRECI_LOCATION_DATA_LEN == len)
-            {
-                sensor_data->location[LAT] = get_signed_int64(data, 0) * HIGH_PRECI_LONG_LAT_DATA_FACTOR;
-                sensor_data->location[LON] = get_signed_int64(data, INTEGER_64_LEN * 1) * HIGH_PRECI_LONG_LAT_DATA_FACTOR;
-                sensor_data->location[ALT] = get_signed_int64(data, INTEGER_64_LEN * 2) * ALT_DATA_FACTOR;
-                return true;
-            }
-        }
-        break;
+    return true;
+}
 
-        case SPEED_ID:
-        {
-            if (SPEED_DATA_LEN == len)
-            {
-                int_to_float_arr(sensor_data->velocity, 3, data, SPEED_DATA_FACTOR);
-                return true;
-            }
-        }
-        break;
+static void ys_layout_decode(ys_parser_t *parser, ys_frame *frame, ys_result_callback_params_t *cb_params)
+{
+    const ys_layout_cache *layout = &parser->layout;
 
-        case SAMPLE_TIMESTAMP_ID:
-        {
-            if (SAMPLE_TIMESTAMP_DATA_LEN == len)
-            {
-                sensor_data->sample_timestamp = *((uint32_t *)data);
-                return true;
-            }
-        }
-        break;
+    for (uint8_t i = 0; i < layout->field_cnt; i++)
+    {
+        field_desc[layout->desc[i]].decode(parser, &frame->msg[layout->offset[i] + sizeof(ys_packet_info_t)]);
+    }
 
-        case DATA_READY_TIMESTAMP_ID:
-        {
-            if (DATA_READY_TIMESTAMP_DATA_LEN == len)
-            {
-                sensor_data->data_ready_timestamp = *((uint32_t *)data);
-                return true;
-            }
-        }
-        break;
+    memcpy(cb_params->field_li, layout->id, layout->id_cnt);
+    cb_params->field_cnt = layout->id_cnt;
 
-        default: // no such id
-            return false;
+    parser->trace_inf.layout_hit_cnt++;
+}
+
+static void ys_layout_learn(ys_parser_t *parser, const ys_layout_cache *layout)
+{
+    ys_layout_cache *cache = &parser->layout;
+
+    /* we are here because the cached layout did not match */
+    if (cache->active)
+    {
+        parser->trace_inf.layout_miss_cnt++;
+        cache->active = 0;
+    }
+
+    if (layout == NULL)
+    {
+        cache->match_cnt = 0;
+        return;
     }
 
-    return false;
+    if (cache->match_cnt > 0 &&
+        cache->msg_len == layout->msg_len &&
+        cache->field_cnt == layout->field_cnt &&
+        cache->id_cnt == layout->id_cnt &&
+        memcmp(cache->offset, layout->offset, layout->field_cnt) == 0 &&
+        memcmp(cache->tag, layout->tag, layout->field_cnt * sizeof(uint16_t)) == 0)
+    {
+        if (++cache->match_cnt >= YS_LAYOUT_LEARN_CNT)
+            cache->active = 1;
+    }
+    else
+    {
+        *cache           = *layout;
+        cache->match_cnt = 1;
+        cache->active    = 0;
+    }
 }
 
+#endif // YS_HAS_LAYOUT_CACHE
+
 //-------------------------- internal func ----------------------------------
 
-static int32_t get_signed_int(uint8_t *buf, uint16_t offset)
+static int32_t get_signed_int(const uint8_t *buf, uint16_t offset)
 {
-    int32_t temp = 0;
+    uint32_t temp = 0;
 
     for (int8_t i = 3; i >= 0; i--)
     {
@@ -534,12 +881,12 @@ static int32_t get_signed_int(uint8_t *buf, uint16_t offset)
         temp |= buf[offset + i];
     }
 
-    return temp;
+    return (int32_t)temp;
 }
 
-static int64_t get_signed_int64(uint8_t *buf, uint16_t offset)
+static int64_t get_signed_int64(const uint8_t *buf, uint16_t offset)
 {
-    int64_t temp = 0;
+    uint64_t temp = 0;
 
     for (int8_t i = 7; i >= 0; i--)
     {
@@ -547,10 +894,10 @@ static int64_t get_signed_int64(uint8_t *buf, uint16_t offset)
         temp |= buf[offset + i];
     }
 
-    return temp;
+    return (int64_t)temp;
 }
 
-static void int_to_float_arr(float *dst, uint16_t dst_size, uint8_t *src, float ratio)
+static void int_to_float_arr(float *dst, uint16_t dst_size, const uint8_t *src, float ratio)
 {
     for (uint16_t i = 0; i < dst_size; i++)
     {
@@ -558,10 +905,161 @@ static void int_to_float_arr(float *dst, uint16_t dst_size, uint8_t *src, float
     }
 }
 
+static int16_t get_signed_int16(const uint8_t *buf, uint16_t offset)
+{
+    return (int16_t)((uint16_t)buf[offset] | ((uint16_t)buf[offset + 1] << 8));
+}
+
+static uint32_t get_unsigned_int(const uint8_t *buf, uint16_t offset)
+{
+    return (uint32_t)buf[offset] |
+           ((uint32_t)buf[offset + 1] << 8) |
+           ((uint32_t)buf[offset + 2] << 16) |
+           ((uint32_t)buf[offset + 3] << 24);
+}
+
+static void decode_imu_temp(ys_parser_t *parser, const uint8_t *data)
+{
+    parser->sensor_data.imu_temp = (float)get_signed_int16(data, 0) * IMU_TEMP_FACTOR;
+
+#ifdef YS_HAS_CALIB
+    /* kept across frames, for the temperature compensation of the calibration */
+    parser->calib_temp       = parser->sensor_data.imu_temp;
+    parser->calib_temp_valid = true;
+#endif
+}
+
+static void decode_speed_inc(ys_parser_t *parser, const uint8_t *data)
+{
+    int_to_float_arr(parser->sensor_data.speed_inc, 3, data, NOT_MAG_DATA_FACTOR);
+}
+
+/* the second imu fields are only looked up when parser->dual_imu is set */
+
+static void decode_second_imu_temp(ys_parser_t *parser, const uint8_t *data)
+{
+    parser->dual_imu->second_imu_temp = (float)get_signed_int16(data, 0) * IMU_TEMP_FACTOR;
+}
+
+static void decode_second_accel(ys_parser_t *parser, const uint8_t *data)
+{
+    int_to_float_arr(parser->dual_imu->second_accel, 3, data, NOT_MAG_DATA_FACTOR);
+}
+
+static void decode_second_angle(ys_parser_t *parser, const uint8_t *data)
+{
+    int_to_float_arr(parser->dual_imu->second_angle, 3, data, NOT_MAG_DATA_FACTOR);
+}
+
+static void decode_quat_inc(ys_parser_t *parser, const uint8_t *data)
+{
+    int_to_float_arr(parser->sensor_data.quaternion_inc, 4, data, NOT_MAG_DATA_FACTOR);
+}
+
+static void decode_accel(ys_parser_t *parser, const uint8_t *data)
+{
+#ifdef YS_HAS_CALIB
+    if (calib_decode(parser, YS_CALIB_ACCEL, parser->sensor_data.accel, data))
+        return;
+#endif
+    int_to_float_arr(parser->sensor_data.accel, 3, data, NOT_MAG_DATA_FACTOR);
+}
+
+static void decode_angle(ys_parser_t *parser, const uint8_t *data)
+{
+#ifdef YS_HAS_CALIB
+    if (calib_decode(parser, YS_CALIB_ANGLE, parser->sensor_data.angle, data))
+        return;
+#endif
+    int_to_float_arr(parser->sensor_data.angle, 3, data, NOT_MAG_DATA_FACTOR);
+}
+
+static void decode_mag(ys_parser_t *parser, const uint8_t *data)
+{
+    int_to_float_arr(parser->sensor_data.mag, 3, data, NOT_MAG_DATA_FACTOR);
+}
+
+static void decode_raw_mag(ys_parser_t *parser, const uint8_t *data)
+{
+#ifdef YS_HAS_CALIB
+    if (calib_decode(parser, YS_CALIB_RAW_MAG, parser->sensor_data.raw_mag, data))
+        return;
+#endif
+    int_to_float_arr(parser->sensor_data.raw_mag, 3, data, MAG_RAW_DATA_FACTOR);
+}
+
+#ifdef YS_HAS_CALIB
+
+/* int32 -> calibrated value in one step, see ys_calib_apply */
+static bool calib_decode(ys_parser_t *parser, ys_calib_sensor_t sensor, float *dst, const uint8_t *data)
+{
+    const ys_calib_profile_t *profile = parser->calib_active;
+    int32_t raw[3];
+
+    if (profile == NULL || (profile->sensor_mask & (1u << sensor)) == 0)
+        return false;
+
+    raw[X] = get_signed_int(data, 0);
+    raw[Y] = get_signed_int(data, INTEGER_LEN);
+    raw[Z] = get_signed_int(data, INTEGER_LEN * 2);
+
+    ys_calib_apply(&profile->sensor[sensor], raw,
+                   parser->calib_temp_valid ? parser->calib_temp - profile->ref_temp : 0.0f, dst);
+
+    return true;
+}
+
+#endif
+
+static void decode_euler(ys_parser_t *parser, const uint8_t *data)
+{
+    int_to_float_arr(parser->sensor_data.euler_angle, 3, data, NOT_MAG_DATA_FACTOR);
+}
+
+static void decode_quat(ys_parser_t *parser, const uint8_t *data)
+{
+    int_to_float_arr(parser->sensor_data.quaternion, 4, data, NOT_MAG_DATA_FACTOR);
+}
+
+static void decode_location(ys_parser_t *parser, const uint8_t *data)
+{
+    parser->sensor_data.location[LAT] = get_signed_int(data, 0) * LONG_LAT_DATA_FACTOR;
+    parser->sensor_data.location[LON] = get_signed_int(data, INTEGER_LEN) * LONG_LAT_DATA_FACTOR;
+    parser->sensor_data.location[ALT] = get_signed_int(data, INTEGER_LEN * 2) * ALT_DATA_FACTOR;
+}
+
+static void decode_high_preci_location(ys_parser_t *parser, const uint8_t *data)
+{
+    parser->sensor_data.location[LAT] = get_signed_int64(data, 0) * HIGH_PRECI_LONG_LAT_DATA_FACTOR;
+    parser->sensor_data.location[LON] = get_signed_int64(data, INTEGER_64_LEN * 1) * HIGH_PRECI_LONG_LAT_DATA_FACTOR;
+    parser->sensor_data.location[ALT] = get_signed_int64(data, INTEGER_64_LEN * 2) * ALT_DATA_FACTOR;
+}
+
+static void decode_speed(ys_parser_t *parser, const uint8_t *data)
+{
+    int_to_float_arr(parser->sensor_data.velocity, 3, data, SPEED_DATA_FACTOR);
+}
+
+static void decode_sample_timestamp(ys_parser_t *parser, const uint8_t *data)
+{
+    parser->sensor_data.sample_timestamp = get_unsigned_int(data, 0);
+}
+
+static void decode_data_ready_timestamp(ys_parser_t *parser, const uint8_t *data)
+{
+    parser->sensor_data.data_ready_timestamp = get_unsigned_int(data, 0);
+}
+
+static void decode_skip(ys_parser_t *parser, const uint8_t *data)
+{
+    (void)parser;
+    (void)data;
+}
+
 static void ys_buffer_push(ys_parser_t *parser, uint8_t dat)
 {
     parser->data_buf.buffer[parser->data_buf.count++] = dat;
-    ys_assert(parser->data_buf.count < YS_BUFFER_SIZE);
+    ys_assert(parser->data_buf.count < YS_FRAME_BUF_SIZE);
 }
 
 static void ys_calcu_checksum(uint8_t *crc, uint8_t byte)
@@ -572,20 +1070,293 @@ static void ys_calcu_checksum(uint8_t *crc, uint8_t byte)
 
 static void ys_buffer_reset(ys_parser_t *parser)
 {
-    parser->data_buf.count = 0;
+    parser->data_buf.count   = 0;
+    parser->data_buf.start   = 0;
+    parser->data_buf.sum_len = 0;
 }
 
-static int32_t find_ys_header(uint8_t *buf, uint32_t len)
+#ifdef YS_HAS_DEFER_PARSE
+
+static bool ys_defer_push(ys_parser_t *parser, ys_frame *frame)
 {
-    for (uint32_t i = 0; i < len; i++)
+    ys_defer_queue *queue = &parser->defer_queue;
+    uint8_t head          = queue->head; /* only written here */
+    uint8_t next          = (uint8_t)((head + 1) % (YS_DEFER_QUEUE_SIZE + 1));
+
+    /* acquire: the consumer is done with the slot it released */
+    if (next == ys_load_acquire(&queue->tail))
+        return false; /* full */
+
+    queue->frames[head].tid = frame->tid;
+    queue->frames[head].len = (uint8_t)frame->len;
+    memcpy(queue->frames[head].msg, frame->msg, frame->len);
+
+    /* release: the slot content is visible before the new head */
+    ys_store_release(&queue->head, next);
+
+    return true;
+}
+
+#endif // YS_HAS_DEFER_PARSE
+
+static uint32_t ys_parser_feed_msg(ys_parser_t *parser, const uint8_t *data, uint32_t len)
+{
+    uint32_t n    = (uint32_t)parser->msg_remain_len < len ? (uint32_t)parser->msg_remain_len : len;
+    uint8_t *dst  = &parser->data_buf.buffer[parser->data_buf.count];
+    uint8_t crc_0 = parser->cur_frame.crc[0];
+    uint8_t crc_1 = parser->cur_frame.crc[1];
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        dst[i] = data[i];
+        crc_0 += data[i];
+        crc_1 += crc_0;
+    }
+
+    parser->cur_frame.crc[0] = crc_0;
+    parser->cur_frame.crc[1] = crc_1;
+    parser->data_buf.count += (uint16_t)n;
+    parser->msg_remain_len -= (int16_t)n;
+    parser->trace_inf.status = YS_STATUS_RUNNING;
+
+    // msg end, go next action
+    if (parser->msg_remain_len <= 0)
+        ys_action_go_next(parser);
+
+    return n;
+}
+
+static void ys_seq_update(ys_link_stat_t *link, uint16_t tid)
+{
+    uint16_t delta = (uint16_t)(tid - link->last_tid); /* handles 16 bit wrap */
+
+    if (!link->has_tid)
+    {
+        link->has_tid = 1;
+        delta         = 1;
+    }
+
+    /* in order, or a forward jump: frames in between are lost */
+    if (delta > 0 && delta <= YS_SEQ_MAX_DROPOUT)
+    {
+        if (delta > 1)
+        {
+            link->gap_cnt++;
+            link->lost_frame_cnt += delta - 1u;
+            link->win_lost += delta - 1u;
+        }
+
+        link->last_tid = tid;
+        link->win_expect += delta;
+
+        if (link->win_expect >= YS_SEQ_WINDOW)
+        {
+            link->loss_permille = (uint16_t)((uint32_t)link->win_lost * 1000 / link->win_expect);
+            link->win_expect    = 0;
+            link->win_lost      = 0;
+        }
+    }
+
+    else if (delta == 0)
+    {
+        link->dup_cnt++;
+    }
+
+    /* a little behind: a late frame which was counted as lost */
+    else if ((uint16_t)-delta <= YS_SEQ_MAX_MISORDER)
+    {
+        link->reorder_cnt++;
+
+        if (link->lost_frame_cnt > 0)
+            link->lost_frame_cnt--;
+        if (link->win_lost > 0)
+            link->win_lost--;
+    }
+
+    /* far away: device restarted or tid was reset */
+    else
+    {
+        link->restart_cnt++;
+        link->last_tid = tid;
+    }
+}
+
+static uint16_t ys_parser_resync(ys_parser_t *parser, uint8_t byte, bool defer)
+{
+    ys_buffer *buf     = &parser->data_buf;
+    uint16_t broken    = buf->start;
+    uint16_t pos       = (uint16_t)(broken + 1); /* skip the 'Y' of the broken frame */
+    uint16_t frame_cnt = 0;
+    uint16_t err_cnt   = parser->trace_inf.err_frame_cnt;
+    int16_t status     = parser->trace_inf.status;
+
+    buf->buffer[buf->count++] = byte; /* the byte which broke the frame */
+
+    ys_resync_sum(buf);
+
+    /*
+     * the candidates are checked in order without touching the parser. a verified frame is
+     * finished in place, the first candidate cut off by the end of the buffer becomes the
+     * current frame, and the candidates behind it are checked when it breaks in turn.
+     * the prefix sums are kept along with the bytes, so every byte is rescanned once
+     * and summed at most twice (again after being moved to the front)
+     */
+    while (pos < buf->count)
+    {
+        const uint8_t *head = memchr(&buf->buffer[pos], YS_HEADER_1, buf->count - pos);
+
+        if (head == NULL)
+            break;
+
+        uint16_t start = (uint16_t)(head - buf->buffer);
+        int16_t res    = ys_resync_check(buf->buffer, buf->sum, buf->wsum, start, buf->count);
+
+        parser->trace_inf.resync_cnt++;
+        ys_probe3(resync, parser, start - broken, buf->count - broken);
+
+        if (res > 0)
+        {
+            /* the last byte runs the checksum and the decoder like any other frame */
+            ys_resync_keep(parser, start, (uint16_t)(start + res - 1));
+
+            if (ys_parser_step(parser, buf->buffer[start + res - 1], defer) == YS_STATUS_DONE)
+                frame_cnt++;
+
+            pos = (uint16_t)(start + res);
+        }
+        else if (res == 0)
+        {
+            /* leave room for the rest of the frame, at most once per YS_FRAME_BUF_SIZE - YS_FRAME_MAX_LEN bytes */
+            if (start + YS_FRAME_MAX_LEN > YS_FRAME_BUF_SIZE)
+            {
+                buf->count = (uint16_t)(buf->count - start);
+                memmove(buf->buffer, &buf->buffer[start], buf->count);
+                buf->sum_len = 0;
+                ys_resync_sum(buf);
+                start = 0;
+            }
+
+            /* the following bytes complete or break it */
+            ys_resync_keep(parser, start, buf->count);
+            break;
+        }
+        else
+        {
+            pos = (uint16_t)(start + 1);
+        }
+    }
+
+    /* failed candidates inside the broken frame are not frame errors of their own */
+    parser->trace_inf.err_frame_cnt = err_cnt;
+    parser->trace_inf.status        = status;
+
+    return frame_cnt;
+}
+
+/* extend the prefix sums (mod 256) to the end of the buffer, they give the checksum of any candidate in O(1) */
+static void ys_resync_sum(ys_buffer *buf)
+{
+    /* sum[k] = buffer[0] + ... + buffer[k - 1], wsum[k] = 0 * buffer[0] + ... + (k - 1) * buffer[k - 1] */
+    for (uint16_t i = buf->sum_len; i < buf->count; i++)
+    {
+        buf->sum[i + 1]  = (uint8_t)(buf->sum[i] + buf->buffer[i]);
+        buf->wsum[i + 1] = (uint8_t)(buf->wsum[i] + (uint8_t)(i * buf->buffer[i]));
+    }
+
+    buf->sum_len = buf->count;
+}
+
+/* continue the candidate at 'start' as if its bytes up to 'end' had been stepped through the parser */
+static void ys_resync_keep(ys_parser_t *parser, uint16_t start, uint16_t end)
+{
+    ys_buffer *buf   = &parser->data_buf;
+    const uint8_t *b = &buf->buffer[start];
+    uint16_t got     = (uint16_t)(end - start);
+    uint16_t crc_end = end;
+
+    parser->cur_frame.tid  = 0;
+    parser->cur_frame.len  = 0;
+    parser->msg_remain_len = 0;
+
+    if (got > 2)
+        parser->cur_frame.tid = b[2];
+    if (got > 3)
+        parser->cur_frame.tid |= ((uint16_t)b[3] << 8);
+
+    if (got < 5)
+    {
+        parser->cur_action = (ys_parser_action)(ON_PARSE_HEADDER_1 + got);
+    }
+    else
     {
-        if (buf[i + 0] == 'Y' &&
-            buf[i + 1] == 'S' &&
-            ys_check_msg_len(buf[i + 4]))
+        uint16_t msg_end = (uint16_t)(start + 5 + b[4]);
+
+        parser->cur_frame.len = b[4];
+        parser->cur_frame.msg = &buf->buffer[start + 5];
+
+        if (end < msg_end)
         {
-            return i;
+            parser->cur_action     = ON_PARSE_MESSAGE;
+            parser->msg_remain_len = (int16_t)(msg_end - end);
         }
+        else
+        {
+            /* the first checksum byte is in the buffer when it is already verified */
+            parser->cur_action = end == msg_end ? ON_PARSE_CK1 : ON_PARSE_CK2;
+            crc_end            = msg_end;
+        }
+    }
+
+    /* checksum over tid, len and message received so far, see ys_resync_check */
+    if (got > 2)
+    {
+        uint16_t begin = (uint16_t)(start + 2);
+
+        parser->cur_frame.crc[0] = (uint8_t)(buf->sum[crc_end] - buf->sum[begin]);
+        parser->cur_frame.crc[1] = (uint8_t)((uint8_t)(crc_end * parser->cur_frame.crc[0]) - (uint8_t)(buf->wsum[crc_end] - buf->wsum[begin]));
+    }
+    else
+    {
+        parser->cur_frame.crc[0] = 0;
+        parser->cur_frame.crc[1] = 0;
     }
 
-    return -1;
+    buf->start = start;
+
+    if (got > 1)
+        ys_probe1(frame_start, parser);
+}
+
+/* length of the verified frame at 'start', 0 if it may be a frame cut off by the end of the replay, -1 if not a frame */
+static int16_t ys_resync_check(const uint8_t *replay, const uint8_t *sum, const uint8_t *wsum, uint16_t start, uint16_t len)
+{
+    if (start + 1 < len && replay[start + 1] != YS_HEADER_2)
+        return -1;
+
+    if (start + 4 >= len)
+        return 0;
+
+    if (!ys_check_msg_len(replay[start + 4]))
+        return -1;
+
+    /* checksum over tid, len and message: [begin, end) */
+    uint16_t begin = (uint16_t)(start + 2);
+    uint16_t end   = (uint16_t)(start + 5 + replay[start + 4]);
+
+    if (end >= len)
+        return 0;
+
+    uint8_t crc0 = (uint8_t)(sum[end] - sum[begin]);
+    uint8_t crc1 = (uint8_t)((uint8_t)(end * crc0) - (uint8_t)(wsum[end] - wsum[begin]));
+
+    if (replay[end] != crc0)
+        return -1;
+
+    if (end + 1 >= len)
+        return 0;
+
+    if (replay[end + 1] != crc1)
+        return -1;
+
+    return (int16_t)(end + 2 - start);
 }
@@ -9,8 +9,14 @@
 #ifndef H_YS_PARSER
 #define H_YS_PARSER
 
+#include <stdint.h>
+#include <stddef.h>
 #include "ys_def.h"
 
+#ifdef YS_HAS_CALIB
+#include "ys_calib.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -21,10 +27,19 @@ extern "C" {
 
 #define YS_BUFFER_SIZE 264
 
+#define YS_MSG_MAX_LEN 200
+
+/* the current frame and the rescanned bytes of the broken frames before it, see ys_parser_resync */
+#define YS_FRAME_BUF_SIZE (2 * YS_BUFFER_SIZE)
+
 typedef struct
 {
-    uint8_t buffer[YS_BUFFER_SIZE];
+    uint8_t buffer[YS_FRAME_BUF_SIZE];
+    uint8_t sum[YS_FRAME_BUF_SIZE + 1];  /* prefix sums of buffer for the checksum of rescanned candidates */
+    uint8_t wsum[YS_FRAME_BUF_SIZE + 1]; /* index weighted prefix sums */
     uint16_t count;
+    uint16_t start;   /* the current frame starts here */
+    uint16_t sum_len; /* bytes covered by the prefix sums */
 } ys_buffer;
 
 typedef enum
@@ -47,6 +62,42 @@ typedef struct
 	uint8_t crc[2];
 } ys_frame;
 
+#ifdef YS_HAS_DEFER_PARSE
+
+typedef struct
+{
+    uint16_t tid;
+    uint8_t len;
+    uint8_t msg[YS_MSG_MAX_LEN];
+} ys_pending_frame;
+
+typedef struct
+{
+    ys_pending_frame frames[YS_DEFER_QUEUE_SIZE + 1]; /* one slot always kept empty */
+    volatile uint8_t head; /* only written by input side (isr), published by ys_store_release */
+    volatile uint8_t tail; /* only written by ys_parser_poll, published by ys_store_release */
+} ys_defer_queue;
+
+#endif // YS_HAS_DEFER_PARSE
+
+#ifdef YS_HAS_LAYOUT_CACHE
+
+/* learned message layout, the fields of a cached frame are decoded at fixed offsets */
+typedef struct
+{
+    uint8_t msg_len;                      /* message length of the layout */
+    uint8_t field_cnt;
+    uint8_t id_cnt;                       /* decoded fields, skipped ones excluded */
+    uint8_t match_cnt;                    /* identical frames seen in a row */
+    uint8_t active;                       /* layout confirmed, fast path enabled */
+    uint8_t offset[YS_LAYOUT_MAX_FIELDS]; /* offset of the field header in message */
+    uint8_t desc[YS_LAYOUT_MAX_FIELDS];   /* decoder of the field */
+    uint8_t id[YS_LAYOUT_MAX_FIELDS];     /* decoded field id list */
+    uint16_t tag[YS_LAYOUT_MAX_FIELDS];   /* raw field header (id, len) */
+} ys_layout_cache;
+
+#endif // YS_HAS_LAYOUT_CACHE
+
 //////////////////////////////////////////////////////
 //                  Type Define
 //////////////////////////////////////////////////////
@@ -78,7 +129,11 @@ typedef struct
 {
     uint16_t tid;
     ys_sensor_data_t *result;
+    ys_dual_imu_data_t *dual_imu; /* second imu data, NULL for single imu parsers */
     void *user_data;
+#ifdef YS_HAS_CALIB
+    const ys_calib_profile_t *calib; /* calibration applied to this frame, NULL if none */
+#endif
     /* sensor data valid id list, refer 'ys_data_id_t' */
     uint8_t field_li[64];
     uint8_t field_cnt;
@@ -86,6 +141,15 @@ typedef struct
 
 typedef void(*ys_result_callback_t)(ys_result_callback_params_t *params);
 
+/* result of ys_parse_buf_ex */
+typedef struct
+{
+    size_t consumed;         /* bytes consumed from buffer */
+    uint32_t frame_cnt;      /* frames done in this call */
+    uint16_t pending;        /* bytes of the partial frame kept in parser */
+    ys_parser_action action; /* current parser action */
+} ys_parse_result_t;
+
 typedef enum
 {
     YS_STATUS_CHK_ERR = -1,
@@ -95,12 +159,54 @@ typedef enum
     YS_STATUS_DONE = 1,
 } ys_parser_status_t;
 
+/* link state flags, see ys_parser_update_link */
+typedef enum
+{
+    YS_LINK_SATURATED = 1 << 0, /* link load above YS_LINK_SATURATION_PERMILLE */
+    YS_LINK_LOSS      = 1 << 1, /* tid gaps in this period */
+    YS_LINK_ERROR     = 1 << 2, /* broken frames in this period */
+    YS_LINK_OVERRUN   = 1 << 3, /* saturated and losing data, likely uart / usb overrun */
+} ys_link_flag_t;
+
+/* tid sequence and link statistics */
+typedef struct
+{
+    uint16_t last_tid;       /* highest tid received */
+    uint8_t has_tid;
+    uint8_t flags;           /* see ys_link_flag_t */
+    uint32_t gap_cnt;        /* tid jumped forward */
+    uint32_t lost_frame_cnt; /* frames missing in the gaps */
+    uint32_t dup_cnt;        /* same tid received twice */
+    uint32_t reorder_cnt;    /* late frames, tid behind the highest one */
+    uint32_t restart_cnt;    /* tid jumped too far, sequence restarted */
+    uint16_t win_expect;     /* frames expected in current window */
+    uint16_t win_lost;       /* frames lost in current window */
+    uint16_t loss_permille;  /* loss rate of the last full window */
+    uint16_t err_permille;   /* broken frame rate of the last period */
+    uint16_t load_permille;  /* link load of the last period */
+    uint32_t rx_bytes;       /* bytes fed into the parser */
+    /* counters at the start of current period */
+    uint32_t last_rx_bytes;
+    uint32_t last_lost_cnt;
+    uint16_t last_done_cnt;
+    uint16_t last_err_cnt;
+} ys_link_stat_t;
+
 /* trace info */
 typedef struct
 {
     int16_t status;          /* current parser status */
     uint16_t err_frame_cnt;  /* crc error cnt */
     uint16_t done_frame_cnt; /* valid frame cnt */
+    uint32_t resync_cnt;     /* candidate headers rescanned after a broken frame */
+#ifdef YS_HAS_DEFER_PARSE
+    uint16_t drop_frame_cnt; /* frames dropped because defer queue is full */
+#endif
+#ifdef YS_HAS_LAYOUT_CACHE
+    uint32_t layout_hit_cnt;  /* frames decoded by the learned layout */
+    uint16_t layout_miss_cnt; /* learned layout changed */
+#endif
+    ys_link_stat_t link;     /* tid sequence and link load */
 } ys_trace_info_t;
 
 typedef struct
@@ -111,8 +217,21 @@ typedef struct
     int16_t msg_remain_len;
     ys_result_callback_t callbk;  /* data ready callbk */
     ys_sensor_data_t sensor_data; /* sensor data */
+    ys_dual_imu_data_t *dual_imu; /* second imu data, see ys_parser_enable_dual_imu */
     ys_trace_info_t trace_inf;    /* trace info */
     void *user_data;              /* user data */
+#ifdef YS_HAS_DEFER_PARSE
+    ys_defer_queue defer_queue;   /* frames waiting for ys_parser_poll */
+#endif
+#ifdef YS_HAS_LAYOUT_CACHE
+    ys_layout_cache layout;       /* learned message layout */
+#endif
+#ifdef YS_HAS_CALIB
+    const ys_calib_profile_t *volatile calib; /* bound profile, published by ys_store_release, see ys_parser_set_calib */
+    const ys_calib_profile_t *calib_active;   /* profile taken at the start of the current frame */
+    float calib_temp;                         /* last imu temp */
+    uint8_t calib_temp_valid;
+#endif
 } ys_parser_t;
 
 //////////////////////////////////////////////////////
@@ -158,6 +277,38 @@ void ys_parser_set_user_data(ys_parser_t *parser, void *user_data);
  */
 void *ys_parser_get_user_data(ys_parser_t *parser);
 
+/**
+ * 为解析器启用或关闭第二颗 IMU 数据的解析。
+ * 
+ * 第二颗 IMU 的数据保存在调用者提供的内存中，并通过回调参数中的 dual_imu 传出；
+ * 未启用时，报文中的第二颗 IMU 字段按长度跳过，不出现在 field_li 中。
+ * 同一进程中的单 IMU 与双 IMU 设备可使用不同的解析器实例。
+ * 
+ * @param parser YS 解析器对象
+ * 
+ * @param dual_imu 第二颗 IMU 数据存储位置，为 NULL 表示关闭
+ */
+void ys_parser_enable_dual_imu(ys_parser_t *parser, ys_dual_imu_data_t *dual_imu);
+
+#ifdef YS_HAS_CALIB
+/**
+ * 为解析器绑定标定配置，之后解码的 accel、angle、raw_mag 为标定后的结果。
+ * 
+ * 可在解析过程中从其他线程或中断中调用：配置指针以 ys_store_release 发布，解析器在每帧开始时以
+ * ys_load_acquire 取用一次，调用前写入的配置内容对取到它的帧一定可见，同一帧内的字段始终使用同一份配置。
+ *
+ * 宽限期：本函数返回时，正在解码的一帧可能仍在使用旧配置。满足以下任一条件后旧配置才可以释放或改写：
+ *   - 收到一帧回调参数中的 calib 指向新配置（解析器按帧顺序解码，此前的帧均已完成）；
+ *   - 解析线程从一次在本函数返回之后才开始的 ys_parse_buf / ys_parse_buf_ex / ys_parser_poll 调用中返回
+ *     （未启用延迟解析时也包括 ys_parser_input）。
+ * 
+ * @param parser YS 解析器对象
+ * 
+ * @param profile 标定配置，为 NULL 表示关闭标定
+ */
+void ys_parser_set_calib(ys_parser_t *parser, const ys_calib_profile_t *profile);
+#endif
+
 /**
  * 向解析器输入一个字节的报文数据。
  * 
@@ -176,7 +327,7 @@ ys_parser_status_t ys_parser_input(ys_parser_t *parser, uint8_t byte);
 /**
  * 使用解析器解析一个缓冲区内的所有内容。
  * 
- * 该函数会调用 @ref ys_parser_input 在整个缓冲区中搜索并解析报文 
+ * 该函数会在整个缓冲区中搜索并解析报文，未完成的半帧保留在解析器中，可在下一次调用时继续解析
  * 
  * @param parser YS 解析器对象
  * 
@@ -186,6 +337,107 @@ ys_parser_status_t ys_parser_input(ys_parser_t *parser, uint8_t byte);
 */
 void ys_parse_buf(ys_parser_t *parser, uint8_t *buffer, uint32_t len);
 
+/**
+ * 使用解析器解析一个缓冲区，可中途停止并从返回的偏移处继续。
+ * 
+ * 适用于大于 64 KiB 的缓冲区（例如 mmap 映射的录制文件）。
+ * 校验失败时，解析器会在已缓存的字节中按顺序重新搜索报文头，不会丢失坏帧之后的有效帧，
+ * 结果与逐个字节位置尝试解析相同；每个字节最多被重新搜索一次，总工作量与输入长度成线性关系。
+ * 
+ * @param parser YS 解析器对象
+ * 
+ * @param buffer 缓冲区
+ * 
+ * @param len 缓冲区大小
+ * 
+ * @param max_frames 解析出该数量的帧后返回，为 0 表示处理整个缓冲区。
+ *                   一次重新搜索可能恢复多帧，这些帧都会计入，因此返回时帧数可能略多于 max_frames
+ * 
+ * @param result 解析结果（可为 NULL），包含已处理字节数、帧数以及未完成半帧的状态
+ * 
+ * @return 已处理的字节数
+*/
+size_t ys_parse_buf_ex(ys_parser_t *parser, const uint8_t *buffer, size_t len, uint32_t max_frames, ys_parse_result_t *result);
+
+/**
+ * 计算 YS 报文校验和。
+ * 
+ * 校验范围为 TID、LEN 与 message 字段，即报文头 'YS' 之后、校验和之前的所有字节。
+ * 
+ * @param buf 数据
+ * 
+ * @param len 数据长度
+ * 
+ * @param crc 输出校验和 CK1, CK2
+*/
+void ys_checksum(const uint8_t *buf, uint32_t len, uint8_t crc[2]);
+
+/**
+ * 获取数据 ID 对应的数据长度。
+ * 
+ * @param id 数据 ID，见 @ref ys_data_id_t
+ * 
+ * @return 数据长度（不含 id 与 len 两个字节），未知 ID 返回 0
+*/
+uint8_t ys_data_id_len(uint8_t id);
+
+/**
+ * 更新链路统计，应以固定周期调用（例如每秒一次）。
+ * 
+ * 根据本周期内输入的字节数计算链路占用率，并结合本周期内的丢帧与错误帧判断链路状态：
+ * 占用率接近上限且同时出现丢帧或错误帧，通常说明串口溢出或 USB 集线器带宽不足。
+ * 
+ * 丢帧、重复、乱序等计数在每帧解析时更新，见 trace_inf.link。
+ * 
+ * @param parser YS 解析器对象
+ * 
+ * @param baud 串口波特率
+ * 
+ * @param elapsed_ms 距上次调用经过的时间，单位：ms
+ * 
+ * @return 链路状态，见 @ref ys_link_flag_t
+*/
+uint8_t ys_parser_update_link(ys_parser_t *parser, uint32_t baud, uint32_t elapsed_ms);
+
+#ifdef YS_HAS_DEFER_PARSE
+
+/**
+ * 以有限工作量向解析器输入一段数据（适用于中断 / DMA 半满、全满回调中调用）。
+ * 
+ * 该函数只做帧头搜索、长度检查与校验和计算，校验通过的帧将被放入延迟队列，
+ * TLV 解码与回调函数推迟到 @ref ys_parser_poll 中执行。
+ * 
+ * 单次调用最多处理 budget 个字节，外加最多 YS_DEFER_QUEUE_SIZE 次报文拷贝（每次不超过 YS_MSG_MAX_LEN 字节），
+ * 以及坏帧的重新搜索（工作量与 budget + YS_FRAME_BUF_SIZE 成线性关系），因此中断内的最坏执行时间是有界的。
+ * 若延迟队列已满，新帧将被丢弃并计入 trace_inf.drop_frame_cnt。
+ * 
+ * @param parser YS 解析器对象
+ * 
+ * @param chunk 数据块
+ * 
+ * @param len 数据块大小
+ * 
+ * @param budget 本次调用最多处理的字节数，为 0 表示不限制
+ * 
+ * @return 实际处理的字节数，剩余数据应在下一次调用时继续输入
+*/
+uint32_t ys_parser_input_chunk(ys_parser_t *parser, const uint8_t *chunk, uint32_t len, uint32_t budget);
+
+/**
+ * 处理延迟队列中的帧：解码 TLV 并调用回调函数。
+ * 
+ * 应在主循环或低优先级任务中调用，不可与 @ref ys_parser_input_chunk 在同一中断上下文中重入。
+ * 
+ * @param parser YS 解析器对象
+ * 
+ * @param max_frames 本次最多处理的帧数，为 0 表示处理全部
+ * 
+ * @return 本次处理的帧数
+*/
+uint8_t ys_parser_poll(ys_parser_t *parser, uint8_t max_frames);
+
+#endif // YS_HAS_DEFER_PARSE
+
 #ifdef __cplusplus
 }
 #endif
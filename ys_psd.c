@@ -0,0 +1,391 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <ys_psd.h>
+
+#define PSD_PI 3.14159265358979323846
+
+#define PSD_ALIGN 32
+
+#define psd_align(_size) (((_size) + PSD_ALIGN - 1) & ~(size_t)(PSD_ALIGN - 1))
+
+//-------------------------- internal func ----------------------------------
+
+static size_t psd_layout(ys_psd_bank_t *bank, uint8_t *block);
+
+static void psd_init_tables(ys_psd_bank_t *bank);
+
+static uint16_t psd_freq_bin(float pos, uint32_t bin_cnt);
+
+static void psd_segment(ys_psd_bank_t *bank, const float *ring, float *psd, uint64_t start);
+
+static void psd_fft(ys_psd_bank_t *bank);
+
+static void psd_butterfly(float *ys_restrict ar, float *ys_restrict ai, float *ys_restrict br, float *ys_restrict bi,
+                          const float *ys_restrict wr, const float *ys_restrict wi, uint32_t h);
+
+static void psd_report(ys_psd_bank_t *bank, uint16_t index);
+
+//---------------------------------------------------------------------------
+
+ys_psd_bank_t *ys_psd_create(const ys_psd_config_t *config, uint16_t sensor_cnt)
+{
+    ys_psd_bank_t layout;
+    ys_psd_bank_t *bank;
+    uint32_t n = config->fft_size;
+
+    if (n < 16 || n > YS_PSD_MAX_FFT || (n & (n - 1)) != 0 ||
+        config->avg_cnt == 0 || config->rate <= 0.0f ||
+        config->band_cnt > YS_PSD_MAX_BANDS || sensor_cnt == 0)
+    {
+        return NULL;
+    }
+
+    /* one block: bank, shared tables, then the per sensor state */
+    memset(&layout, 0, sizeof(layout));
+    layout.config     = *config;
+    layout.sensor_cnt = sensor_cnt;
+
+    size_t size = psd_align(sizeof(ys_psd_bank_t)) + psd_layout(&layout, NULL) + PSD_ALIGN;
+    uint8_t *block = ys_malloc(size);
+
+    if (block == NULL)
+        return NULL;
+
+    memset(block, 0, size);
+
+    bank  = (ys_psd_bank_t *)block;
+    *bank = layout;
+
+    /* ys_malloc only guarantees the alignment of the bank itself */
+    uintptr_t tables = ((uintptr_t)block + sizeof(ys_psd_bank_t) + PSD_ALIGN - 1) & ~(uintptr_t)(PSD_ALIGN - 1);
+    psd_layout(bank, (uint8_t *)tables);
+
+    psd_init_tables(bank);
+
+    return bank;
+}
+
+void ys_psd_free(ys_psd_bank_t *bank)
+{
+    ys_free(bank);
+}
+
+void ys_psd_add(ys_psd_bank_t *bank, uint16_t sensor, const float accel[3])
+{
+    ys_psd_sensor_t *s = &bank->sensors[sensor];
+    uint32_t pos       = (uint32_t)(s->sample_cnt & (2u * bank->config.fft_size - 1));
+
+    s->ring[X][pos] = accel[X];
+    s->ring[Y][pos] = accel[Y];
+    s->ring[Z][pos] = accel[Z];
+    s->sample_cnt++;
+}
+
+void ys_psd_add_block(ys_psd_bank_t *bank, uint16_t sensor, const ys_vec3_soa_t *accel, uint32_t n)
+{
+    ys_psd_sensor_t *s = &bank->sensors[sensor];
+    uint32_t mask      = 2u * bank->config.fft_size - 1;
+
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        float *ring      = s->ring[axis];
+        const float *src = accel->v[axis];
+        uint64_t cnt     = s->sample_cnt;
+
+        for (uint32_t i = 0; i < n; i++)
+            ring[(uint32_t)(cnt + i) & mask] = src[i];
+    }
+
+    s->sample_cnt += n;
+}
+
+uint32_t ys_psd_process(ys_psd_bank_t *bank)
+{
+    uint32_t n     = bank->config.fft_size;
+    uint32_t hop   = n / 2;
+    uint32_t total = 0;
+
+    for (uint16_t i = 0; i < bank->sensor_cnt; i++)
+    {
+        ys_psd_sensor_t *s = &bank->sensors[i];
+
+        while (s->sample_cnt >= s->next_seg + n)
+        {
+            /* the ring keeps 2n samples, older segments are gone */
+            if (s->sample_cnt - s->next_seg > 2u * n)
+            {
+                uint64_t skip = (s->sample_cnt - 2u * n - s->next_seg + hop - 1) / hop;
+
+                s->overrun_cnt += (uint32_t)skip;
+                s->next_seg += skip * hop;
+                continue;
+            }
+
+            for (uint8_t axis = 0; axis < 3; axis++)
+                psd_segment(bank, s->ring[axis], s->psd[axis], s->next_seg);
+
+            s->next_seg += hop;
+            s->segment_cnt++;
+            total++;
+
+            if (s->segment_cnt >= bank->config.avg_cnt)
+                psd_report(bank, i);
+        }
+    }
+
+    return total;
+}
+
+//-------------------------- internal func ----------------------------------
+
+/* assign the arrays from 'block', or only compute the size when 'block' is NULL */
+static size_t psd_layout(ys_psd_bank_t *bank, uint8_t *block)
+{
+    uint32_t n    = bank->config.fft_size;
+    uint32_t half = n / 2;
+    size_t off    = 0;
+
+#define PSD_TAKE(_ptr, _type, _cnt)                          \
+    do {                                                     \
+        if (block != NULL) (_ptr) = (_type *)(block + off);  \
+        off += psd_align((size_t)(_cnt) * sizeof(_type));    \
+    } while (0)
+
+    PSD_TAKE(bank->window, float, n);
+    PSD_TAKE(bank->tw_re, float, half);
+    PSD_TAKE(bank->tw_im, float, half);
+    PSD_TAKE(bank->post_re, float, half + 1);
+    PSD_TAKE(bank->post_im, float, half + 1);
+    PSD_TAKE(bank->bitrev, uint16_t, half);
+    PSD_TAKE(bank->work_re, float, half);
+    PSD_TAKE(bank->work_im, float, half);
+    PSD_TAKE(bank->sensors, ys_psd_sensor_t, bank->sensor_cnt);
+
+    for (uint16_t i = 0; i < bank->sensor_cnt; i++)
+    {
+        for (uint8_t axis = 0; axis < 3; axis++)
+        {
+            PSD_TAKE(bank->sensors[i].ring[axis], float, 2 * n);
+            PSD_TAKE(bank->sensors[i].psd[axis], float, half + 1);
+        }
+    }
+
+#undef PSD_TAKE
+
+    return off;
+}
+
+static void psd_init_tables(ys_psd_bank_t *bank)
+{
+    uint32_t n    = bank->config.fft_size;
+    uint32_t half = n / 2;
+    double s2     = 0.0;
+    float df      = bank->config.rate / (float)n;
+
+    /* periodic hann window */
+    for (uint32_t i = 0; i < n; i++)
+    {
+        bank->window[i] = (float)(0.5 - 0.5 * cos(2.0 * PSD_PI * i / n));
+        s2 += (double)bank->window[i] * bank->window[i];
+    }
+
+    /* |X|^2 -> psd, one sided doubling is done in the report */
+    bank->scale = (float)(1.0 / ((double)bank->config.rate * s2));
+
+    /* the twiddles of stage 'h' start at h - 1: exp(-i * pi * j / h) */
+    for (uint32_t h = 1; h < half; h <<= 1)
+    {
+        for (uint32_t j = 0; j < h; j++)
+        {
+            bank->tw_re[h - 1 + j] = (float)cos(PSD_PI * j / h);
+            bank->tw_im[h - 1 + j] = (float)-sin(PSD_PI * j / h);
+        }
+    }
+
+    for (uint32_t k = 0; k <= half; k++)
+    {
+        bank->post_re[k] = (float)cos(2.0 * PSD_PI * k / n);
+        bank->post_im[k] = (float)-sin(2.0 * PSD_PI * k / n);
+    }
+
+    bank->log2_half = 0;
+    while ((1u << bank->log2_half) < half)
+        bank->log2_half++;
+
+    for (uint32_t i = 0; i < half; i++)
+    {
+        uint32_t r = 0;
+
+        for (uint8_t b = 0; b < bank->log2_half; b++)
+            r |= ((i >> b) & 1u) << (bank->log2_half - 1 - b);
+
+        bank->bitrev[i] = (uint16_t)r;
+    }
+
+    for (uint8_t b = 0; b < bank->config.band_cnt; b++)
+    {
+        bank->band_bin[b][0] = psd_freq_bin(bank->config.band[b][0] / df, half + 1);
+        bank->band_bin[b][1] = psd_freq_bin(bank->config.band[b][1] / df, half + 1);
+    }
+}
+
+/* first bin at or above 'pos', clamped to [0, bin_cnt] */
+static uint16_t psd_freq_bin(float pos, uint32_t bin_cnt)
+{
+    if (pos <= 0.0f)
+        return 0;
+
+    pos = ceilf(pos);
+
+    return (uint16_t)(pos >= (float)bin_cnt ? bin_cnt : (uint32_t)pos);
+}
+
+static void psd_segment(ys_psd_bank_t *bank, const float *ring, float *psd, uint64_t start)
+{
+    uint32_t n          = bank->config.fft_size;
+    uint32_t half       = n / 2;
+    uint32_t mask       = 2 * n - 1;
+    uint32_t base       = (uint32_t)start & mask; /* even, segments start on multiples of n / 2 */
+    const float *window = bank->window;
+    float *re           = bank->work_re;
+    float *im           = bank->work_im;
+    float mean          = 0.0f;
+
+    /* remove the mean (gravity), it would leak into the lowest bins */
+    for (uint32_t i = 0; i < n; i++)
+        mean += ring[(base + i) & mask];
+
+    mean /= (float)n;
+
+    /* even samples -> real, odd samples -> imag, in bit reversed order */
+    for (uint32_t i = 0; i < half; i++)
+    {
+        uint32_t idx = (base + 2 * i) & mask;
+        uint16_t r   = bank->bitrev[i];
+
+        re[r] = (ring[idx] - mean) * window[2 * i];
+        im[r] = (ring[idx + 1] - mean) * window[2 * i + 1];
+    }
+
+    psd_fft(bank);
+
+    /* split the n / 2 point complex spectrum into the n point real spectrum */
+    for (uint32_t k = 0; k <= half; k++)
+    {
+        uint32_t a = k & (half - 1);
+        uint32_t b = (half - k) & (half - 1);
+
+        /* spectra of the even and the odd samples */
+        float even_r = 0.5f * (re[a] + re[b]);
+        float even_i = 0.5f * (im[a] - im[b]);
+        float odd_r  = 0.5f * (im[a] + im[b]);
+        float odd_i  = -0.5f * (re[a] - re[b]);
+
+        float xr = even_r + odd_r * bank->post_re[k] - odd_i * bank->post_im[k];
+        float xi = even_i + odd_r * bank->post_im[k] + odd_i * bank->post_re[k];
+
+        psd[k] += xr * xr + xi * xi;
+    }
+}
+
+static void psd_fft(ys_psd_bank_t *bank)
+{
+    uint32_t half = bank->config.fft_size / 2;
+    float *re     = bank->work_re;
+    float *im     = bank->work_im;
+
+    for (uint32_t h = 1; h < half; h <<= 1)
+    {
+        const float *wr = &bank->tw_re[h - 1];
+        const float *wi = &bank->tw_im[h - 1];
+
+        for (uint32_t s = 0; s < half; s += 2 * h)
+            psd_butterfly(&re[s], &im[s], &re[s + h], &im[s + h], wr, wi, h);
+    }
+}
+
+static void psd_butterfly(float *ys_restrict ar, float *ys_restrict ai, float *ys_restrict br, float *ys_restrict bi,
+                          const float *ys_restrict wr, const float *ys_restrict wi, uint32_t h)
+{
+    for (uint32_t j = 0; j < h; j++)
+    {
+        float tr = br[j] * wr[j] - bi[j] * wi[j];
+        float ti = br[j] * wi[j] + bi[j] * wr[j];
+
+        br[j] = ar[j] - tr;
+        bi[j] = ai[j] - ti;
+        ar[j] = ar[j] + tr;
+        ai[j] = ai[j] + ti;
+    }
+}
+
+static void psd_report(ys_psd_bank_t *bank, uint16_t index)
+{
+    ys_psd_sensor_t *s = &bank->sensors[index];
+    uint32_t half      = bank->config.fft_size / 2;
+    float df           = bank->config.rate / (float)bank->config.fft_size;
+    float scale        = bank->scale / (float)s->segment_cnt;
+
+    ys_psd_report_t report = {
+        .sensor      = index,
+        .segment_cnt = s->segment_cnt,
+        .bin_cnt     = (uint16_t)(half + 1),
+        .bin_width   = df,
+    };
+
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        float *psd    = s->psd[axis];
+        uint32_t peak = 1;
+
+        /* averaged one sided psd, dc and nyquist are not doubled */
+        psd[0] *= scale;
+        psd[half] *= scale;
+
+        for (uint32_t k = 1; k < half; k++)
+            psd[k] *= 2.0f * scale;
+
+        for (uint8_t b = 0; b < bank->config.band_cnt; b++)
+        {
+            float sum = 0.0f;
+
+            for (uint32_t k = bank->band_bin[b][0]; k < bank->band_bin[b][1]; k++)
+                sum += psd[k];
+
+            report.band_energy[axis][b] = sum * df;
+        }
+
+        for (uint32_t k = 2; k <= half; k++)
+        {
+            if (psd[k] > psd[peak])
+                peak = k;
+        }
+
+        /* parabolic interpolation around the peak bin */
+        float offset = 0.0f;
+
+        if (peak < half)
+        {
+            float l = psd[peak - 1], c = psd[peak], r = psd[peak + 1];
+            float d = l - 2.0f * c + r;
+
+            if (d < 0.0f)
+                offset = 0.5f * (l - r) / d;
+        }
+
+        report.psd[axis]       = psd;
+        report.peak_freq[axis] = ((float)peak + offset) * df;
+        report.peak_psd[axis]  = psd[peak];
+    }
+
+    if (bank->config.callbk != NULL)
+        bank->config.callbk(&report, bank->config.user_data);
+
+    for (uint8_t axis = 0; axis < 3; axis++)
+        memset(s->psd[axis], 0, (half + 1) * sizeof(float));
+
+    s->segment_cnt = 0;
+}
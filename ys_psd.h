@@ -0,0 +1,158 @@
+/**
+ * Yesense 振动频谱（Welch 功率谱密度）
+ *
+ * 为多个传感器的 accel 三轴分别维护重叠的采样窗口，计算加 Hann 窗的实数 FFT，
+ * 按 Welch 方法对若干段的功率谱取平均，周期性地输出频带能量与峰值频率。
+ *
+ * 实现：
+ *  - 内置基 2 FFT，N 点实数序列按 N/2 点复数 FFT 计算，实部 / 虚部分开存放，蝶形运算可向量化
+ *  - 所有传感器共享同一份旋转因子、窗函数与工作缓冲区，逐传感器依次计算，数据常驻缓存
+ *  - 段与段之间重叠 50%
+ *
+ * 用法（单线程）：
+ *  - 在解析回调中调用 ys_psd_add 输入样本（仅复制数据），或对 ys_batch 解码得到的列调用 ys_psd_add_block
+ *  - 在同一线程中，每解析完一批数据后调用 ys_psd_process 计算所有就绪的段，报告通过回调输出
+ *  - 每个传感器在输入 fft_size 个样本内至少要调用一次 ys_psd_process，否则最旧的段会被覆盖（计入 overrun_cnt）
+ *  - 使用多个核时，将传感器分给多个 ys_psd_bank_t，每个线程负责若干传感器的解析以及对应的 bank
+ *
+ * 注意：同一个 ys_psd_bank_t 的所有函数必须由同一个线程调用，内部没有任何同步（sample_cnt 等均为普通变量）。
+ * 解析在中断中进行时，使用延迟解析（ys_parser_input_chunk / ys_parser_poll），在调用 ys_parser_poll 的线程中输入样本
+ *
+ * @author github0null
+ * @version 1.0
+ * @see https://github.com/github0null/
+*/
+
+#ifndef H_YS_PSD
+#define H_YS_PSD
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ys_def.h"
+#include "ys_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 最大 FFT 点数 */
+#ifndef YS_PSD_MAX_FFT
+#define YS_PSD_MAX_FFT 4096
+#endif
+
+/* 最多频带数 */
+#ifndef YS_PSD_MAX_BANDS
+#define YS_PSD_MAX_BANDS 8
+#endif
+
+//////////////////////////////////////////////////////
+//                  Type Define
+//////////////////////////////////////////////////////
+
+/* 频谱报告，所有频率单位为 Hz，功率谱密度单位为 (m/s^2)^2/Hz */
+typedef struct
+{
+    uint16_t sensor;                          /* 传感器索引 */
+    uint16_t segment_cnt;                     /* 参与平均的段数 */
+    uint16_t bin_cnt;                         /* 频点数，fft_size / 2 + 1 */
+    float bin_width;                          /* 频率分辨率 */
+    const float *psd[3];                      /* 平均功率谱密度，仅在回调内有效 */
+    float band_energy[3][YS_PSD_MAX_BANDS];   /* 各频带内的功率，单位：(m/s^2)^2，开方即频带 RMS */
+    float peak_freq[3];                       /* 峰值频率（不含直流），抛物线插值 */
+    float peak_psd[3];                        /* 峰值处的功率谱密度 */
+} ys_psd_report_t;
+
+typedef void (*ys_psd_report_cb_t)(const ys_psd_report_t *report, void *user_data);
+
+typedef struct
+{
+    uint16_t fft_size;                  /* FFT 点数，2 的幂，范围 [16, YS_PSD_MAX_FFT] */
+    uint16_t avg_cnt;                   /* 每次报告平均的段数，报告周期 = avg_cnt * fft_size / 2 / rate */
+    float rate;                         /* 采样率，单位：Hz */
+    uint8_t band_cnt;                   /* 频带数 */
+    float band[YS_PSD_MAX_BANDS][2];    /* 频带 [下限, 上限)，单位：Hz */
+    ys_psd_report_cb_t callbk;          /* 报告回调 */
+    void *user_data;
+} ys_psd_config_t;
+
+/* 单个传感器的状态 */
+typedef struct
+{
+    float *ring[3];       /* 最近 2 * fft_size 个样本 */
+    float *psd[3];        /* 功率谱累加值 */
+    uint64_t sample_cnt;  /* 已输入的样本数 */
+    uint64_t next_seg;    /* 下一段的起始样本序号 */
+    uint16_t segment_cnt; /* 已累加的段数 */
+    uint32_t overrun_cnt; /* 未及时处理而丢弃的段数 */
+} ys_psd_sensor_t;
+
+typedef struct
+{
+    ys_psd_config_t config;
+    uint16_t sensor_cnt;
+    uint8_t log2_half;                       /* log2(fft_size / 2) */
+    uint16_t band_bin[YS_PSD_MAX_BANDS][2];  /* 频带对应的频点范围 [起始, 结束) */
+    float scale;                             /* |X|^2 -> 单边功率谱密度 */
+
+    /* 所有传感器共享 */
+    float *window;                           /* Hann 窗，fft_size 点 */
+    float *tw_re, *tw_im;                    /* 各级蝶形的旋转因子，按级连续存放，共 fft_size / 2 - 1 个 */
+    float *post_re, *post_im;                /* 实数 FFT 后处理旋转因子，fft_size / 2 个 */
+    uint16_t *bitrev;                        /* fft_size / 2 点位反转表 */
+    float *work_re, *work_im;                /* fft_size / 2 点工作缓冲区 */
+
+    ys_psd_sensor_t *sensors;
+} ys_psd_bank_t;
+
+//////////////////////////////////////////////////////
+//                  PSD API
+//////////////////////////////////////////////////////
+
+/**
+ * 创建频谱计算对象（一次性分配所有内存）
+ *
+ * @param config 配置
+ *
+ * @param sensor_cnt 传感器数量
+ *
+ * @return 频谱计算对象，配置无效或内存不足时返回 NULL
+*/
+ys_psd_bank_t *ys_psd_create(const ys_psd_config_t *config, uint16_t sensor_cnt);
+
+/**
+ * 释放频谱计算对象
+*/
+void ys_psd_free(ys_psd_bank_t *bank);
+
+/**
+ * 输入一个 accel 样本
+ *
+ * @param sensor 传感器索引
+ *
+ * @param accel 加速度，单位：m/s^2
+*/
+void ys_psd_add(ys_psd_bank_t *bank, uint16_t sensor, const float accel[3]);
+
+/**
+ * 输入一块 accel 样本，例如 ys_batch 解码得到的 accel 列
+ *
+ * @param sensor 传感器索引
+ *
+ * @param accel 加速度块
+ *
+ * @param n 样本数
+*/
+void ys_psd_add_block(ys_psd_bank_t *bank, uint16_t sensor, const ys_vec3_soa_t *accel, uint32_t n);
+
+/**
+ * 计算所有传感器已就绪的段，达到平均段数时调用报告回调
+ *
+ * @return 本次计算的段数
+*/
+uint32_t ys_psd_process(ys_psd_bank_t *bank);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,528 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L /* ftruncate, msync */
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <ys_recorder.h>
+
+#define YS_RECORDER_MAGIC   0x52465359 /* "YSFR" */
+#define YS_RECORD_MAGIC     0x43525359 /* "YSRC" */
+#define YS_RECORDER_VERSION 3
+
+/* data area starts after the file header */
+#define YS_RECORDER_DATA_OFFSET 64
+
+/* text form of the kernel boot id, "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx" */
+#define YS_RECORDER_BOOT_ID_LEN 36
+
+#define record_size(_len) ((((uint32_t)sizeof(ys_record_header_t) + (_len)) + 7u) & ~7u)
+
+#if defined(__GNUC__)
+#define record_commit(_ptr, _val) __atomic_store_n((_ptr), (_val), __ATOMIC_RELEASE)
+#define record_barrier()          __atomic_signal_fence(__ATOMIC_SEQ_CST)
+#else
+#define record_commit(_ptr, _val) (*(volatile uint32_t *)(_ptr) = (_val))
+#define record_barrier()
+#endif
+
+//-------------------------- type define  -----------------------------------
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t header_size; /* sizeof(ys_record_header_t), guards against layout mismatch */
+    uint16_t port;
+    uint16_t reserved;
+    char boot_id[YS_RECORDER_BOOT_ID_LEN]; /* boot of the last writer, all 0 when unknown */
+} ys_recorder_file_header_t;
+
+//-------------------------- internal func ----------------------------------
+
+static uint32_t record_check(const ys_record_header_t *hdr);
+
+static uint32_t record_data_check(const uint8_t *data, uint32_t len);
+
+static bool record_data_ok(const ys_record_header_t *hdr);
+
+static bool record_boot_id(char id[YS_RECORDER_BOOT_ID_LEN]);
+
+static bool record_same_boot(const ys_recorder_file_header_t *header);
+
+static const ys_record_header_t *record_at(const uint8_t *data, uint32_t capacity, uint32_t off);
+
+static const ys_record_header_t *record_find_last(const uint8_t *data, uint32_t capacity, uint32_t *off);
+
+static uint64_t record_find_first(const uint8_t *data, uint32_t capacity, uint32_t last_off, uint32_t *first_off);
+
+static const ys_record_header_t *record_next(const uint8_t *data, uint32_t capacity, const ys_record_header_t *hdr, uint32_t *off);
+
+static void record_truncate(ys_recorder_t *rec);
+
+//---------------------------------------------------------------------------
+
+ys_recorder_t *ys_recorder_open(const char *path, uint32_t capacity, uint16_t port)
+{
+    struct stat st;
+    ys_recorder_file_header_t *header;
+    ys_recorder_t *rec = ys_malloc(sizeof(ys_recorder_t));
+
+    if (rec == NULL)
+        return NULL;
+
+    memset(rec, 0, sizeof(ys_recorder_t));
+
+    capacity &= ~7u;
+
+    rec->fd = open(path, O_RDWR | O_CREAT, 0644);
+
+    if (rec->fd < 0 || fstat(rec->fd, &st) != 0 || capacity < record_size(1))
+        goto failed;
+
+    rec->map_size = (size_t)YS_RECORDER_DATA_OFFSET + capacity;
+
+    /* new file, a truncated file is zero filled, so there is no valid record yet */
+    if (st.st_size == 0 && ftruncate(rec->fd, (off_t)rec->map_size) != 0)
+        goto failed;
+
+    if (st.st_size != 0 && (size_t)st.st_size != rec->map_size)
+        goto failed;
+
+    rec->map = mmap(NULL, rec->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, rec->fd, 0);
+
+    if (rec->map == MAP_FAILED)
+    {
+        rec->map = NULL;
+        goto failed;
+    }
+
+    header        = (ys_recorder_file_header_t *)rec->map;
+    rec->data     = rec->map + YS_RECORDER_DATA_OFFSET;
+    rec->capacity = capacity;
+    rec->port     = port;
+
+    if (st.st_size == 0)
+    {
+        header->version     = YS_RECORDER_VERSION;
+        header->capacity    = capacity;
+        header->header_size = sizeof(ys_record_header_t);
+        header->port        = port;
+        record_commit(&header->magic, YS_RECORDER_MAGIC);
+    }
+    else
+    {
+        if (header->magic != YS_RECORDER_MAGIC ||
+            header->version != YS_RECORDER_VERSION ||
+            header->capacity != capacity ||
+            header->header_size != sizeof(ys_record_header_t))
+        {
+            goto failed;
+        }
+
+        /* continue after the newest record */
+        const ys_record_header_t *last = record_find_last(rec->data, capacity, &rec->last_off);
+
+        if (last != NULL)
+        {
+            rec->seq = last->seq;
+            rec->pos = rec->last_off + record_size(last->len);
+
+            /* the page cache survived a process crash, only a reboot can lose pages */
+            if (!record_same_boot(header))
+                record_truncate(rec);
+        }
+    }
+
+    if (!record_boot_id(header->boot_id))
+        memset(header->boot_id, 0, sizeof(header->boot_id));
+
+    return rec;
+
+failed:
+    ys_recorder_close(rec);
+    return NULL;
+}
+
+void ys_recorder_close(ys_recorder_t *rec)
+{
+    if (rec == NULL)
+        return;
+
+    if (rec->map != NULL)
+        munmap(rec->map, rec->map_size);
+
+    if (rec->fd >= 0)
+        close(rec->fd);
+
+    ys_free(rec);
+}
+
+int ys_recorder_append(ys_recorder_t *rec, const uint8_t *data, uint32_t len, uint64_t timestamp)
+{
+    uint32_t size = record_size(len);
+
+    if (len > rec->capacity || size > rec->capacity)
+        return -1;
+
+    /* records never wrap, the tail gap is skipped */
+    if (rec->pos + size > rec->capacity)
+        rec->pos = 0;
+
+    ys_record_header_t *hdr = (ys_record_header_t *)(rec->data + rec->pos);
+
+    /* invalidate the old record first, then fill, then commit */
+    hdr->check = 0;
+    record_barrier();
+
+    hdr->magic      = YS_RECORD_MAGIC;
+    hdr->len        = len;
+    hdr->seq        = rec->seq + 1;
+    hdr->timestamp  = timestamp;
+    hdr->prev_off   = rec->last_off;
+    hdr->data_check = 0; /* filled in by ys_recorder_sync */
+    hdr->reserved   = 0;
+    memcpy(hdr + 1, data, len);
+
+    record_commit(&hdr->check, record_check(hdr));
+
+    rec->seq++;
+    rec->last_off = rec->pos;
+    rec->pos += size;
+
+    return 0;
+}
+
+int ys_recorder_sync(ys_recorder_t *rec)
+{
+    ys_record_header_t *hdr = NULL;
+
+    if (rec->seq != 0)
+        hdr = (ys_record_header_t *)record_at(rec->data, rec->capacity, rec->last_off);
+
+    /* check the data of the records appended since the last sync, newest first, before they are written back */
+    while (hdr != NULL && hdr->data_check == 0)
+    {
+        ys_record_header_t *prev = NULL;
+
+        record_commit(&hdr->data_check, record_data_check((const uint8_t *)(hdr + 1), hdr->len));
+
+        if (hdr->seq > 1)
+            prev = (ys_record_header_t *)record_at(rec->data, rec->capacity, hdr->prev_off);
+
+        hdr = prev != NULL && prev->seq == hdr->seq - 1 ? prev : NULL;
+    }
+
+    return msync(rec->map, rec->map_size, MS_SYNC) == 0 ? 0 : -1;
+}
+
+int64_t ys_recorder_dump(const char *path, ys_recorder_dump_t callbk, void *user_data)
+{
+    return ys_recorder_dump_ex(path, callbk, user_data, NULL);
+}
+
+int64_t ys_recorder_dump_ex(const char *path, ys_recorder_dump_t callbk, void *user_data, uint64_t *dropped)
+{
+    struct stat st;
+    int64_t cnt = -1;
+    uint8_t *map;
+
+    int fd = open(path, O_RDONLY);
+
+    if (dropped != NULL)
+        *dropped = 0;
+
+    if (fd < 0)
+        return -1;
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < YS_RECORDER_DATA_OFFSET)
+    {
+        close(fd);
+        return -1;
+    }
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+        return -1;
+
+    const ys_recorder_file_header_t *header = (const ys_recorder_file_header_t *)map;
+    const uint8_t *data                     = map + YS_RECORDER_DATA_OFFSET;
+
+    if (header->magic != YS_RECORDER_MAGIC ||
+        header->version != YS_RECORDER_VERSION ||
+        header->header_size != sizeof(ys_record_header_t) ||
+        (size_t)header->capacity + YS_RECORDER_DATA_OFFSET != (size_t)st.st_size)
+    {
+        goto end;
+    }
+
+    uint32_t capacity = header->capacity;
+    bool verify       = !record_same_boot(header);
+    uint32_t off;
+
+    cnt = 0;
+
+    if (record_find_last(data, capacity, &off) == NULL)
+        goto end;
+
+    uint64_t total = record_find_first(data, capacity, off, &off);
+
+    /* walk forward, after a reboot stop at the first record whose data may not have reached the disk */
+    for (const ys_record_header_t *hdr = record_at(data, capacity, off); hdr != NULL;)
+    {
+        if (verify && !record_data_ok(hdr))
+        {
+            if (dropped != NULL)
+                *dropped = total - (uint64_t)cnt;
+            break;
+        }
+
+        ys_record_info_t info = {
+            .seq       = hdr->seq,
+            .timestamp = hdr->timestamp,
+            .len       = hdr->len,
+            .port      = header->port,
+        };
+
+        callbk(&info, (const uint8_t *)(hdr + 1), user_data);
+
+        if ((uint64_t)++cnt >= total)
+            break;
+
+        hdr = record_next(data, capacity, hdr, &off);
+    }
+
+end:
+    munmap(map, (size_t)st.st_size);
+    return cnt;
+}
+
+//-------------------------- internal func ----------------------------------
+
+static uint32_t record_check(const ys_record_header_t *hdr)
+{
+    uint32_t h = YS_RECORD_MAGIC ^ hdr->magic;
+
+    h ^= hdr->len * 0x9E3779B1u;
+    h = (h << 13 | h >> 19) ^ (uint32_t)hdr->seq ^ (uint32_t)(hdr->seq >> 32) * 0x85EBCA77u;
+    h = (h << 13 | h >> 19) ^ (uint32_t)hdr->timestamp ^ (uint32_t)(hdr->timestamp >> 32) * 0xC2B2AE3Du;
+    h = (h << 13 | h >> 19) ^ hdr->prev_off * 0x27D4EB2Fu;
+
+    /* fmix32 */
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+
+    return h | 1u; /* never 0, 0 marks a record being written */
+}
+
+/* murmur3 over the record data, in native byte order like the rest of the file */
+static uint32_t record_data_check(const uint8_t *data, uint32_t len)
+{
+    uint32_t h = YS_RECORD_MAGIC ^ len;
+    uint32_t k = 0;
+    uint32_t i = 0;
+
+    for (; i + 4 <= len; i += 4)
+    {
+        memcpy(&k, data + i, sizeof(k));
+
+        k *= 0xCC9E2D51u;
+        k = k << 15 | k >> 17;
+        k *= 0x1B873593u;
+
+        h ^= k;
+        h = h << 13 | h >> 19;
+        h = h * 5 + 0xE6546B64u;
+    }
+
+    k = 0;
+
+    for (uint32_t shift = 0; i < len; i++, shift += 8)
+    {
+        k |= (uint32_t)data[i] << shift;
+    }
+
+    k *= 0xCC9E2D51u;
+    k = k << 15 | k >> 17;
+    k *= 0x1B873593u;
+    h ^= k;
+
+    /* fmix32 */
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+
+    return h | 1u; /* never 0, 0 marks a record not synced yet */
+}
+
+/* data check stored by ys_recorder_sync, records appended after the last sync have none */
+static bool record_data_ok(const ys_record_header_t *hdr)
+{
+    return hdr->data_check != 0 && hdr->data_check == record_data_check((const uint8_t *)(hdr + 1), hdr->len);
+}
+
+/* linux only, elsewhere the boot is unknown and every recovery is treated as after a reboot */
+static bool record_boot_id(char id[YS_RECORDER_BOOT_ID_LEN])
+{
+    int fd = open("/proc/sys/kernel/random/boot_id", O_RDONLY);
+    ssize_t n;
+
+    if (fd < 0)
+        return false;
+
+    n = read(fd, id, YS_RECORDER_BOOT_ID_LEN);
+    close(fd);
+
+    return n == YS_RECORDER_BOOT_ID_LEN;
+}
+
+static bool record_same_boot(const ys_recorder_file_header_t *header)
+{
+    char id[YS_RECORDER_BOOT_ID_LEN];
+
+    return record_boot_id(id) && memcmp(id, header->boot_id, sizeof(id)) == 0;
+}
+
+static const ys_record_header_t *record_at(const uint8_t *data, uint32_t capacity, uint32_t off)
+{
+    if ((off & 7u) != 0 || (uint64_t)off + sizeof(ys_record_header_t) > capacity)
+        return NULL;
+
+    const ys_record_header_t *hdr = (const ys_record_header_t *)(data + off);
+
+    if (hdr->magic != YS_RECORD_MAGIC ||
+        hdr->seq == 0 ||
+        hdr->len > capacity ||
+        (uint64_t)off + record_size(hdr->len) > capacity ||
+        hdr->check != record_check(hdr))
+    {
+        return NULL;
+    }
+
+    return hdr;
+}
+
+static const ys_record_header_t *record_find_last(const uint8_t *data, uint32_t capacity, uint32_t *off)
+{
+    const ys_record_header_t *last = NULL;
+
+    for (uint32_t pos = 0; pos + sizeof(ys_record_header_t) <= capacity; pos += 8)
+    {
+        const ys_record_header_t *hdr = record_at(data, capacity, pos);
+
+        if (hdr != NULL && (last == NULL || hdr->seq > last->seq))
+        {
+            last = hdr;
+            *off = pos;
+        }
+    }
+
+    return last;
+}
+
+static uint64_t record_find_first(const uint8_t *data, uint32_t capacity, uint32_t last_off, uint32_t *first_off)
+{
+    const ys_record_header_t *hdr = record_at(data, capacity, last_off);
+    uint32_t off                  = last_off;
+    uint64_t span                 = record_size(hdr->len); /* bytes from 'off' to the end of the newest record */
+    uint64_t cnt                  = 1;
+
+    while (hdr->seq > 1)
+    {
+        uint32_t prev_off              = hdr->prev_off;
+        const ys_record_header_t *prev = record_at(data, capacity, prev_off);
+        uint32_t prev_size;
+
+        if (prev == NULL || prev->seq != hdr->seq - 1)
+            break; /* overwritten */
+
+        prev_size = record_size(prev->len);
+
+        /* contiguous, or wrapped to the start of the data area */
+        if (prev_off + prev_size == off)
+            span += prev_size;
+        else if (off == 0 && prev_off + prev_size <= capacity)
+            span += capacity - prev_off;
+        else
+            break;
+
+        /* never go around the ring more than once */
+        if (span > capacity)
+            break;
+
+        hdr = prev;
+        off = prev_off;
+        cnt++;
+    }
+
+    *first_off = off;
+    return cnt;
+}
+
+/* the record after 'hdr' is either right after it or at the start of the data area, 'off' follows it */
+static const ys_record_header_t *record_next(const uint8_t *data, uint32_t capacity, const ys_record_header_t *hdr, uint32_t *off)
+{
+    const ys_record_header_t *next = record_at(data, capacity, *off + record_size(hdr->len));
+
+    if (next != NULL && next->seq == hdr->seq + 1)
+    {
+        *off += record_size(hdr->len);
+        return next;
+    }
+
+    next = record_at(data, capacity, 0);
+
+    if (next == NULL || next->seq != hdr->seq + 1)
+        return NULL;
+
+    *off = 0;
+    return next;
+}
+
+/*
+ * after a reboot, check the data from the oldest record on, the first record that was not synced
+ * or does not match and all records after it are invalidated, the writer continues there
+ */
+static void record_truncate(ys_recorder_t *rec)
+{
+    uint32_t off;
+    uint64_t total = record_find_first(rec->data, rec->capacity, rec->last_off, &off);
+    ys_record_header_t *hdr = (ys_record_header_t *)record_at(rec->data, rec->capacity, off);
+
+    for (uint64_t i = 0; i < total && hdr != NULL; i++)
+    {
+        if (!record_data_ok(hdr))
+        {
+            /* seq keeps counting, older copies of the dropped numbers may still be in the ring */
+            rec->seq      = hdr->seq - 1;
+            rec->last_off = hdr->prev_off;
+            rec->pos      = off;
+
+            for (; i < total && hdr != NULL; i++)
+            {
+                ys_record_header_t *next = (ys_record_header_t *)record_next(rec->data, rec->capacity, hdr, &off);
+
+                record_commit(&hdr->check, 0);
+                hdr = next;
+            }
+
+            return;
+        }
+
+        hdr = (ys_record_header_t *)record_next(rec->data, rec->capacity, hdr, &off);
+    }
+}
@@ -0,0 +1,165 @@
+/**
+ * Yesense 原始数据飞行记录器（POSIX）
+ *
+ * 将串口收到的原始数据块连同接收时间戳追加到一个固定大小、内存映射的环形文件中，
+ * 写满后覆盖最旧的记录，始终保留最近一段时间的原始数据。
+ *
+ * 写入路径上每个数据块只有一次 memcpy 与少量整数运算，没有系统调用。
+ *
+ * 崩溃一致性：
+ *  - 每条记录的记录头包含序号、长度、时间戳、上一条记录的偏移以及记录头校验值，记录头校验值最后写入
+ *  - 数据校验值不在写入路径上计算，由 @ref ys_recorder_sync 在刷盘前为上次同步之后追加的记录补齐
+ *  - 文件头中保存最近一次打开该文件时的系统启动 ID（Linux 的 boot_id）
+ *  - 进程崩溃时，已写入的数据保存在内核页缓存中，恢复时启动 ID 相同，所有记录头校验通过的记录均可恢复
+ *  - 掉电时，只有最近一次 @ref ys_recorder_sync 之前的记录保证完整；内核可能以任意顺序写回各页，
+ *    因此系统重启后（启动 ID 不同或无法获取）从最旧的记录向后逐条校验数据，
+ *    在第一条未同步（没有数据校验值）或数据校验不通过的记录处截断，该记录及其后的记录均被丢弃
+ *  - 恢复时从最新的记录出发，沿 prev_off 向前追溯，最多追溯一个文件容量
+ *
+ * 注意：
+ *  - 一个记录器对应一个端口（一路传感器），同一记录器只能由一个线程写入
+ *  - 文件使用本机字节序
+ *
+ * @author github0null
+ * @version 1.0
+ * @see https://github.com/github0null/
+*/
+
+#ifndef H_YS_RECORDER
+#define H_YS_RECORDER
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ys_def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////
+//                  Type Define
+//////////////////////////////////////////////////////
+
+/* 记录头，位于数据区内，8 字节对齐 */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t len;       /* 数据长度（字节） */
+    uint64_t seq;       /* 记录序号，从 1 开始连续递增 */
+    uint64_t timestamp; /* 接收时间戳，单位由调用者决定 */
+    uint32_t prev_off;   /* 上一条记录在数据区中的偏移 */
+    uint32_t data_check; /* 数据校验值，由 ys_recorder_sync 写入，0 表示尚未同步 */
+    uint32_t reserved;   /* 为 0 */
+    uint32_t check;      /* 记录头校验值（不含 data_check），最后写入 */
+} ys_record_header_t;
+
+typedef struct
+{
+    int fd;
+    uint8_t *map;      /* 整个文件的映射 */
+    size_t map_size;
+    uint8_t *data;     /* 数据区 */
+    uint32_t capacity; /* 数据区大小（字节） */
+    uint32_t pos;      /* 下一条记录的写入偏移 */
+    uint32_t last_off; /* 最新一条记录的偏移 */
+    uint64_t seq;      /* 最新一条记录的序号，0 表示没有记录 */
+    uint16_t port;
+} ys_recorder_t;
+
+/* 导出回调中的记录信息 */
+typedef struct
+{
+    uint64_t seq;
+    uint64_t timestamp;
+    uint32_t len;
+    uint16_t port;
+} ys_record_info_t;
+
+/**
+ * 导出回调
+ *
+ * @param info 记录信息
+ *
+ * @param data 记录数据（指向文件映射内部，仅在回调内有效）
+ *
+ * @param user_data 用户数据
+*/
+typedef void (*ys_recorder_dump_t)(const ys_record_info_t *info, const uint8_t *data, void *user_data);
+
+//////////////////////////////////////////////////////
+//                  Recorder API
+//////////////////////////////////////////////////////
+
+/**
+ * 打开或创建记录文件
+ *
+ * 文件不存在或为空时，按 capacity 创建；文件已存在时，恢复其中的记录并在最新记录之后继续写入。
+ * 若文件上次写入之后系统重启过，第一条未同步或数据校验不通过的记录及其后的记录被标记为无效，从该记录处继续写入。
+ *
+ * @param path 文件路径
+ *
+ * @param capacity 数据区大小（字节），向下对齐到 8 字节
+ *
+ * @param port 端口号，保存在文件头中
+ *
+ * @return 记录器对象，失败或已存在的文件容量不一致时返回 NULL
+*/
+ys_recorder_t *ys_recorder_open(const char *path, uint32_t capacity, uint16_t port);
+
+/**
+ * 关闭记录器，解除映射（不会主动刷盘）
+*/
+void ys_recorder_close(ys_recorder_t *rec);
+
+/**
+ * 追加一个数据块
+ *
+ * @param rec 记录器对象
+ *
+ * @param data 原始数据
+ *
+ * @param len 数据长度
+ *
+ * @param timestamp 接收时间戳
+ *
+ * @return 成功返回 0，数据块大于文件容量时返回 -1
+*/
+int ys_recorder_append(ys_recorder_t *rec, const uint8_t *data, uint32_t len, uint64_t timestamp);
+
+/**
+ * 为上次同步之后追加的记录计算数据校验值，然后将已写入的记录同步到磁盘（msync）
+ *
+ * 会阻塞直到数据落盘，应周期调用（例如每秒一次）；需与 @ref ys_recorder_append 在同一线程中调用
+ *
+ * @return 成功返回 0，失败返回 -1
+*/
+int ys_recorder_sync(ys_recorder_t *rec);
+
+/**
+ * 从记录文件中恢复所有有效记录，按从旧到新的顺序调用回调函数
+ *
+ * 依次拼接所有记录的数据即可得到原始数据流，可直接交给 ys_parse_buf 重放。
+ * 若文件上次写入之后系统重启过，在第一条未同步或数据校验不通过的记录处截断，该记录及其后的记录不会导出。
+ *
+ * @param path 文件路径
+ *
+ * @param callbk 导出回调
+ *
+ * @param user_data 用户数据
+ *
+ * @return 恢复的记录数，文件无效时返回 -1
+*/
+int64_t ys_recorder_dump(const char *path, ys_recorder_dump_t callbk, void *user_data);
+
+/**
+ * 同 @ref ys_recorder_dump，并给出被截断的记录数
+ *
+ * @param dropped 输出（可为 NULL），重启后因未同步或数据校验不通过而未导出的记录数（从第一条不通过的记录到最新的记录）
+*/
+int64_t ys_recorder_dump_ex(const char *path, ys_recorder_dump_t callbk, void *user_data, uint64_t *dropped);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,143 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <ys_strapdown.h>
+
+//-------------------------- internal func ----------------------------------
+
+static void rotate_double(const float q[4], const double v[3], double out[3]);
+
+ys_static_inline void strapdown_step(ys_strapdown_t *sd, const float quat_inc[4], const float speed_inc[3]);
+
+//---------------------------------------------------------------------------
+
+void ys_strapdown_init(ys_strapdown_t *sd, const float init_quat[4], float dt)
+{
+    memset(sd, 0, sizeof(ys_strapdown_t));
+
+    if (init_quat != NULL)
+    {
+        memcpy(sd->state.quaternion, init_quat, sizeof(sd->state.quaternion));
+        ys_quat_normalize(sd->state.quaternion);
+    }
+    else
+    {
+        sd->state.quaternion[0] = 1.0f;
+    }
+
+    sd->dt            = dt;
+    sd->gravity       = YS_GRAVITY;
+    sd->norm_interval = YS_STRAPDOWN_NORM_INTERVAL;
+}
+
+void ys_strapdown_update(ys_strapdown_t *sd, const float quat_inc[4], const float speed_inc[3])
+{
+    strapdown_step(sd, quat_inc, speed_inc);
+}
+
+void ys_strapdown_update_from_result(ys_strapdown_t *sd, const ys_sensor_data_t *result)
+{
+    strapdown_step(sd, result->quaternion_inc, result->speed_inc);
+}
+
+void ys_strapdown_update_batch(ys_strapdown_t *sd, const ys_quat_soa_t *quat_inc, const ys_vec3_soa_t *speed_inc, uint32_t n)
+{
+    float dq[4], dv[3];
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        dq[0] = quat_inc->q[0][i];
+        dq[1] = quat_inc->q[1][i];
+        dq[2] = quat_inc->q[2][i];
+        dq[3] = quat_inc->q[3][i];
+
+        dv[X] = speed_inc->v[X][i];
+        dv[Y] = speed_inc->v[Y][i];
+        dv[Z] = speed_inc->v[Z][i];
+
+        strapdown_step(sd, dq, dv);
+    }
+}
+
+void ys_strapdown_save(const ys_strapdown_t *sd, ys_strapdown_state_t *checkpoint)
+{
+    memcpy(checkpoint, &sd->state, sizeof(ys_strapdown_state_t));
+}
+
+void ys_strapdown_restore(ys_strapdown_t *sd, const ys_strapdown_state_t *checkpoint)
+{
+    memcpy(&sd->state, checkpoint, sizeof(ys_strapdown_state_t));
+}
+
+void ys_strapdown_merge(const ys_strapdown_state_t *head, const ys_strapdown_state_t *tail_local,
+                        float dt, float gravity, ys_strapdown_state_t *out)
+{
+    double span = (double)tail_local->sample_cnt * dt;
+    double dv[3], dp[3];
+    ys_strapdown_state_t res;
+
+    /* bring the tail segment from its start body frame into E,N,U */
+    rotate_double(head->quaternion, tail_local->velocity, dv);
+    rotate_double(head->quaternion, tail_local->position, dp);
+
+    for (int i = 0; i < 3; i++)
+    {
+        res.velocity[i] = head->velocity[i] + dv[i];
+        res.position[i] = head->position[i] + head->velocity[i] * span + dp[i];
+    }
+
+    /* gravity is linear in time, so it can be applied to the whole segment at once */
+    res.velocity[U] -= gravity * span;
+    res.position[U] -= 0.5 * gravity * span * span;
+
+    ys_quat_mul(head->quaternion, tail_local->quaternion, res.quaternion);
+    ys_quat_normalize(res.quaternion);
+
+    res.sample_cnt = head->sample_cnt + tail_local->sample_cnt;
+    res.norm_cnt   = 0;
+
+    memcpy(out, &res, sizeof(ys_strapdown_state_t));
+}
+
+//-------------------------- internal func ----------------------------------
+
+ys_static_inline void strapdown_step(ys_strapdown_t *sd, const float quat_inc[4], const float speed_inc[3])
+{
+    ys_strapdown_state_t *st = &sd->state;
+    float dv[3];
+
+    /* velocity increment is expressed in the body frame at the start of the interval */
+    ys_quat_rotate(st->quaternion, speed_inc, dv);
+    dv[U] -= sd->gravity * sd->dt;
+
+    /* trapezoidal position update */
+    for (int i = 0; i < 3; i++)
+    {
+        double v_prev = st->velocity[i];
+        st->velocity[i] += dv[i];
+        st->position[i] += 0.5 * (v_prev + st->velocity[i]) * sd->dt;
+    }
+
+    ys_quat_mul(st->quaternion, quat_inc, st->quaternion);
+
+    if (++st->norm_cnt >= sd->norm_interval)
+    {
+        ys_quat_normalize(st->quaternion);
+        st->norm_cnt = 0;
+    }
+
+    st->sample_cnt++;
+}
+
+static void rotate_double(const float q[4], const double v[3], double out[3])
+{
+    double w = q[0], x = q[1], y = q[2], z = q[3];
+
+    double tx = 2.0 * (y * v[Z] - z * v[Y]);
+    double ty = 2.0 * (z * v[X] - x * v[Z]);
+    double tz = 2.0 * (x * v[Y] - y * v[X]);
+
+    out[X] = v[X] + w * tx + (y * tz - z * ty);
+    out[Y] = v[Y] + w * ty + (z * tx - x * tz);
+    out[Z] = v[Z] + w * tz + (x * ty - y * tx);
+}
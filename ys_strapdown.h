@@ -0,0 +1,135 @@
+/**
+ * Yesense 增量捷联积分
+ *
+ * 使用 quaternion_inc（方位增量）与 speed_inc（速度增量）在全输出速率下递推姿态、速度与位置。
+ * 每个样本 O(1) 计算量，不分配内存，四元数每 norm_interval 个样本归一化一次。
+ *
+ * 约定：
+ *  - 姿态四元数表示载体坐标系到站心坐标系（E,N,U）的旋转，分量顺序同 ys_sensor_data_t.quaternion
+ *  - quaternion_inc 为载体坐标系下相邻两个样本间的姿态增量
+ *  - speed_inc 为载体坐标系下相邻两个样本间的速度增量（比力积分，包含重力反作用）
+ *  - 速度与位置使用站心坐标系，索引见 IMU_ENU_AXIS，位置为相对积分起点的偏移，单位 m
+ *
+ * @author github0null
+ * @version 1.0
+ * @see https://github.com/github0null/
+*/
+
+#ifndef H_YS_STRAPDOWN
+#define H_YS_STRAPDOWN
+
+#include <stdint.h>
+#include "ys_def.h"
+#include "ys_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 四元数归一化间隔（样本数） */
+#ifndef YS_STRAPDOWN_NORM_INTERVAL
+#define YS_STRAPDOWN_NORM_INTERVAL 64
+#endif
+
+//////////////////////////////////////////////////////
+//                  Type Define
+//////////////////////////////////////////////////////
+
+/* 积分器状态，可直接拷贝，用于保存 / 恢复检查点 */
+typedef struct
+{
+    float quaternion[4]; /* 姿态 */
+    double velocity[3];  /* 速度，单位：m/s */
+    double position[3];  /* 位置，单位：m */
+    uint32_t sample_cnt; /* 已积分样本数 */
+    uint16_t norm_cnt;   /* 距上次归一化的样本数 */
+} ys_strapdown_state_t;
+
+typedef struct
+{
+    ys_strapdown_state_t state;
+    float dt;               /* 采样周期，单位：s */
+    float gravity;          /* 重力加速度，为 0 时不做重力补偿 */
+    uint16_t norm_interval; /* 四元数归一化间隔 */
+} ys_strapdown_t;
+
+//////////////////////////////////////////////////////
+//                  Strapdown API
+//////////////////////////////////////////////////////
+
+/**
+ * 初始化积分器，速度与位置清零，重力加速度默认为 YS_GRAVITY。
+ *
+ * @param sd 积分器对象
+ *
+ * @param init_quat 初始姿态，为 NULL 时使用单位四元数
+ *
+ * @param dt 采样周期，单位：s
+*/
+void ys_strapdown_init(ys_strapdown_t *sd, const float init_quat[4], float dt);
+
+/**
+ * 积分一个样本
+ *
+ * @param sd 积分器对象
+ *
+ * @param quat_inc 姿态增量
+ *
+ * @param speed_inc 速度增量，单位：m/s
+*/
+void ys_strapdown_update(ys_strapdown_t *sd, const float quat_inc[4], const float speed_inc[3]);
+
+/**
+ * 使用解析器输出积分一个样本，可直接在结果回调中调用
+ *
+ * 调用前应确认 field_li 中包含 YS_ID_QUATERNION_INCREMENT 与 YS_ID_SPEED_INCREMENT
+*/
+void ys_strapdown_update_from_result(ys_strapdown_t *sd, const ys_sensor_data_t *result);
+
+/**
+ * 按顺序积分一个样本块（回放模式）
+ *
+ * @param sd 积分器对象
+ *
+ * @param quat_inc 姿态增量块
+ *
+ * @param speed_inc 速度增量块
+ *
+ * @param n 样本数
+*/
+void ys_strapdown_update_batch(ys_strapdown_t *sd, const ys_quat_soa_t *quat_inc, const ys_vec3_soa_t *speed_inc, uint32_t n);
+
+/**
+ * 保存积分器状态（检查点）
+*/
+void ys_strapdown_save(const ys_strapdown_t *sd, ys_strapdown_state_t *checkpoint);
+
+/**
+ * 从检查点恢复积分器状态
+*/
+void ys_strapdown_restore(ys_strapdown_t *sd, const ys_strapdown_state_t *checkpoint);
+
+/**
+ * 拼接两段独立积分的结果，用于将长回放拆分后并行积分。
+ *
+ * 后一段需以单位四元数、零速度、零位置且 gravity = 0 开始积分（即在其起始载体坐标系下积分），
+ * 拼接时再统一旋转到前一段末尾的姿态下并补偿重力，结果与整段顺序积分一致（仅有舍入误差）。
+ *
+ * @param head 前一段积分结束时的状态
+ *
+ * @param tail_local 后一段在其起始载体坐标系下的积分结果
+ *
+ * @param dt 采样周期，单位：s
+ *
+ * @param gravity 重力加速度，为 0 时不做重力补偿
+ *
+ * @param out 拼接后的状态，可与 head 相同
+*/
+void ys_strapdown_merge(const ys_strapdown_state_t *head, const ys_strapdown_state_t *tail_local,
+                        float dt, float gravity, ys_strapdown_state_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif